@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cycles.h"
+#include "anim.h"
+
+/**
+ * Decode an animation file on the host with the firmware's decoder, the file memory-mapped just as
+ * the flash partition is on the device. Reports the decode time per frame.
+ *
+ * Usage: anim_play file.txa [loops] [--show]
+ */
+
+static void show(const anim_t* anim)
+{
+    printf("frame %d (%d ms)\n", anim->frame_index - 1, anim->duration_ms);
+    for (int y = 0; y < DISPLAY_HEIGHT; y ++) {
+        for (int x = 0; x < DISPLAY_WIDTH; x ++) {
+            uint8_t pwm = anim->frame[x * DISPLAY_HEIGHT + y];
+            putchar(pwm > 0x80 ? '#' : pwm ? '+' : '.');
+        }
+        putchar('\n');
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s file.txa [loops] [--show]\n", argv[0]);
+        return 1;
+    }
+
+    int loops = argc > 2 ? atoi(argv[2]) : 100;
+    bool show_frames = argc > 3 && strcmp(argv[3], "--show") == 0;
+
+    int fd = open(argv[1], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    const uint8_t* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    anim_t anim;
+    if (anim_open(&anim, data, st.st_size) != 0) {
+        fprintf(stderr, "%s: not a valid animation\n", argv[1]);
+        return 1;
+    }
+
+    uint32_t frames = anim.header->frame_count * loops;
+    uint32_t total = 0;
+    uint32_t worst = 0;
+
+    for (uint32_t idx = 0; idx < frames; idx ++) {
+        uint32_t start = cycles_now();
+        if (!anim_next(&anim)) {
+            fprintf(stderr, "frame %d is corrupt\n", anim.frame_index);
+            return 1;
+        }
+        uint32_t elapsed = cycles_now() - start;
+
+        total += elapsed;
+        worst = elapsed > worst ? elapsed : worst;
+
+        if (show_frames && idx < anim.header->frame_count) {
+            show(&anim);
+        }
+    }
+
+    printf(
+        "%d frames, %u bytes: decode %u " CYCLES_UNIT "/frame average, %u worst\n",
+        anim.header->frame_count, anim.header->data_length, total / frames, worst
+    );
+
+    munmap((void*)data, st.st_size);
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "display.h"
+#include "frame_buffer.h"
+#include "bench.h"
+
+/**
+ * Host benchmark runner.
+ *
+ * Usage: bench [stage|all] [iterations] [frames.bin]
+ *
+ * frames.bin is an optional sequence of packed frames (see display_load_pwm()) used as the
+ * display_update input, e.g. as written by `tools/i2c_trace.py frames`.
+ */
+
+/**
+ * Read a whole frames file, returning the number of frames in it.
+ */
+static unsigned int load_frames(const char* path, uint8_t** frames)
+{
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        exit(1);
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    unsigned int count = size / DISPLAY_PIXELS;
+    *frames = malloc(count * DISPLAY_PIXELS + 1);
+    if (fread(*frames, DISPLAY_PIXELS, count, f) != count) {
+        perror(path);
+        exit(1);
+    }
+
+    fclose(f);
+    return count;
+}
+
+int main(int argc, char** argv)
+{
+    const char* stage = argc > 1 ? argv[1] : NULL;
+    unsigned int iterations = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_ITERATIONS;
+
+    fb_init();
+
+    if (argc > 3) {
+        uint8_t* frames;
+        unsigned int count = load_frames(argv[3], &frames);
+        if (count == 0) {
+            fprintf(stderr, "%s: no frames\n", argv[3]);
+            return 1;
+        }
+        bench_set_frames(frames, count);
+    }
+
+    if (bench_run(stage, iterations, &bench_print) != 0) {
+        fprintf(stderr, "unknown stage: %s\n", stage);
+        for (unsigned int idx = 0; bench_stage_name(idx) != NULL; idx ++) {
+            fprintf(stderr, "  %s\n", bench_stage_name(idx));
+        }
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "debounce.h"
+
+/**
+ * Replays a stream of synthetic button edges through the firmware's debouncer.
+ *
+ * Each input line is `<time_us> <button> <pressed>`, e.g. `1200 A 1`, with times increasing. Between
+ * edges the state machine is polled at its deadlines, as the firmware's timer would, and each event is
+ * printed with the time it was emitted and its timestamp. Input ends with an optional `<time_us> end`
+ * line, up to which polling continues.
+ *
+ * Lines of the form `= <emitted_us> <button> <event> <time_us>`, e.g. `= 6000 A press 1000`, give the
+ * events expected, in order (or `= none` for no events). If there are any, the exit status is non-zero
+ * unless exactly those events were emitted; host/fixtures/buttons holds edge streams with their expected events (`make -C host check`).
+ *
+ * Usage: button_replay < edges.txt
+ */
+
+#define BUTTONS 2
+
+// Most edges and expected events in one input
+#define MAX_LINES 1024
+
+typedef struct {
+    int64_t emitted_us;
+    int button;
+    char name[16];
+    int64_t time_us;
+} expected_t;
+
+static debounce_t debouncers[BUTTONS];
+static expected_t expected[MAX_LINES];
+static unsigned int expected_count = 0;
+static bool checking = false;
+static unsigned int emitted_count = 0;
+static unsigned int mismatches = 0;
+
+/**
+ * Check an emitted event against the next expected one, if events are expected.
+ */
+static void check_event(int64_t now, int button, const debounce_event_t* event)
+{
+    unsigned int idx = emitted_count ++;
+    if (!checking) {
+        return;
+    }
+
+    const char* name = debounce_event_name(event->type);
+    if (
+        idx >= expected_count || expected[idx].emitted_us != now || expected[idx].button != button ||
+        strcmp(expected[idx].name, name) != 0 || expected[idx].time_us != event->time_us
+    ) {
+        fprintf(
+            stderr, "event %u: unexpected %lld %c %s %lld\n",
+            idx + 1, (long long)now, 'A' + button, name, (long long)event->time_us
+        );
+        mismatches ++;
+    }
+}
+
+/**
+ * Poll every debouncer at each deadline up to (and including) `until`.
+ */
+static void run_until(int64_t until)
+{
+    while (true) {
+        int64_t next = -1;
+        for (int idx = 0; idx < BUTTONS; idx ++) {
+            int64_t deadline = debounce_deadline(&debouncers[idx]);
+            if (deadline >= 0 && (next < 0 || deadline < next)) {
+                next = deadline;
+            }
+        }
+
+        if (next < 0 || next > until) {
+            return;
+        }
+
+        for (int idx = 0; idx < BUTTONS; idx ++) {
+            debounce_event_t events[DEBOUNCE_MAX_EVENTS];
+            int count = debounce_poll(&debouncers[idx], next, events);
+
+            for (int event = 0; event < count; event ++) {
+                printf(
+                    "%10lld %c %-10s at %lld (+%lldus)\n",
+                    (long long)next, 'A' + idx, debounce_event_name(events[event].type),
+                    (long long)events[event].time_us, (long long)(next - events[event].time_us)
+                );
+                check_event(next, idx, &events[event]);
+            }
+        }
+    }
+}
+
+/**
+ * Check every expected event was emitted, returning the exit status.
+ */
+static int finish()
+{
+    if (!checking) {
+        return 0;
+    }
+
+    if (emitted_count < expected_count) {
+        fprintf(stderr, "%u expected events not emitted\n", expected_count - emitted_count);
+        mismatches ++;
+    }
+
+    printf("%s: %u events, %u mismatches\n", mismatches ? "FAIL" : "PASS", emitted_count, mismatches);
+    return mismatches ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    static struct {
+        int64_t time_us;
+        int button;
+        bool pressed;
+    } edges[MAX_LINES];
+    unsigned int edge_count = 0;
+    int64_t end_us = INT64_MAX;
+
+    // Read everything first, as expected events can follow the edges that cause them
+    char line[128];
+    unsigned int line_number = 0;
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        line_number ++;
+
+        long long time_us;
+        long long emitted_us;
+        char button[8];
+        char name[16];
+        int pressed;
+
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+
+        if (line[0] == '=') {
+            checking = true;
+            if (strncmp(line, "= none", 6) == 0) {
+                continue;
+            }
+            if (
+                sscanf(line, "= %lld %7s %15s %lld", &emitted_us, button, name, &time_us) != 4 ||
+                (button[0] != 'A' && button[0] != 'B') || expected_count == MAX_LINES
+            ) {
+                fprintf(stderr, "line %u: expected = <emitted_us> <A|B> <event> <time_us>\n", line_number);
+                return 1;
+            }
+            expected[expected_count].emitted_us = emitted_us;
+            expected[expected_count].button = button[0] - 'A';
+            strcpy(expected[expected_count].name, name);
+            expected[expected_count].time_us = time_us;
+            expected_count ++;
+            continue;
+        }
+
+        if (sscanf(line, "%lld %7s", &time_us, button) == 2 && strcmp(button, "end") == 0) {
+            end_us = time_us;
+            continue;
+        }
+
+        if (
+            sscanf(line, "%lld %7s %d", &time_us, button, &pressed) != 3 || (button[0] != 'A' && button[0] != 'B') ||
+            edge_count == MAX_LINES
+        ) {
+            fprintf(stderr, "line %u: expected <time_us> <A|B> <0|1>\n", line_number);
+            return 1;
+        }
+        edges[edge_count].time_us = time_us;
+        edges[edge_count].button = button[0] - 'A';
+        edges[edge_count].pressed = pressed != 0;
+        edge_count ++;
+    }
+
+    for (int idx = 0; idx < BUTTONS; idx ++) {
+        debounce_init(&debouncers[idx], false);
+    }
+
+    for (unsigned int idx = 0; idx < edge_count && edges[idx].time_us <= end_us; idx ++) {
+        run_until(edges[idx].time_us);
+        debounce_edge(&debouncers[edges[idx].button], edges[idx].pressed, edges[idx].time_us);
+    }
+
+    run_until(end_us);
+    return finish();
+}
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <string.h>
+#include "nvs.h"
+#include "config.h"
+
+/**
+ * Checks config persistence against the in-memory NVS in nvs_host.c:
+ *
+ * - values saved as a blob are read back by the next load, and subscribers are told about them
+ * - a blob that fails its CRC, or whose length doesn't match, is ignored
+ * - per-item strings left by older firmware are loaded, then replaced by a blob on the next write
+ * - a write that fails is still pending afterwards, and a value too large to save is refused
+ *
+ * A `CONFIG {...}` line summarises the run, and the exit status is non-zero if any check failed.
+ *
+ * Usage: config_blob
+ */
+
+static int checks = 0;
+static int failed = 0;
+static int notified = 0;
+
+static void check(bool ok, const char* what)
+{
+    checks ++;
+    if (!ok) {
+        fprintf(stderr, "failed: %s\n", what);
+        failed ++;
+    }
+}
+
+static void count_notify(config_key_t key, void* arg)
+{
+    notified ++;
+}
+
+static void check_round_trip()
+{
+    config_set(CONFIG_GCR, "100");
+    config_set(CONFIG_PLAYLIST, "text:saved|cut|0");
+    config_set(CONFIG_IDLE_MODE, "sleep");
+    check(config_save() == 0, "save with no writer task writes straight away");
+
+    size_t length;
+    check(nvs_host_value("blob", &length) != NULL, "save writes a blob");
+
+    // Changed in memory only, so the load can be seen to replace them
+    config_set(CONFIG_GCR, "7");
+    config_set(CONFIG_PLAYLIST, "effect:blank|cut|0");
+    config_set(CONFIG_IDLE_MODE, "off");
+
+    notified = 0;
+    check(config_load() == 0, "load succeeds");
+    check(config_get_int(CONFIG_GCR) == 100, "integer restored");
+    check(strcmp(config_get(CONFIG_GCR), "100") == 0, "integer string restored");
+    check(strcmp(config_get(CONFIG_PLAYLIST), "text:saved|cut|0") == 0, "string restored");
+    check(config_get_int(CONFIG_IDLE_MODE) == 2, "enum restored");
+    check(notified == 1, "GCR subscriber notified once on load");
+}
+
+static void check_rejected()
+{
+    size_t length;
+    uint8_t* blob = nvs_host_value("blob", &length);
+
+    // A flipped bit in the last value byte
+    blob[length - 1] ^= 0x01;
+    config_set(CONFIG_GCR, "7");
+    config_load();
+    check(config_get_int(CONFIG_GCR) == 7, "blob failing its CRC is ignored");
+    blob[length - 1] ^= 0x01;
+
+    // Truncated, so the header's length no longer matches
+    nvs_handle handle;
+    nvs_open("config", NVS_READWRITE, &handle);
+    uint8_t copy[4000];
+    memcpy(copy, blob, length);
+    nvs_set_blob(handle, "blob", copy, length - 1);
+    config_load();
+    check(config_get_int(CONFIG_GCR) == 7, "truncated blob is ignored");
+
+    // And intact again
+    nvs_set_blob(handle, "blob", copy, length);
+    nvs_close(handle);
+    config_load();
+    check(config_get_int(CONFIG_GCR) == 100, "intact blob is loaded");
+}
+
+static void check_migration()
+{
+    nvs_host_reset();
+
+    nvs_handle handle;
+    nvs_open("config", NVS_READWRITE, &handle);
+    nvs_set_str(handle, "display_gcr", "42");
+    nvs_set_str(handle, "log_level", "warn");
+    nvs_set_str(handle, "stream_port", "not a number");
+    nvs_close(handle);
+
+    config_set(CONFIG_GCR, "7");
+    config_set(CONFIG_STREAM_PORT, "7100");
+    config_load();
+    check(config_get_int(CONFIG_GCR) == 42, "legacy integer loaded");
+    check(config_get_int(CONFIG_LOG_VERBOSITY) == 2, "legacy enum loaded");
+    check(config_get_int(CONFIG_STREAM_PORT) == 7100, "invalid legacy value ignored");
+
+    // The load leaves a save pending, which replaces the strings with a blob
+    check(config_flush() == 0, "migration write succeeds");
+
+    size_t length;
+    check(nvs_host_value("blob", &length) != NULL, "migration writes a blob");
+    check(nvs_host_value("display_gcr", &length) == NULL, "legacy strings erased");
+    check(nvs_host_value("log_level", &length) == NULL, "every legacy string erased");
+
+    config_set(CONFIG_GCR, "7");
+    config_load();
+    check(config_get_int(CONFIG_GCR) == 42, "migrated value loaded from the blob");
+}
+
+static void check_failed_write()
+{
+    config_set(CONFIG_GCR, "50");
+
+    // Opening NVS fails until the flash comes back
+    nvs_host_fail(ESP_ERR_NVS_NOT_FOUND);
+    check(config_save() != 0, "save fails when NVS can't be opened");
+    check(config_flush() != 0, "failed save is still pending");
+    check(config_write() != 0, "failed save is retried");
+
+    nvs_host_fail(ESP_OK);
+    check(config_write() == 0, "retried save succeeds");
+    config_set(CONFIG_GCR, "7");
+    config_load();
+    check(config_get_int(CONFIG_GCR) == 50, "retried save is loaded");
+    check(config_write() == 0, "nothing pending once written");
+
+    // A value as large as the whole blob can't fit with the others
+    static char large[4001];
+    memset(large, 'x', sizeof(large) - 1);
+    check(config_set(CONFIG_PLAYLIST, large) != 0, "value too large to save is refused");
+    check(strcmp(config_get(CONFIG_PLAYLIST), large) != 0, "refused value isn't stored");
+}
+
+int main(int argc, char** argv)
+{
+    config_init();
+    config_subscribe(CONFIG_GCR, &count_notify, NULL);
+
+    notified = 0;
+    check(config_load() == 0, "load with empty NVS succeeds");
+    check(config_get_int(CONFIG_GCR) == 255, "defaults apply with empty NVS");
+    check(notified == 0, "nothing notified with empty NVS");
+
+    check_round_trip();
+    check_rejected();
+    check_migration();
+    check_failed_write();
+
+    printf("CONFIG {\"checks\": %d, \"failed\": %d}\n", checks, failed);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "i2c_wave.h"
+
+/**
+ * Round-trips lists of I2C writes through the waveform encoder and decoder.
+ *
+ * Each list is encoded in randomly sized chunks, as the DMA interrupt would fill its buffers, with and
+ * without the sample pairs swapped, then decoded and compared with the original. The lists are random,
+ * plus one shaped like a full frame (a page select, the PWM and on-off registers for each chip). A
+ * `WAVE {...}` line summarises the run, and the exit status is non-zero if anything didn't match.
+ *
+ * Usage: i2c_wave [lists] [seed]
+ */
+
+#define MAX_TXNS 64
+#define MAX_LENGTH 192
+#define MAX_DATA (MAX_TXNS * MAX_LENGTH)
+#define MAX_SAMPLES (MAX_TXNS * I2C_WAVE_TXN_SYMBOLS(MAX_LENGTH) * I2C_WAVE_SYMBOL_SAMPLES)
+
+static i2c_wave_txn_t txns[MAX_TXNS];
+static uint8_t data[MAX_DATA];
+static uint16_t samples[MAX_SAMPLES];
+static i2c_wave_txn_t decoded[MAX_TXNS];
+static uint8_t decoded_data[MAX_DATA];
+
+/**
+ * Fill the list with `count` random writes, returning `count`.
+ */
+static size_t random_list(size_t count)
+{
+    size_t used = 0;
+    for (size_t idx = 0; idx < count; idx ++) {
+        txns[idx].address = (rand() & 0x7f) << 1;
+        txns[idx].reg = rand() & 0xff;
+        txns[idx].length = rand() % (MAX_LENGTH + 1);
+        txns[idx].data = &data[used];
+        for (uint16_t byte = 0; byte < txns[idx].length; byte ++) {
+            data[used ++] = rand() & 0xff;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Fill the list with the writes display_update() makes for three IS32 chips, returning how many.
+ */
+static size_t frame_list()
+{
+    static const uint8_t chips[] = { 0x50, 0x5a, 0x5f };
+    size_t count = 0;
+    size_t used = 0;
+
+    for (size_t chip = 0; chip < sizeof(chips); chip ++) {
+        uint8_t address = chips[chip] << 1;
+        static const struct { uint8_t page; uint16_t length; } writes[] = { { 1, 192 }, { 0, 24 } };
+
+        for (size_t write = 0; write < 2; write ++) {
+            // Unlock and select the page, then the registers
+            static uint8_t unlock = 0xc5;
+            static uint8_t pages[2] = { 0, 1 };
+            txns[count ++] = (i2c_wave_txn_t){ .address = address, .reg = 0xfe, .data = &unlock, .length = 1 };
+            txns[count ++] = (i2c_wave_txn_t){
+                .address = address, .reg = 0xfd, .data = &pages[writes[write].page], .length = 1
+            };
+
+            txns[count] = (i2c_wave_txn_t){
+                .address = address, .reg = 0x00, .data = &data[used], .length = writes[write].length
+            };
+            for (uint16_t byte = 0; byte < writes[write].length; byte ++) {
+                data[used ++] = rand() & 0xff;
+            }
+            count ++;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Encode the list in random chunks, decode it, and check it came back the same.
+ * Returns the number of samples, or 0 on a mismatch.
+ */
+static size_t round_trip(size_t count, bool swap)
+{
+    i2c_wave_encoder_t encoder;
+    i2c_wave_encoder_init(&encoder, txns, count, swap);
+
+    size_t total = 0;
+    while (!i2c_wave_done(&encoder)) {
+        size_t chunk = (1 + rand() % 256) * I2C_WAVE_SYMBOL_SAMPLES;
+        if (chunk > MAX_SAMPLES - total) {
+            chunk = MAX_SAMPLES - total;
+        }
+        total += i2c_wave_encode(&encoder, &samples[total], chunk);
+    }
+
+    if (total != i2c_wave_samples(txns, count)) {
+        fprintf(stderr, "encoded %zu samples, expected %zu\n", total, i2c_wave_samples(txns, count));
+        return 0;
+    }
+
+    int found = i2c_wave_decode(samples, total, swap, decoded, MAX_TXNS, decoded_data, MAX_DATA);
+    if (found != (int)count) {
+        fprintf(stderr, "decoded %d transactions, expected %zu\n", found, count);
+        return 0;
+    }
+
+    for (size_t idx = 0; idx < count; idx ++) {
+        if (
+            decoded[idx].address != txns[idx].address || decoded[idx].reg != txns[idx].reg ||
+            decoded[idx].length != txns[idx].length ||
+            memcmp(decoded[idx].data, txns[idx].data, txns[idx].length) != 0
+        ) {
+            fprintf(stderr, "transaction %zu differs (swap %d)\n", idx, swap);
+            return 0;
+        }
+    }
+
+    return total;
+}
+
+int main(int argc, char** argv)
+{
+    int lists = argc > 1 ? atoi(argv[1]) : 1000;
+    srand(argc > 2 ? atoi(argv[2]) : 1);
+
+    int failed = 0;
+    size_t total_samples = 0;
+    size_t total_bytes = 0;
+
+    for (int list = 0; list <= lists; list ++) {
+
+        // The last list is a frame
+        size_t count = list < lists ? random_list(1 + rand() % 8) : frame_list();
+
+        for (int swap = 0; swap < 2; swap ++) {
+            size_t encoded = round_trip(count, swap);
+            if (encoded == 0) {
+                failed ++;
+            }
+            total_samples += encoded;
+        }
+
+        for (size_t idx = 0; idx < count; idx ++) {
+            total_bytes += 2 + txns[idx].length;
+        }
+    }
+
+    // The frame on its own, for scale
+    size_t frame_samples = i2c_wave_samples(txns, frame_list());
+
+    printf(
+        "WAVE {\"lists\": %d, \"failed\": %d, \"samples\": %zu, \"bytes\": %zu, \"frame_samples\": %zu}\n",
+        lists + 1, failed, total_samples, total_bytes, frame_samples
+    );
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,25 @@
+//
+// Host stand-in for the GPIO driver - all pads read high and writes go nowhere.
+//
+
+#ifndef GPIO_H
+#define GPIO_H
+
+#include <sys/types.h>
+
+typedef int gpio_num_t;
+
+#define GPIO_MODE_INPUT 0
+#define GPIO_MODE_OUTPUT 1
+#define GPIO_MODE_OUTPUT_OD 2
+#define GPIO_MODE_INPUT_OUTPUT_OD 3
+#define GPIO_PULLUP_ONLY 0
+#define GPIO_FLOATING 1
+
+#define gpio_pad_select_gpio(pin) do { (void)(pin); } while (0)
+#define gpio_set_direction(pin, mode) do { (void)(pin); (void)(mode); } while (0)
+#define gpio_set_pull_mode(pin, mode) do { (void)(pin); (void)(mode); } while (0)
+#define gpio_set_level(pin, level) do { (void)(pin); (void)(level); } while (0)
+#define gpio_get_level(pin) 1
+
+#endif
@@ -0,0 +1,57 @@
+//
+// Host stand-in for the ESP-IDF logging macros.
+// Only warnings and errors are printed so benchmark output stays clean.
+//
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+static inline uint32_t esp_log_timestamp()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Formats like the real thing, but like the macros below only prints warnings and errors
+static inline void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (level <= ESP_LOG_WARN) {
+        fputs(line, stderr);
+    }
+}
+
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E (%s) " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) fprintf(stderr, "W (%s) " format "\n", tag, ##__VA_ARGS__)
+// Quieter levels are dropped, though their arguments still count as used
+static inline void esp_log_discard(const char* tag, ...)
+{
+    (void)tag;
+}
+
+#define ESP_LOGI(tag, format, ...) esp_log_discard(tag, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) esp_log_discard(tag, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) esp_log_discard(tag, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,10 @@
+//
+// Host stand-in for esp_system.h: only the error codes are used by the modules built on host.
+//
+
+#ifndef ESP_SYSTEM_H
+#define ESP_SYSTEM_H
+
+#include "esp_err.h"
+
+#endif
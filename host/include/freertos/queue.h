@@ -0,0 +1,65 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+
+// A fixed-size ring of items; host builds are single-threaded so nothing ever blocks
+typedef struct {
+    unsigned int length;
+    unsigned int item_size;
+    unsigned int head;
+    unsigned int count;
+    unsigned char items[];
+} host_queue_t;
+
+typedef host_queue_t* QueueHandle_t;
+
+static inline QueueHandle_t xQueueCreate(unsigned int length, unsigned int item_size)
+{
+    QueueHandle_t queue = calloc(1, sizeof(host_queue_t) + length * item_size);
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+static inline BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    (void)ticks;
+    if (queue->count == queue->length) {
+        return pdFALSE;
+    }
+    memcpy(&queue->items[((queue->head + queue->count) % queue->length) * queue->item_size], item, queue->item_size);
+    queue->count ++;
+    return pdTRUE;
+}
+
+static inline BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks)
+{
+    (void)ticks;
+    if (queue->count == 0) {
+        return pdFALSE;
+    }
+    memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count --;
+    return pdTRUE;
+}
+
+static inline BaseType_t xQueuePeek(QueueHandle_t queue, void* item, TickType_t ticks)
+{
+    (void)ticks;
+    if (queue->count == 0) {
+        return pdFALSE;
+    }
+    memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    return pdTRUE;
+}
+
+static inline unsigned int uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return queue->count;
+}
+
+#endif
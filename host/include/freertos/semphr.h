@@ -0,0 +1,37 @@
+#ifndef SEMPHR_H
+#define SEMPHR_H
+
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+
+typedef int* SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return calloc(1, sizeof(int));
+}
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    SemaphoreHandle_t sem = calloc(1, sizeof(int));
+    *sem = 1;
+    return sem;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    (void)ticks;
+    if (*sem == 0) {
+        return pdFALSE;
+    }
+    *sem = 0;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    *sem = 1;
+    return pdTRUE;
+}
+
+#endif
@@ -0,0 +1,34 @@
+//
+// Host stand-in for NVS: a single in-memory namespace of strings and blobs (see host/nvs_host.c).
+//
+
+#ifndef NVS_H
+#define NVS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef uint32_t nvs_handle;
+
+typedef enum {
+    NVS_READONLY,
+    NVS_READWRITE
+} nvs_open_mode;
+
+esp_err_t nvs_open(const char* name, nvs_open_mode mode, nvs_handle* handle);
+void nvs_close(nvs_handle handle);
+esp_err_t nvs_commit(nvs_handle handle);
+esp_err_t nvs_get_str(nvs_handle handle, const char* key, char* value, size_t* length);
+esp_err_t nvs_set_str(nvs_handle handle, const char* key, const char* value);
+esp_err_t nvs_get_blob(nvs_handle handle, const char* key, void* value, size_t* length);
+esp_err_t nvs_set_blob(nvs_handle handle, const char* key, const void* value, size_t length);
+esp_err_t nvs_erase_key(nvs_handle handle, const char* key);
+
+// Host only: forget everything, get at a stored value in place (e.g. to corrupt it) or NULL, and make
+// opens and commits fail with `err` (ESP_OK to stop)
+void nvs_host_reset();
+uint8_t* nvs_host_value(const char* key, size_t* length);
+void nvs_host_fail(esp_err_t err);
+
+#endif
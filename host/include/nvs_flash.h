@@ -0,0 +1,13 @@
+//
+// Host stand-in for NVS flash initialisation (see nvs.h).
+//
+
+#ifndef NVS_FLASH_H
+#define NVS_FLASH_H
+
+#include "esp_err.h"
+
+esp_err_t nvs_flash_init();
+esp_err_t nvs_flash_erase();
+
+#endif
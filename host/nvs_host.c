@@ -0,0 +1,171 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nvs.h"
+#include "nvs_flash.h"
+
+/**
+ * In-memory NVS for host builds.
+ * Strings and blobs share one namespace, keyed by name; strings are stored with their terminator.
+ */
+
+#define NVS_HOST_ENTRIES 32
+#define NVS_HOST_KEY_MAX 15
+
+static struct {
+    char key[NVS_HOST_KEY_MAX + 1];
+    bool is_string;
+    uint8_t* value;
+    size_t length;
+} entries[NVS_HOST_ENTRIES];
+
+// Returned by opens and commits, to simulate a failing flash
+static esp_err_t failure = ESP_OK;
+
+static int find(const char* key)
+{
+    for (int idx = 0; idx < NVS_HOST_ENTRIES; idx ++) {
+        if (entries[idx].value != NULL && strcmp(entries[idx].key, key) == 0) {
+            return idx;
+        }
+    }
+
+    return -1;
+}
+
+static esp_err_t set(const char* key, const void* value, size_t length, bool is_string)
+{
+    if (strlen(key) > NVS_HOST_KEY_MAX) {
+        return ESP_FAIL;
+    }
+
+    int idx = find(key);
+    for (int free_idx = 0; idx < 0 && free_idx < NVS_HOST_ENTRIES; free_idx ++) {
+        if (entries[free_idx].value == NULL) {
+            idx = free_idx;
+        }
+    }
+    if (idx < 0) {
+        return ESP_ERR_NVS_NO_FREE_PAGES;
+    }
+
+    free(entries[idx].value);
+    strcpy(entries[idx].key, key);
+    entries[idx].is_string = is_string;
+    entries[idx].value = malloc(length > 0 ? length : 1);
+    memcpy(entries[idx].value, value, length);
+    entries[idx].length = length;
+    return ESP_OK;
+}
+
+static esp_err_t get(const char* key, void* value, size_t* length, bool is_string)
+{
+    int idx = find(key);
+    if (idx < 0 || entries[idx].is_string != is_string) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    // As with the real thing, a NULL value asks for the length
+    if (value == NULL) {
+        *length = entries[idx].length;
+        return ESP_OK;
+    }
+    if (*length < entries[idx].length) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+
+    memcpy(value, entries[idx].value, entries[idx].length);
+    *length = entries[idx].length;
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_init()
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase()
+{
+    nvs_host_reset();
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode mode, nvs_handle* handle)
+{
+    (void)name;
+    (void)mode;
+    *handle = 1;
+    return failure;
+}
+
+void nvs_close(nvs_handle handle)
+{
+    (void)handle;
+}
+
+esp_err_t nvs_commit(nvs_handle handle)
+{
+    (void)handle;
+    return failure;
+}
+
+esp_err_t nvs_get_str(nvs_handle handle, const char* key, char* value, size_t* length)
+{
+    (void)handle;
+    return get(key, value, length, true);
+}
+
+esp_err_t nvs_set_str(nvs_handle handle, const char* key, const char* value)
+{
+    (void)handle;
+    return set(key, value, strlen(value) + 1, true);
+}
+
+esp_err_t nvs_get_blob(nvs_handle handle, const char* key, void* value, size_t* length)
+{
+    (void)handle;
+    return get(key, value, length, false);
+}
+
+esp_err_t nvs_set_blob(nvs_handle handle, const char* key, const void* value, size_t length)
+{
+    (void)handle;
+    return set(key, value, length, false);
+}
+
+esp_err_t nvs_erase_key(nvs_handle handle, const char* key)
+{
+    (void)handle;
+    int idx = find(key);
+    if (idx < 0) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+
+    free(entries[idx].value);
+    entries[idx].value = NULL;
+    return ESP_OK;
+}
+
+void nvs_host_reset()
+{
+    for (int idx = 0; idx < NVS_HOST_ENTRIES; idx ++) {
+        free(entries[idx].value);
+        entries[idx].value = NULL;
+    }
+}
+
+uint8_t* nvs_host_value(const char* key, size_t* length)
+{
+    int idx = find(key);
+    if (idx < 0) {
+        return NULL;
+    }
+
+    *length = entries[idx].length;
+    return entries[idx].value;
+}
+
+void nvs_host_fail(esp_err_t err)
+{
+    failure = err;
+}
@@ -0,0 +1,81 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "display.h"
+#include "serial_proto.h"
+
+/**
+ * Host stand-in for binary mode on the console UART.
+ *
+ * Opens a pseudo-terminal, prints the path of its slave side, and then parses and decodes packets
+ * written to it with the firmware's parser, answering each with an ACK or NAK just as the device does.
+ * Exits when a SERIAL_EXIT packet is received.
+ *
+ * Usage: serial_rx
+ *
+ * Drive it with `tools/serial_send.py <pty path>`.
+ */
+
+static serial_parser_t parser;
+static display_t display;
+
+int main(int argc, char** argv)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+        perror("posix_openpt");
+        return 1;
+    }
+
+    // Hold the slave open in raw mode so the line discipline leaves the binary data alone
+    const char* path = ptsname(master);
+    int slave = open(path, O_RDWR | O_NOCTTY);
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    printf("%s\n", path);
+    fflush(stdout);
+
+    serial_parser_init(&parser);
+    uint8_t chunk[128];
+    uint8_t ack = SERIAL_ACK;
+    uint8_t nak = SERIAL_NAK;
+    bool exit = false;
+
+    while (!exit) {
+        ssize_t length = read(master, chunk, sizeof(chunk));
+        if (length <= 0) {
+            break;
+        }
+
+        size_t pos = 0;
+        while (pos < (size_t)length) {
+            size_t consumed;
+            serial_packet_type_t type = serial_parse(&parser, &chunk[pos], length - pos, &consumed);
+            pos += consumed;
+
+            if (type == SERIAL_NONE) {
+                continue;
+            }
+
+            bool ok = type == SERIAL_PING || type == SERIAL_EXIT || serial_decode(&parser, &display);
+            exit = type == SERIAL_EXIT;
+            if (write(master, ok ? &ack : &nak, 1) != 1) {
+                perror("write");
+                return 1;
+            }
+        }
+    }
+
+    tcdrain(master);
+    printf("%u packets, %u CRC errors, %u invalid\n", parser.packets, parser.crc_errors, parser.invalid);
+    close(slave);
+    close(master);
+    return 0;
+}
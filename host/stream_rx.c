@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include "esp_timer.h"
+#include "display.h"
+#include "stream.h"
+
+/**
+ * Host stand-in for task_stream: receives frames over UDP and decodes them with the firmware's
+ * decoder, reporting the frame rate and stream counters once a second.
+ *
+ * Usage: stream_rx [port] [seconds]
+ *
+ * Drive it with tools/stream_send.py over loopback.
+ */
+
+static stream_t stream;
+static display_t display;
+
+static void report(double elapsed, uint32_t frames)
+{
+    printf(
+        "%6.1fs  %5.1f fps  received %u, decoded %u, late %u, lost %u, unsynced %u, invalid %u, restarts %u\n",
+        elapsed, (double)frames, stream.received, stream.decoded,
+        stream.late, stream.lost, stream.unsynced, stream.invalid, stream.restarts
+    );
+    fflush(stdout);
+}
+
+int main(int argc, char** argv)
+{
+    int port = argc > 1 ? atoi(argv[1]) : 7000;
+    int seconds = argc > 2 ? atoi(argv[2]) : 10;
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY)
+    };
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+
+    // Wake up regularly so reports keep coming when nothing is being sent
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = 100000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    stream_init(&stream);
+
+    int64_t start = esp_timer_get_time();
+    int64_t next_report = start + 1000000;
+    uint32_t last_decoded = 0;
+    uint32_t decode_us = 0;
+
+    while (esp_timer_get_time() - start < seconds * 1000000LL) {
+        ssize_t length = recv(sock, stream_rx_buffer(&stream), STREAM_RECV_BUFFER, 0);
+        if (length > 0) {
+            stream_rx_commit(&stream, length);
+        }
+
+        int64_t decode_start = esp_timer_get_time();
+        while (stream_ready(&stream)) {
+            stream_pop(&stream, &display);
+        }
+        decode_us += esp_timer_get_time() - decode_start;
+
+        if (esp_timer_get_time() >= next_report) {
+            report((next_report - start) / 1000000.0, stream.decoded - last_decoded);
+            last_decoded = stream.decoded;
+            next_report += 1000000;
+        }
+    }
+
+    printf(
+        "total: decoded %u frames, %.2f us decode per frame\n",
+        stream.decoded, stream.decoded ? (double)decode_us / stream.decoded : 0.0
+    );
+
+    close(sock);
+    return 0;
+}
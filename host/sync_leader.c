@@ -0,0 +1,199 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "esp_timer.h"
+#include "display.h"
+#include "sync.h"
+
+/**
+ * Sync leader: multicasts frames tagged with when to show them, answers the nodes' time-sync requests, and
+ * measures the skew between nodes from their reports.
+ *
+ * Usage: sync_leader [nodes] [seconds] [fps] [lead_ms] [interface]
+ *
+ * Run it alongside `nodes` host/sync_node processes over loopback (the default interface). Once a second it
+ * prints the worst skew between nodes showing the same frame; at the end, the median, p99 and worst over
+ * every frame all the nodes showed, and the latest any of them was shown after its time.
+ */
+
+#define SYNC_GROUP "239.0.7.1"
+#define SYNC_PORT 7001
+
+// Frames whose reports are still being collected
+#define TRACK_SLOTS 64
+
+typedef struct {
+    uint32_t seq;
+    int64_t present_us;
+    int64_t first_us;
+    int64_t last_us;
+    int reports;
+} track_t;
+
+static track_t tracks[TRACK_SLOTS];
+
+// Skew of every frame that all nodes reported, and the latest any frame was shown
+static uint32_t* skews;
+static uint32_t skew_count = 0;
+static int64_t latest_us = 0;
+
+static int compare_u32(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * A moving test pattern: one lit column, sweeping across the whole sign.
+ */
+static void render(uint32_t seq, uint8_t* pwm)
+{
+    memset(pwm, 0, DISPLAY_PIXELS);
+    memset(&pwm[(seq % DISPLAY_WIDTH) * DISPLAY_HEIGHT], 0xff, DISPLAY_HEIGHT);
+}
+
+int main(int argc, char** argv)
+{
+    int nodes = argc > 1 ? atoi(argv[1]) : 3;
+    int seconds = argc > 2 ? atoi(argv[2]) : 10;
+    int fps = argc > 3 ? atoi(argv[3]) : 30;
+    int lead_ms = argc > 4 ? atoi(argv[4]) : 50;
+    const char* interface = argc > 5 ? argv[5] : "127.0.0.1";
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    struct in_addr multicast_if = { .s_addr = inet_addr(interface) };
+    unsigned char loop = 1;
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &multicast_if, sizeof(multicast_if));
+    setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+    struct sockaddr_in group = {
+        .sin_family = AF_INET,
+        .sin_port = htons(SYNC_PORT),
+        .sin_addr.s_addr = inet_addr(SYNC_GROUP)
+    };
+
+    skews = calloc(seconds * fps + 2, sizeof(uint32_t));
+
+    uint8_t packet[SYNC_RECV_BUFFER];
+    uint8_t response[SYNC_RESPONSE_SIZE];
+    uint8_t pwm[DISPLAY_PIXELS];
+    uint32_t seq = 0;
+
+    // A new epoch each run, so nodes left running from the last one start over
+    srand(getpid() ^ time(NULL));
+    uint32_t epoch = ((uint32_t)rand() << 16) ^ rand();
+    uint32_t requests = 0;
+    uint32_t second_worst = 0;
+
+    int64_t start = esp_timer_get_time();
+    int64_t next_frame = start;
+    int64_t next_report = start + 1000000;
+    int64_t end = start + seconds * 1000000LL;
+
+    while (true) {
+        int64_t now = esp_timer_get_time();
+
+        if (now >= next_frame && next_frame < end) {
+            track_t* track = &tracks[seq % TRACK_SLOTS];
+            track->seq = seq;
+            track->present_us = now + lead_ms * 1000;
+            track->reports = 0;
+
+            render(seq, pwm);
+            size_t length = sync_encode_frame(epoch, seq, track->present_us, pwm, packet);
+            sendto(sock, packet, length, 0, (struct sockaddr*)&group, sizeof(group));
+            seq ++;
+            next_frame += 1000000 / fps;
+        }
+
+        if (now >= next_report) {
+            printf(
+                "%4llds  sent %u, requests answered %u, worst skew %uus\n",
+                (long long)(next_report - start) / 1000000, seq, requests, second_worst
+            );
+            fflush(stdout);
+            second_worst = 0;
+            next_report += 1000000;
+        }
+
+        // Give the last frames time to be shown and reported
+        if (now >= end + lead_ms * 1000 + 100000) {
+            break;
+        }
+
+        int64_t wake = next_frame < end ? next_frame : end + lead_ms * 1000 + 100000;
+        wake = next_report < wake ? next_report : wake;
+        int64_t wait_us = wake > now ? wake - now : 0;
+        struct timespec timeout = { .tv_sec = wait_us / 1000000, .tv_nsec = (wait_us % 1000000) * 1000 };
+        struct pollfd fds = { .fd = sock, .events = POLLIN };
+        if (ppoll(&fds, 1, &timeout, NULL) <= 0) {
+            continue;
+        }
+
+        struct sockaddr_in from;
+        socklen_t from_length = sizeof(from);
+        ssize_t length = recvfrom(sock, packet, sizeof(packet), 0, (struct sockaddr*)&from, &from_length);
+        int64_t received_us = esp_timer_get_time();
+
+        switch (sync_packet_type(packet, length)) {
+            case SYNC_REQUEST: {
+                size_t response_length = sync_respond(packet, received_us, esp_timer_get_time(), response);
+                sendto(sock, response, response_length, 0, (struct sockaddr*)&from, from_length);
+                requests ++;
+                break;
+            }
+            case SYNC_REPORT: {
+                uint32_t node, report_seq;
+                int64_t presented_us;
+                sync_parse_report(packet, &node, &report_seq, &presented_us);
+
+                track_t* track = &tracks[report_seq % TRACK_SLOTS];
+                if (track->seq != report_seq) {
+                    break;
+                }
+                if (track->reports == 0 || presented_us < track->first_us) {
+                    track->first_us = presented_us;
+                }
+                if (track->reports == 0 || presented_us > track->last_us) {
+                    track->last_us = presented_us;
+                }
+
+                if (++ track->reports == nodes) {
+                    uint32_t skew = track->last_us - track->first_us;
+                    skews[skew_count ++] = skew;
+                    second_worst = skew > second_worst ? skew : second_worst;
+                    if (track->last_us - track->present_us > latest_us) {
+                        latest_us = track->last_us - track->present_us;
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if (skew_count == 0) {
+        printf("no frame was shown by all %d nodes\n", nodes);
+        return 1;
+    }
+
+    qsort(skews, skew_count, sizeof(uint32_t), compare_u32);
+    printf(
+        "SKEW {\"nodes\": %d, \"frames\": %u, \"complete\": %u, \"incomplete\": %u, "
+        "\"median_us\": %u, \"p99_us\": %u, \"max_us\": %u, \"latest_us\": %lld}\n",
+        nodes, seq, skew_count, seq - skew_count,
+        skews[skew_count / 2], skews[(skew_count * 99) / 100], skews[skew_count - 1], (long long)latest_us
+    );
+
+    close(sock);
+    return 0;
+}
@@ -0,0 +1,212 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "esp_timer.h"
+#include "display.h"
+#include "sync.h"
+
+/**
+ * Host stand-in for task_sync: a node that syncs to the leader's clock and shows each frame at its time,
+ * reporting when it did back to the leader.
+ *
+ * Usage: sync_node id [offset_ms] [drift_ppm] [seconds] [interface]
+ *
+ * The node's clock is the host's, moved by `offset_ms` and running `drift_ppm` fast, as two boards' clocks
+ * would be. Frames are "shown" by waking at their time, as the display task does, and the time is reported
+ * on the host's own clock: over loopback that is the leader's, so the skew host/sync_leader measures
+ * between nodes includes both the sync error and the wake-up latency.
+ */
+
+#define SYNC_GROUP "239.0.7.1"
+#define SYNC_PORT 7001
+
+// Frames held until their time, as in the frame buffer's render-ahead queue
+#define PENDING_SLOTS 4
+
+typedef struct {
+    uint32_t seq;
+    int64_t present_us;
+    bool used;
+} pending_t;
+
+static sync_node_t node;
+static display_t display;
+static pending_t pending[PENDING_SLOTS];
+
+// The simulated clock: the host's, offset and drifting from when the node started
+static int64_t start_us;
+static int64_t offset_us;
+static double drift;
+
+static int64_t local_now()
+{
+    int64_t now = esp_timer_get_time();
+    return now + offset_us + (int64_t)((now - start_us) * drift);
+}
+
+static int64_t local_to_host(int64_t local_us)
+{
+    return start_us + (int64_t)((local_us - offset_us - start_us) / (1.0 + drift));
+}
+
+/**
+ * Hold a frame until it's due, dropping the earliest if every slot is taken.
+ */
+static void hold(uint32_t seq, int64_t present_us)
+{
+    pending_t* slot = &pending[0];
+    for (int idx = 0; idx < PENDING_SLOTS; idx ++) {
+        if (!pending[idx].used) {
+            slot = &pending[idx];
+            break;
+        }
+        if (pending[idx].present_us < slot->present_us) {
+            slot = &pending[idx];
+        }
+    }
+
+    slot->seq = seq;
+    slot->present_us = present_us;
+    slot->used = true;
+}
+
+/**
+ * The held frame due first, or NULL.
+ */
+static pending_t* next_due()
+{
+    pending_t* due = NULL;
+    for (int idx = 0; idx < PENDING_SLOTS; idx ++) {
+        if (pending[idx].used && (due == NULL || pending[idx].present_us < due->present_us)) {
+            due = &pending[idx];
+        }
+    }
+    return due;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s id [offset_ms] [drift_ppm] [seconds] [interface]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t id = atoi(argv[1]);
+    offset_us = argc > 2 ? atof(argv[2]) * 1000 : 0;
+    drift = argc > 3 ? atof(argv[3]) / 1e6 : 0;
+    int seconds = argc > 4 ? atoi(argv[4]) : 10;
+    const char* interface = argc > 5 ? argv[5] : "127.0.0.1";
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    int reuse = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(SYNC_PORT),
+        .sin_addr.s_addr = htonl(INADDR_ANY)
+    };
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        return 1;
+    }
+
+    struct ip_mreq group = {
+        .imr_multiaddr.s_addr = inet_addr(SYNC_GROUP),
+        .imr_interface.s_addr = inet_addr(interface)
+    };
+    if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) < 0) {
+        perror("join");
+        return 1;
+    }
+
+    // Requests and reports go from a socket of the node's own, as every node on the host shares the port
+    // frames arrive on, and a response sent to it would reach only one of them
+    int unicast = socket(AF_INET, SOCK_DGRAM, 0);
+
+    sync_init(&node, id);
+    start_us = esp_timer_get_time();
+
+    struct sockaddr_in leader;
+    bool have_leader = false;
+    uint8_t packet[SYNC_RECV_BUFFER];
+    int64_t next_request = 0;
+    int64_t next_report = start_us + 1000000;
+
+    while (esp_timer_get_time() - start_us < seconds * 1000000LL) {
+
+        // Sleep until a packet arrives, a held frame is due, or it's time for another exchange
+        int64_t now = esp_timer_get_time();
+        int64_t wake = next_report;
+        pending_t* due = next_due();
+        if (due != NULL && local_to_host(due->present_us) < wake) {
+            wake = local_to_host(due->present_us);
+        }
+        if (have_leader && next_request < wake) {
+            wake = next_request;
+        }
+
+        struct pollfd fds[2] = { { .fd = sock, .events = POLLIN }, { .fd = unicast, .events = POLLIN } };
+        int64_t wait_us = wake > now ? wake - now : 0;
+        struct timespec timeout = { .tv_sec = wait_us / 1000000, .tv_nsec = (wait_us % 1000000) * 1000 };
+        if (ppoll(fds, 2, &timeout, NULL) > 0) {
+            ssize_t length;
+            if (fds[0].revents & POLLIN) {
+                socklen_t from_length = sizeof(leader);
+                length = recvfrom(sock, packet, sizeof(packet), 0, (struct sockaddr*)&leader, &from_length);
+            } else {
+                length = recv(unicast, packet, sizeof(packet), 0);
+            }
+
+            switch (sync_packet_type(packet, length)) {
+                case SYNC_FRAME: {
+                    have_leader = true;
+                    int64_t present_us;
+                    if (sync_frame(&node, packet, local_now(), &display, &present_us)) {
+                        hold(node.next_seq - 1, present_us);
+                    }
+                    break;
+                }
+                case SYNC_RESPONSE:
+                    sync_response(&node, packet, local_now());
+                    break;
+                default:
+                    node.invalid ++;
+                    break;
+            }
+        }
+
+        // Show every held frame that's due, and say when
+        while ((due = next_due()) != NULL && local_now() >= due->present_us) {
+            size_t length = sync_report(&node, due->seq, esp_timer_get_time(), packet);
+            sendto(unicast, packet, length, 0, (struct sockaddr*)&leader, sizeof(leader));
+            due->used = false;
+        }
+
+        if (have_leader && esp_timer_get_time() >= next_request) {
+            size_t length = sync_request(&node, local_now(), packet);
+            sendto(unicast, packet, length, 0, (struct sockaddr*)&leader, sizeof(leader));
+            next_request = esp_timer_get_time() + SYNC_REQUEST_MS * 1000;
+        }
+
+        if (esp_timer_get_time() >= next_report) {
+            int64_t actual = offset_us + (int64_t)((esp_timer_get_time() - start_us) * drift);
+            printf(
+                "node %u: offset error %+lldus (rtt %uus), frames %u, late %u, lost %u, unsynced %u, invalid %u, restarts %u\n",
+                id, (long long)(node.offset_us + actual), node.rtt_us, node.frames, node.late, node.lost,
+                node.unsynced, node.invalid, node.restarts
+            );
+            fflush(stdout);
+            next_report += 1000000;
+        }
+    }
+
+    close(unicast);
+    close(sock);
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <string.h>
+#include "esp_log.h"
+#include "anim.h"
+
+/**
+ * Animation playback.
+ *
+ * Frames are decoded one at a time from the animation data (normally flash, memory-mapped by
+ * anim_open_partition()) into a single DISPLAY_PIXELS frame, so playback needs no RAM beyond that.
+ */
+
+static const char* TAG = "Anim";
+
+/**
+ * Decode RLE data into exactly `out_length` bytes, XORing with what's already there if `xor` is set.
+ * Returns false if the data is malformed.
+ */
+static bool rle_decode(const uint8_t* in, size_t in_length, uint8_t* out, size_t out_length, bool xor)
+{
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+
+    while (in_pos < in_length) {
+        uint8_t control = in[in_pos ++];
+
+        if (control < 0x80) {
+
+            // Literal run
+            size_t count = control + 1;
+            if (in_pos + count > in_length || out_pos + count > out_length) {
+                return false;
+            }
+            for (; count; count --, out_pos ++, in_pos ++) {
+                out[out_pos] = xor ? out[out_pos] ^ in[in_pos] : in[in_pos];
+            }
+
+        } else {
+
+            // Repeated byte
+            size_t count = control - 0x80 + 3;
+            if (in_pos + 1 > in_length || out_pos + count > out_length) {
+                return false;
+            }
+            uint8_t value = in[in_pos ++];
+
+            // XORing with zero (the common case for deltas) changes nothing
+            if (xor && value == 0) {
+                out_pos += count;
+            } else {
+                for (; count; count --, out_pos ++) {
+                    out[out_pos] = xor ? out[out_pos] ^ value : value;
+                }
+            }
+        }
+    }
+
+    return out_pos == out_length;
+}
+
+/**
+ * Start playing an animation from `size` bytes of data.
+ * Returns -1 if the data isn't a usable animation.
+ */
+int anim_open(anim_t* anim, const uint8_t* data, size_t size)
+{
+    const anim_header_t* header = (const anim_header_t*)data;
+
+    if (
+        size < sizeof(anim_header_t) || memcmp(header->magic, ANIM_MAGIC, 4) != 0 ||
+        header->version != ANIM_VERSION || header->frame_count == 0 ||
+        header->width != DISPLAY_WIDTH || header->height != DISPLAY_HEIGHT ||
+        header->data_length > size - sizeof(anim_header_t)
+    ) {
+        return -1;
+    }
+
+    anim->data = data;
+    anim->header = header;
+    anim->pos = sizeof(anim_header_t);
+    anim->frame_index = 0;
+    anim->duration_ms = 0;
+    memset(anim->frame, 0, sizeof(anim->frame));
+
+    return 0;
+}
+
+/**
+ * Decode the next frame into anim->frame, looping back to the start after the last one.
+ * Returns false if the animation data is corrupt.
+ */
+bool anim_next(anim_t* anim)
+{
+    if (anim->frame_index == anim->header->frame_count) {
+        anim->pos = sizeof(anim_header_t);
+        anim->frame_index = 0;
+    }
+
+    size_t end = sizeof(anim_header_t) + anim->header->data_length;
+    if (anim->pos + sizeof(anim_frame_t) > end) {
+        ESP_LOGW(TAG, "frame %d header runs off the end of the data", anim->frame_index);
+        return false;
+    }
+
+    anim_frame_t record;
+    memcpy(&record, &anim->data[anim->pos], sizeof(anim_frame_t));
+    const uint8_t* data = &anim->data[anim->pos + sizeof(anim_frame_t)];
+
+    if (anim->pos + sizeof(anim_frame_t) + record.length > end) {
+        ESP_LOGW(TAG, "frame %d data runs off the end of the data", anim->frame_index);
+        return false;
+    }
+
+    // The first frame of a loop must be a keyframe, as there's nothing to apply a delta to
+    if (
+        (record.type != ANIM_KEY && record.type != ANIM_DELTA) ||
+        (record.type == ANIM_DELTA && anim->frame_index == 0) ||
+        !rle_decode(data, record.length, anim->frame, DISPLAY_PIXELS, record.type == ANIM_DELTA)
+    ) {
+        ESP_LOGW(TAG, "frame %d is corrupt", anim->frame_index);
+        return false;
+    }
+
+    anim->duration_ms = record.duration_ms;
+    anim->pos += sizeof(anim_frame_t) + record.length;
+    anim->frame_index ++;
+    return true;
+}
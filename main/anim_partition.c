@@ -0,0 +1,40 @@
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "anim.h"
+
+static const char* TAG = "Anim";
+
+/**
+ * Memory-map the animation partition and start playing it.
+ * The partition stays mapped for the life of the application.
+ * Returns -1 if there's no partition or it doesn't hold a valid animation.
+ */
+int anim_open_partition(anim_t* anim)
+{
+    const esp_partition_t* partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, ANIM_PARTITION_SUBTYPE, ANIM_PARTITION_LABEL
+    );
+
+    if (partition == NULL) {
+        ESP_LOGW(TAG, "no %s partition", ANIM_PARTITION_LABEL);
+        return -1;
+    }
+
+    const void* data;
+    spi_flash_mmap_handle_t handle;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &data, &handle);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "error (%s) mapping %s partition", esp_err_to_name(err), ANIM_PARTITION_LABEL);
+        return -1;
+    }
+
+    if (anim_open(anim, data, partition->size) != 0) {
+        ESP_LOGI(TAG, "no valid animation in %s partition", ANIM_PARTITION_LABEL);
+        spi_flash_munmap(handle);
+        return -1;
+    }
+
+    ESP_LOGI(TAG, "mapped %d-frame animation (%u bytes)", anim->header->frame_count, anim->header->data_length);
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include <string.h>
+#include "asset.h"
+#include "assets.h"
+
+/**
+ * Assets compiled in by tools/asset_gen.py.
+ *
+ * The data is const, so on the device it stays in flash and is read through the cache; drawing an asset
+ * is a copy of its columns, with the rendering (text included) already done at build time.
+ */
+
+/**
+ * Draw an asset with its top left at (x_pos, y_pos), clipped to the display.
+ */
+void asset_blit(display_t* display, const asset_t* asset, int x_pos, int y_pos, uint32_t pwm)
+{
+    // Only the rows and columns that land on the display
+    int first_col = x_pos < 0 ? -x_pos : 0;
+    int last_col = x_pos + asset->width > DISPLAY_WIDTH ? DISPLAY_WIDTH - x_pos : asset->width;
+    int first_row = y_pos < 0 ? -y_pos : 0;
+    int last_row = y_pos + asset->height > DISPLAY_HEIGHT ? DISPLAY_HEIGHT - y_pos : asset->height;
+
+    for (int col = first_col; col < last_col; col ++) {
+        led_t* column = (*display)[x_pos + col];
+
+        if (asset->format == ASSET_COLUMNS) {
+            uint8_t bits = asset->data[col];
+            for (int row = first_row; row < last_row; row ++) {
+                column[y_pos + row].on = true;
+                column[y_pos + row].pwm = (bits >> row) & 1 ? pwm : 0;
+            }
+        } else {
+            const uint8_t* pixels = &asset->data[col * asset->height];
+            for (int row = first_row; row < last_row; row ++) {
+                column[y_pos + row].on = true;
+                column[y_pos + row].pwm = pixels[row];
+            }
+        }
+    }
+}
+
+/**
+ * Look an asset up by name.
+ */
+const asset_t* asset_find(const char* name)
+{
+    for (int idx = 0; idx < ASSET_COUNT; idx ++) {
+        if (strcmp(assets[idx].name, name) == 0) {
+            return &assets[idx];
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,74 @@
+// Generated by tools/asset_gen.py from assets/assets.txt - do not edit.
+
+#include "assets.h"
+
+// splash.pbm
+static const uint8_t splash_data[24] = {
+    0x2a, 0x15, 0x2a, 0x15, 0x2a, 0x15, 0x2a, 0x15, 0x2a, 0x15, 0x2a, 0x15,
+    0x2a, 0x15, 0x2a, 0x15, 0x2a, 0x15, 0x2a, 0x15, 0x2a, 0x15, 0x2a, 0x15,
+};
+
+// ramp.pgm
+static const uint8_t ramp_data[144] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x0b, 0x0b, 0x0b, 0x0b, 0x0b, 0x0b,
+    0x16, 0x16, 0x16, 0x16, 0x16, 0x16,
+    0x21, 0x21, 0x21, 0x21, 0x21, 0x21,
+    0x2c, 0x2c, 0x2c, 0x2c, 0x2c, 0x2c,
+    0x37, 0x37, 0x37, 0x37, 0x37, 0x37,
+    0x43, 0x43, 0x43, 0x43, 0x43, 0x43,
+    0x4e, 0x4e, 0x4e, 0x4e, 0x4e, 0x4e,
+    0x59, 0x59, 0x59, 0x59, 0x59, 0x59,
+    0x64, 0x64, 0x64, 0x64, 0x64, 0x64,
+    0x6f, 0x6f, 0x6f, 0x6f, 0x6f, 0x6f,
+    0x7a, 0x7a, 0x7a, 0x7a, 0x7a, 0x7a,
+    0x85, 0x85, 0x85, 0x85, 0x85, 0x85,
+    0x90, 0x90, 0x90, 0x90, 0x90, 0x90,
+    0x9b, 0x9b, 0x9b, 0x9b, 0x9b, 0x9b,
+    0xa6, 0xa6, 0xa6, 0xa6, 0xa6, 0xa6,
+    0xb1, 0xb1, 0xb1, 0xb1, 0xb1, 0xb1,
+    0xbc, 0xbc, 0xbc, 0xbc, 0xbc, 0xbc,
+    0xc8, 0xc8, 0xc8, 0xc8, 0xc8, 0xc8,
+    0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3,
+    0xde, 0xde, 0xde, 0xde, 0xde, 0xde,
+    0xe9, 0xe9, 0xe9, 0xe9, 0xe9, 0xe9,
+    0xf4, 0xf4, 0xf4, 0xf4, 0xf4, 0xf4,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+// text:bench
+static const uint8_t bench_data[24] = {
+    0x1f, 0x14, 0x14, 0x08, 0x00, 0x0c, 0x16, 0x16, 0x14, 0x00, 0x1e, 0x02,
+    0x02, 0x1c, 0x00, 0x0c, 0x12, 0x12, 0x12, 0x00, 0x1f, 0x04, 0x04, 0x18,
+};
+
+// text:Welcome - this banner was rendered at build time
+static const uint8_t banner_data[239] = {
+    0x1f, 0x0c, 0x0c, 0x1f, 0x00, 0x0c, 0x16, 0x16, 0x14, 0x00, 0x11, 0x1f,
+    0x10, 0x00, 0x00, 0x0c, 0x12, 0x12, 0x12, 0x00, 0x0c, 0x12, 0x12, 0x0c,
+    0x00, 0x1e, 0x0c, 0x0c, 0x1e, 0x00, 0x0c, 0x16, 0x16, 0x14, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x08, 0x08, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x02, 0x0f, 0x12, 0x10, 0x00, 0x1f, 0x04, 0x04, 0x18, 0x00,
+    0x00, 0x00, 0x1a, 0x00, 0x00, 0x10, 0x16, 0x1a, 0x02, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x1f, 0x14, 0x14, 0x08, 0x00, 0x0c, 0x12, 0x0c, 0x1e,
+    0x00, 0x1e, 0x02, 0x02, 0x1c, 0x00, 0x1e, 0x02, 0x02, 0x1c, 0x00, 0x0c,
+    0x16, 0x16, 0x14, 0x00, 0x1e, 0x04, 0x02, 0x02, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x0e, 0x1c, 0x1c, 0x0e, 0x00, 0x0c, 0x12, 0x0c, 0x1e, 0x00,
+    0x10, 0x16, 0x1a, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1e, 0x04,
+    0x02, 0x02, 0x00, 0x0c, 0x16, 0x16, 0x14, 0x00, 0x1e, 0x02, 0x02, 0x1c,
+    0x00, 0x08, 0x14, 0x14, 0x1f, 0x00, 0x0c, 0x16, 0x16, 0x14, 0x00, 0x1e,
+    0x04, 0x02, 0x02, 0x00, 0x0c, 0x16, 0x16, 0x14, 0x00, 0x08, 0x14, 0x14,
+    0x1f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x12, 0x0c, 0x1e, 0x00,
+    0x02, 0x0f, 0x12, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f, 0x14,
+    0x14, 0x08, 0x00, 0x0e, 0x10, 0x10, 0x0e, 0x00, 0x00, 0x00, 0x1a, 0x00,
+    0x00, 0x11, 0x1f, 0x10, 0x00, 0x00, 0x08, 0x14, 0x14, 0x1f, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x02, 0x0f, 0x12, 0x10, 0x00, 0x00, 0x00, 0x1a,
+    0x00, 0x00, 0x1e, 0x0c, 0x0c, 0x1e, 0x00, 0x0c, 0x16, 0x16, 0x14,
+};
+
+const asset_t assets[ASSET_COUNT] = {
+    [ASSET_SPLASH] = { .name = "splash", .format = ASSET_COLUMNS, .width = 24, .height = 6, .data = splash_data },
+    [ASSET_RAMP] = { .name = "ramp", .format = ASSET_FRAME, .width = 24, .height = 6, .data = ramp_data },
+    [ASSET_BENCH] = { .name = "bench", .format = ASSET_COLUMNS, .width = 24, .height = 5, .data = bench_data },
+    [ASSET_BANNER] = { .name = "banner", .format = ASSET_COLUMNS, .width = 239, .height = 5, .data = banner_data },
+};
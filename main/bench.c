@@ -0,0 +1,428 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "cycles.h"
+#include "display.h"
+#include "transition.h"
+#include "frame_buffer.h"
+#include "i2c.h"
+#include "i2c_dma.h"
+#include "effects.h"
+#include "assets.h"
+#include "mono.h"
+#include "dlog.h"
+#include "esp_log.h"
+#include "bench.h"
+
+/**
+ * Microbenchmarks for the render and flush hot paths.
+ *
+ * Each stage is run a number of times, timing every iteration individually with the cycle counter.
+ * Results are reported as one machine-readable line per stage, e.g.:
+ *
+ * BENCH {"stage":"display_update","unit":"cycles","n":101,"min":...,"median":...,"p99":...,"max":...,"wire_bytes":651,"budget":0}
+ *
+ * Effects are timed rendering whole frames, ignoring their budgets, with the budget reported alongside.
+ *
+ * tools/bench_compare.py compares two sets of these lines against each other.
+ */
+
+// A single benchmarkable stage
+typedef struct {
+    const char* name;
+
+    // Does this stage drive the I2C bus? If so, the frame buffer is locked so the display task stays off it
+    bool uses_bus;
+
+    // Untimed setup before each iteration, the timed work, and untimed cleanup after each iteration
+    void (*prepare)();
+    void (*run)();
+    void (*finish)();
+
+    // The procedural effect rendered by run_effect(), if any
+    const char* effect;
+} bench_stage_t;
+
+// Scratch state shared by the stages
+static display_t bench_from;
+static display_t bench_to;
+static mono_t bench_mono;
+static trans_handle_t* bench_trans = NULL;
+static effect_t bench_effect;
+static uint32_t samples[BENCH_MAX_ITERATIONS];
+
+// Optional recorded input frames (e.g. reconstructed from an I2C trace) for the display_update stage
+static const uint8_t* input_frames = NULL;
+static unsigned int input_frame_count = 0;
+static unsigned int input_frame_idx = 0;
+
+/**
+ * Cycle through the recorded input frames, if there are any.
+ */
+static void prepare_display_update()
+{
+    if (input_frame_count == 0) {
+        return;
+    }
+
+    display_load_pwm(&bench_from, &input_frames[input_frame_idx * DISPLAY_PIXELS]);
+    input_frame_idx = (input_frame_idx + 1) % input_frame_count;
+}
+
+static void run_display_update()
+{
+    display_update(&bench_from);
+}
+
+/**
+ * A counter ticking over in the last character cell, with a fixed label alongside it.
+ */
+static void prepare_display_update_changed()
+{
+    static unsigned int count = 0;
+    char from_text[8];
+    char to_text[8];
+    snprintf(from_text, sizeof(from_text), "ab %d", count % 10);
+    snprintf(to_text, sizeof(to_text), "ab %d", (count + 1) % 10);
+    count ++;
+
+    display_fill(&bench_from, 0x00, true);
+    display_fill(&bench_to, 0x00, true);
+    display_text(&bench_from, 4, 0xff, from_text);
+    display_text(&bench_to, 4, 0xff, to_text);
+}
+
+static void run_display_update_changed()
+{
+    display_update_changed(&bench_to, &bench_from);
+}
+
+static void run_display_text()
+{
+    display_text(&bench_to, 0, 0xff, "bench");
+}
+
+static void run_asset_blit()
+{
+    asset_blit(&bench_to, &assets[ASSET_BENCH], 0, 0, 0xff);
+}
+
+static void run_display_checkerboard()
+{
+    display_checkerboard(&bench_to, false, 0xff);
+}
+
+static void run_mono_text()
+{
+    mono_clear(&bench_mono, false);
+    mono_text(&bench_mono, 0, "bench");
+}
+
+static void run_mono_checkerboard()
+{
+    mono_checkerboard(&bench_mono, false);
+}
+
+static void run_mono_shift()
+{
+    mono_shift(&bench_mono, 1, -1);
+}
+
+static void run_mono_render()
+{
+    mono_render(&bench_mono, &bench_to, DISPLAY_WIDTH, DISPLAY_HEIGHT, 0xff);
+}
+
+static void run_display_copy()
+{
+    display_copy(&bench_from, &bench_to, 0, 0, 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+}
+
+/**
+ * Make sure a live transition of the given type is available for the next step.
+ */
+static void prepare_trans(trans_type_t type)
+{
+    if (bench_trans != NULL && !bench_trans->is_finished) {
+        return;
+    }
+
+    trans_free(bench_trans);
+
+    switch (type) {
+        case TRANS_WIPE: bench_trans = trans_wipe(&bench_from, &bench_to, WIPE_DOWN); break;
+        case TRANS_FADE: bench_trans = trans_fade(&bench_from, &bench_to, 64); break;
+        case TRANS_SCROLL_TEXT: bench_trans = trans_scroll_text("bench ~ scroll", false, SCROLL_START_CLEAR, SCROLL_END_CLEAR); break;
+        case TRANS_PUSH: bench_trans = trans_push(&bench_from, &bench_to, WIPE_LEFT); break;
+        case TRANS_SLIDE: bench_trans = trans_slide(&bench_from, &bench_to, WIPE_LEFT); break;
+        case TRANS_IRIS: bench_trans = trans_iris(&bench_from, &bench_to, false); break;
+        case TRANS_DISSOLVE: bench_trans = trans_dissolve(&bench_from, &bench_to, 32); break;
+    }
+}
+
+static void prepare_trans_wipe()
+{
+    prepare_trans(TRANS_WIPE);
+}
+
+static void prepare_trans_fade()
+{
+    prepare_trans(TRANS_FADE);
+}
+
+static void prepare_trans_scroll_text()
+{
+    prepare_trans(TRANS_SCROLL_TEXT);
+}
+
+static void prepare_trans_push()
+{
+    prepare_trans(TRANS_PUSH);
+}
+
+static void prepare_trans_slide()
+{
+    prepare_trans(TRANS_SLIDE);
+}
+
+static void prepare_trans_iris()
+{
+    prepare_trans(TRANS_IRIS);
+}
+
+static void prepare_trans_dissolve()
+{
+    prepare_trans(TRANS_DISSOLVE);
+}
+
+static void run_trans_progress()
+{
+    trans_progress(bench_trans);
+}
+
+static void finish_trans()
+{
+    trans_free(bench_trans);
+    bench_trans = NULL;
+}
+
+static void run_effect()
+{
+    effect_render(&bench_effect, &bench_to);
+}
+
+/**
+ * The same event logged directly (formatted and written out by the caller, as ESP_LOGx does) and deferred.
+ * Deferred records are drained between iterations, so the ring never fills.
+ */
+static void run_log_direct()
+{
+    esp_log_write(
+        ESP_LOG_INFO, "Bench", "%c (%u) %s: transition (@ %08x) has finished (%d steps)\n",
+        'I', esp_log_timestamp(), "Bench", (uint32_t)(uintptr_t)&bench_from, DISPLAY_WIDTH
+    );
+}
+
+static void run_log_deferred()
+{
+    DLOGI("Bench", "transition (@ %08x) has finished (%d steps)", (uint32_t)(uintptr_t)&bench_from, DISPLAY_WIDTH);
+}
+
+static void finish_log_deferred()
+{
+    dlog_drain();
+}
+
+/**
+ * A full frame's writes encoded as I2C samples, a DMA buffer at a time into the same buffer: the work the
+ * DMA interrupt does over a frame.
+ */
+static void run_i2c_wave_encode()
+{
+    static uint8_t pwm[192];
+    static uint8_t on_off[24];
+    static uint16_t buffer[I2C_DMA_BUFFER_SAMPLES];
+    static const i2c_wave_txn_t txns[] = {
+        { .address = 0xa0, .reg = 0x00, .data = pwm, .length = sizeof(pwm) },
+        { .address = 0xa0, .reg = 0x00, .data = on_off, .length = sizeof(on_off) },
+        { .address = 0xb4, .reg = 0x00, .data = pwm, .length = sizeof(pwm) },
+        { .address = 0xb4, .reg = 0x00, .data = on_off, .length = sizeof(on_off) },
+        { .address = 0xbe, .reg = 0x00, .data = pwm, .length = sizeof(pwm) },
+        { .address = 0xbe, .reg = 0x00, .data = on_off, .length = sizeof(on_off) }
+    };
+
+    i2c_wave_encoder_t encoder;
+    i2c_wave_encoder_init(&encoder, txns, sizeof(txns) / sizeof(i2c_wave_txn_t), true);
+    while (!i2c_wave_done(&encoder)) {
+        i2c_wave_encode(&encoder, buffer, I2C_DMA_BUFFER_SAMPLES);
+    }
+}
+
+static void run_i2c_tx()
+{
+    // No chip answers to 0x7F so this byte is always NACKed
+    i2c_tx(0xFF);
+}
+
+static const bench_stage_t stages[] = {
+    { .name = "display_update", .uses_bus = true, .prepare = &prepare_display_update, .run = &run_display_update },
+    { .name = "display_update_changed", .uses_bus = true, .prepare = &prepare_display_update_changed, .run = &run_display_update_changed },
+    { .name = "display_text", .run = &run_display_text },
+    { .name = "asset_blit", .run = &run_asset_blit },
+    { .name = "display_checkerboard", .run = &run_display_checkerboard },
+    { .name = "mono_text", .run = &run_mono_text },
+    { .name = "mono_checkerboard", .run = &run_mono_checkerboard },
+    { .name = "mono_shift", .run = &run_mono_shift },
+    { .name = "mono_render", .run = &run_mono_render },
+    { .name = "display_copy", .run = &run_display_copy },
+    { .name = "trans_wipe_progress", .prepare = &prepare_trans_wipe, .run = &run_trans_progress },
+    { .name = "trans_fade_progress", .prepare = &prepare_trans_fade, .run = &run_trans_progress },
+    { .name = "trans_scroll_text_progress", .prepare = &prepare_trans_scroll_text, .run = &run_trans_progress },
+    { .name = "trans_push_progress", .prepare = &prepare_trans_push, .run = &run_trans_progress },
+    { .name = "trans_slide_progress", .prepare = &prepare_trans_slide, .run = &run_trans_progress },
+    { .name = "trans_iris_progress", .prepare = &prepare_trans_iris, .run = &run_trans_progress },
+    { .name = "trans_dissolve_progress", .prepare = &prepare_trans_dissolve, .run = &run_trans_progress },
+    { .name = "effect_plasma", .run = &run_effect, .effect = "plasma" },
+    { .name = "effect_fire", .run = &run_effect, .effect = "fire" },
+    { .name = "effect_noise", .run = &run_effect, .effect = "noise" },
+    { .name = "effect_sparkles", .run = &run_effect, .effect = "sparkles" },
+    { .name = "effect_bars", .run = &run_effect, .effect = "bars" },
+    { .name = "effect_particles", .run = &run_effect, .effect = "particles" },
+    { .name = "log_direct", .run = &run_log_direct },
+    { .name = "log_deferred", .run = &run_log_deferred, .finish = &finish_log_deferred },
+    { .name = "i2c_wave_encode", .run = &run_i2c_wave_encode },
+    { .name = "i2c_tx", .uses_bus = true, .prepare = &i2c_start, .run = &run_i2c_tx, .finish = &i2c_stop }
+};
+
+#define BENCH_STAGES (sizeof(stages) / sizeof(bench_stage_t))
+
+static int compare_samples(const void* a, const void* b)
+{
+    uint32_t sa = *(const uint32_t*)a;
+    uint32_t sb = *(const uint32_t*)b;
+    return (sa > sb) - (sa < sb);
+}
+
+/**
+ * Run a single stage, filling in the result.
+ */
+static void bench_stage(const bench_stage_t* stage, unsigned int iterations, bench_result_t* result)
+{
+    // Start each stage from the same display states
+    display_checkerboard(&bench_from, false, 0xff);
+    display_checkerboard(&bench_to, true, 0x80);
+    input_frame_idx = 0;
+    result->budget = 0;
+
+    // Effects render unclipped so the full cost of a frame is measured against the budget
+    if (stage->effect != NULL) {
+        effect_start(&bench_effect, effect_find(stage->effect), 1);
+        result->budget = bench_effect.budget_cycles;
+        bench_effect.budget_cycles = 0;
+    }
+
+    if (stage->uses_bus) {
+        fb_lock();
+    }
+
+    uint32_t bytes_start = i2c_bytes_sent();
+
+    for (unsigned int i = 0; i < iterations; i ++) {
+
+        if (stage->prepare) {
+            stage->prepare();
+        }
+
+        uint32_t start = cycles_now();
+        stage->run();
+        samples[i] = cycles_now() - start;
+
+        if (stage->finish) {
+            stage->finish();
+        }
+    }
+
+    uint32_t bytes = i2c_bytes_sent() - bytes_start;
+
+    // The panel no longer shows what the frame buffer last flushed
+    if (stage->uses_bus) {
+        fb_invalidate();
+        fb_unlock();
+    }
+
+    // Release anything the transition stages left behind
+    finish_trans();
+
+    qsort(samples, iterations, sizeof(uint32_t), &compare_samples);
+
+    result->stage = stage->name;
+    result->iterations = iterations;
+    result->min = samples[0];
+    result->median = samples[iterations / 2];
+    result->p99 = samples[((iterations * 99) + 99) / 100 - 1];
+    result->max = samples[iterations - 1];
+    result->wire_bytes = bytes / iterations;
+}
+
+/**
+ * Run the named stage (or every stage if `stage` is NULL or "all").
+ * Returns -1 if the stage doesn't exist.
+ */
+int bench_run(const char* stage, unsigned int iterations, bench_report_t report)
+{
+    bool run_all = stage == NULL || strcmp(stage, "all") == 0;
+    bool found = false;
+    bench_result_t result;
+
+    if (iterations == 0) {
+        iterations = BENCH_DEFAULT_ITERATIONS;
+    }
+
+    if (iterations > BENCH_MAX_ITERATIONS) {
+        iterations = BENCH_MAX_ITERATIONS;
+    }
+
+    for (unsigned int idx = 0; idx < BENCH_STAGES; idx ++) {
+        if (!run_all && strcmp(stages[idx].name, stage) != 0) {
+            continue;
+        }
+
+        found = true;
+        bench_stage(&stages[idx], iterations, &result);
+        report(&result);
+    }
+
+    return found ? 0 : -1;
+}
+
+/**
+ * Print a result in the machine-readable format.
+ */
+void bench_print(const bench_result_t* result)
+{
+    printf(
+        "BENCH {\"stage\":\"%s\",\"unit\":\"%s\",\"n\":%u,\"min\":%u,\"median\":%u,\"p99\":%u,\"max\":%u,\"wire_bytes\":%u,\"budget\":%u}\n",
+        result->stage, CYCLES_UNIT, result->iterations,
+        result->min, result->median, result->p99, result->max, result->wire_bytes, result->budget
+    );
+}
+
+/**
+ * Get the name of a stage by index, or NULL past the last stage.
+ */
+const char* bench_stage_name(unsigned int index)
+{
+    return index < BENCH_STAGES ? stages[index].name : NULL;
+}
+
+/**
+ * Use a fixed sequence of frames (DISPLAY_PIXELS packed PWM bytes each, see display_load_pwm())
+ * as the input to the display_update stage instead of a checkerboard, so runs are repeatable.
+ */
+void bench_set_frames(const uint8_t* frames, unsigned int count)
+{
+    input_frames = frames;
+    input_frame_count = count;
+    input_frame_idx = 0;
+}
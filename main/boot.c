@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "boot.h"
+#include "assets.h"
+
+static const char* TAG = "Boot";
+
+// Marks a valid last_frame
+#define BOOT_FRAME_MAGIC 0x46524d45
+
+// The most recently flushed frame, as PWM bytes in display_load_pwm() order, which survives soft resets
+typedef struct {
+    uint32_t magic;
+    uint32_t checksum;
+    uint8_t pwm[DISPLAY_PIXELS];
+} boot_frame_t;
+
+static RTC_NOINIT_ATTR boot_frame_t last_frame;
+
+static boot_phase_t phases[BOOT_MAX_PHASES];
+static uint32_t phase_count = 0;
+
+// Whether the first frame was restored from before the reset
+static bool restored = false;
+
+/**
+ * Record that a boot phase has been reached.
+ * Phases are identified by their name pointer, so a phase that can be reached repeatedly (e.g. a
+ * reconnection) is only recorded the first time.
+ */
+void boot_mark(const char* name)
+{
+    int64_t now = esp_timer_get_time();
+
+    uint32_t count = __atomic_load_n(&phase_count, __ATOMIC_ACQUIRE);
+    for (uint32_t idx = 0; idx < count && idx < BOOT_MAX_PHASES; idx ++) {
+        if (phases[idx].name == name) {
+            return;
+        }
+    }
+
+    uint32_t idx = __atomic_fetch_add(&phase_count, 1, __ATOMIC_ACQ_REL);
+    if (idx >= BOOT_MAX_PHASES) {
+        return;
+    }
+
+    phases[idx].us = now;
+    __atomic_store_n(&phases[idx].name, name, __ATOMIC_RELEASE);
+    ESP_LOGI(TAG, "%s at %lldus", name, now);
+}
+
+/**
+ * Checksum a stored frame.
+ */
+static uint32_t boot_checksum(const uint8_t* data, size_t length)
+{
+    uint32_t sum1 = 0xFFFF, sum2 = 0xFFFF;
+
+    while (length --) {
+        sum1 = (sum1 + *data ++) % 0xFFFF;
+        sum2 = (sum2 + sum1) % 0xFFFF;
+    }
+
+    return (sum2 << 16) | sum1;
+}
+
+/**
+ * Render the first frame to show.
+ * RTC memory is only retained through a soft reset (a restart, panic or watchdog), and the checksum
+ * catches whatever it holds after power-on.
+ */
+bool boot_splash(display_t* frame)
+{
+    esp_reset_reason_t reason = esp_reset_reason();
+
+    restored = reason != ESP_RST_POWERON && reason != ESP_RST_BROWNOUT
+        && last_frame.magic == BOOT_FRAME_MAGIC
+        && last_frame.checksum == boot_checksum(last_frame.pwm, DISPLAY_PIXELS);
+
+    if (restored) {
+        display_load_pwm(frame, last_frame.pwm);
+    } else {
+        display_fill(frame, 0x00, true);
+        asset_blit(frame, &assets[ASSET_SPLASH], 0, 0, BOOT_SPLASH_PWM);
+    }
+
+    return restored;
+}
+
+/**
+ * Keep a copy of a flushed frame.
+ * The magic is cleared while the copy is updated, so a reset part way through leaves it invalid
+ * rather than torn.
+ */
+void boot_remember(const display_t* frame)
+{
+    last_frame.magic = 0;
+
+    uint8_t* pwm = last_frame.pwm;
+    for (int x = 0; x < DISPLAY_WIDTH; x ++) {
+        for (int y = 0; y < DISPLAY_HEIGHT; y ++) {
+            const led_t* led = &(*frame)[x][y];
+            *pwm ++ = !led->on ? 0 : led->pwm > 0xff ? 0xff : led->pwm;
+        }
+    }
+
+    last_frame.checksum = boot_checksum(last_frame.pwm, DISPLAY_PIXELS);
+    last_frame.magic = BOOT_FRAME_MAGIC;
+}
+
+/**
+ * Print the boot phases, with the time each was reached since reset and since the previous one.
+ */
+void boot_print()
+{
+    uint32_t count = __atomic_load_n(&phase_count, __ATOMIC_ACQUIRE);
+    if (count > BOOT_MAX_PHASES) {
+        count = BOOT_MAX_PHASES;
+    }
+
+    printf("reset reason %d, first frame %s\n", esp_reset_reason(), restored ? "restored" : "splash");
+
+    int64_t previous = 0;
+    for (uint32_t idx = 0; idx < count; idx ++) {
+        const char* name = __atomic_load_n(&phases[idx].name, __ATOMIC_ACQUIRE);
+        if (name == NULL) {
+            continue;
+        }
+
+        printf("%-16s %8lldus  +%lldus\n", name, phases[idx].us, phases[idx].us - previous);
+        previous = phases[idx].us;
+    }
+}
@@ -1,27 +1,153 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdbool.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
 #include "pins.h"
 #include "buttons.h"
 
+static const char* TAG = "Buttons";
+
+static const button_t button_pins[BUTTON_COUNT] = { BUTTON_A, BUTTON_B };
+
+// Debouncers, shared between the edge interrupt and the timer callback
+static debounce_t debouncers[BUTTON_COUNT];
+static portMUX_TYPE debounce_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Fires when a debouncer next needs polling
+static esp_timer_handle_t debounce_timer;
+
+static QueueHandle_t events;
+static uint32_t dropped = 0;
+
+/**
+ * (Re)arm the debounce timer to fire `delay_us` from now.
+ */
+static void IRAM_ATTR buttons_arm(int64_t delay_us)
+{
+    esp_timer_stop(debounce_timer);
+    esp_timer_start_once(debounce_timer, delay_us > 0 ? delay_us : 0);
+}
+
+/**
+ * GPIO interrupt: record the edge and restart the settling time.
+ */
+static void IRAM_ATTR buttons_isr(void* arg)
+{
+    int idx = (intptr_t)arg;
+    int64_t now = esp_timer_get_time();
+    bool pressed = gpio_get_level((gpio_num_t)button_pins[idx]) == 0;
+
+    portENTER_CRITICAL_ISR(&debounce_lock);
+    debounce_edge(&debouncers[idx], pressed, now);
+    portEXIT_CRITICAL_ISR(&debounce_lock);
+
+    buttons_arm(DEBOUNCE_SETTLE_US);
+}
+
+/**
+ * Timer callback: advance the debouncers, queue any events, and rearm for the earliest deadline.
+ */
+static void buttons_poll(void* arg)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t next = -1;
+
+    for (int idx = 0; idx < BUTTON_COUNT; idx ++) {
+        debounce_event_t polled[DEBOUNCE_MAX_EVENTS];
+
+        portENTER_CRITICAL(&debounce_lock);
+        int count = debounce_poll(&debouncers[idx], now, polled);
+        int64_t deadline = debounce_deadline(&debouncers[idx]);
+        portEXIT_CRITICAL(&debounce_lock);
+
+        for (int event = 0; event < count; event ++) {
+            button_event_t queued = {
+                .button = button_pins[idx],
+                .type = polled[event].type,
+                .time_us = polled[event].time_us
+            };
+
+            if (xQueueSend(events, &queued, 0) != pdTRUE) {
+                __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+            }
+        }
+
+        if (deadline >= 0 && (next < 0 || deadline < next)) {
+            next = deadline;
+        }
+    }
+
+    if (next >= 0) {
+        buttons_arm(next - now);
+    }
+}
+
 /**
  * Initialise the button controls.
  */
 void buttons_init()
 {
-    gpio_pad_select_gpio(PIN_BUTTON_A);
-    gpio_set_direction(PIN_BUTTON_A, GPIO_MODE_INPUT);
-    gpio_set_pull_mode(PIN_BUTTON_A, GPIO_PULLUP_ONLY);
-    gpio_pad_select_gpio(PIN_BUTTON_B);
-    gpio_set_direction(PIN_BUTTON_B, GPIO_MODE_INPUT);
-    gpio_set_pull_mode(PIN_BUTTON_B, GPIO_PULLUP_ONLY);
+    events = xQueueCreate(BUTTON_QUEUE_LENGTH, sizeof(button_event_t));
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = &buttons_poll,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "buttons"
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &debounce_timer));
+
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "error (%s) installing GPIO ISR service", esp_err_to_name(err));
+        return;
+    }
+
+    for (int idx = 0; idx < BUTTON_COUNT; idx ++) {
+        gpio_num_t pin = (gpio_num_t)button_pins[idx];
+
+        gpio_pad_select_gpio(pin);
+        gpio_set_direction(pin, GPIO_MODE_INPUT);
+        gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
+
+        debounce_init(&debouncers[idx], gpio_get_level(pin) == 0);
+
+        gpio_set_intr_type(pin, GPIO_INTR_ANYEDGE);
+        gpio_isr_handler_add(pin, &buttons_isr, (void*)(intptr_t)idx);
+    }
 }
 
 /**
- * Returns whether or not the button is currently pressed.
+ * Returns whether or not the button is currently pressed (once debounced).
  */
 bool button_is_pressed(button_t button)
 {
-    return gpio_get_level((gpio_num_t)button) == 0;
+    for (int idx = 0; idx < BUTTON_COUNT; idx ++) {
+        if (button_pins[idx] == button) {
+            return debouncers[idx].pressed;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Wait up to `timeout` for the next button event.
+ */
+bool buttons_receive(button_event_t* event, TickType_t timeout)
+{
+    return xQueueReceive(events, event, timeout) == pdTRUE;
+}
+
+/**
+ * Number of events dropped because nothing was reading them.
+ */
+uint32_t buttons_dropped()
+{
+    return dropped;
 }
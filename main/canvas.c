@@ -0,0 +1,105 @@
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "canvas.h"
+
+/**
+ * Virtual canvases, shown through a viewport.
+ *
+ * Animations move the viewport and call canvas_view() for each frame, which copies at most
+ * DISPLAY_WIDTH bytes whatever is on the canvas.
+ */
+
+/**
+ * Allocate a blank canvas `width` columns wide.
+ */
+bool canvas_init(canvas_t* canvas, int width, canvas_storage_t storage)
+{
+    memset(canvas, 0, sizeof(canvas_t));
+    if (width < 1 || width > CANVAS_MAX_WIDTH || storage == CANVAS_FLASH) {
+        return false;
+    }
+
+    uint8_t* columns = NULL;
+    if (storage == CANVAS_PSRAM) {
+        columns = heap_caps_malloc(width, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (columns == NULL) {
+        columns = heap_caps_malloc(width, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        storage = CANVAS_INTERNAL;
+    }
+    if (columns == NULL) {
+        return false;
+    }
+
+    memset(columns, 0, width);
+    canvas->columns = columns;
+    canvas->writable = columns;
+    canvas->width = width;
+    canvas->storage = storage;
+    return true;
+}
+
+/**
+ * Use a column asset as a canvas, reading it straight from flash.
+ */
+bool canvas_init_asset(canvas_t* canvas, const asset_t* asset)
+{
+    memset(canvas, 0, sizeof(canvas_t));
+    if (asset->format != ASSET_COLUMNS) {
+        return false;
+    }
+
+    canvas->columns = asset->data;
+    canvas->width = asset->width;
+    canvas->storage = CANVAS_FLASH;
+    return true;
+}
+
+/**
+ * Free a canvas's columns, if they were allocated.
+ */
+void canvas_free(canvas_t* canvas)
+{
+    if (canvas->writable != NULL) {
+        heap_caps_free(canvas->writable);
+    }
+
+    memset(canvas, 0, sizeof(canvas_t));
+}
+
+/**
+ * Draw text onto a canvas, lighting its pixels (the rest are left as they are).
+ */
+void canvas_text(canvas_t* canvas, int x_pos, const char* text)
+{
+    if (canvas->writable == NULL) {
+        return;
+    }
+
+    for (const char* ch = text; *ch != '\0' && x_pos < canvas->width; ch ++, x_pos += DISPLAY_CHAR_WIDTH) {
+        const uint8_t* glyph = mono_glyph(*ch);
+        for (int col = 0; col < DISPLAY_CHAR_WIDTH - 1; col ++) {
+            int x = x_pos + col;
+            if (x >= 0 && x < canvas->width) {
+                canvas->writable[x] |= glyph[col];
+            }
+        }
+    }
+}
+
+/**
+ * Copy the columns under the viewport into a plane, blank where it's off the canvas.
+ */
+void canvas_view(const canvas_t* canvas, mono_t* window)
+{
+    int first = canvas->viewport < 0 ? -canvas->viewport : 0;
+    int last = canvas->viewport + DISPLAY_WIDTH > canvas->width ? canvas->width - canvas->viewport : DISPLAY_WIDTH;
+
+    mono_clear(window, false);
+    if (first >= last || canvas->columns == NULL) {
+        return;
+    }
+
+    // Columns never have bits set below the display (assets are at most DISPLAY_HEIGHT high)
+    memcpy(&window->columns[first], &canvas->columns[canvas->viewport + first], last - first);
+}
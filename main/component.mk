@@ -1,6 +1,14 @@
 #
 # Main component makefile.
 #
-COMPONENT_SRCDIRS := . tasks tasks/cli tasks/main tasks/display
+COMPONENT_SRCDIRS := . tasks tasks/cli tasks/main tasks/display tasks/stream tasks/config tasks/log tasks/sync
 COMPONENT_ADD_INCLUDEDIRS := include
-COMPONENT_PRIV_INCLUDEDIRS := tasks/cli/include tasks/main/include tasks/display/include
\ No newline at end of file
+COMPONENT_PRIV_INCLUDEDIRS := tasks/cli/include tasks/main/include tasks/display/include tasks/stream/include tasks/config/include tasks/log/include tasks/sync/include
+
+# Regenerate the compiled-in assets (main/assets.c and include/assets.h) when any of their sources change
+ASSET_SOURCES := $(wildcard $(COMPONENT_PATH)/../assets/*) $(COMPONENT_PATH)/../tools/asset_gen.py $(COMPONENT_PATH)/include/font_4x5.h
+
+$(COMPONENT_PATH)/assets.c $(COMPONENT_PATH)/include/assets.h: $(ASSET_SOURCES)
+	$(PYTHON) $(COMPONENT_PATH)/../tools/asset_gen.py
+
+asset.o assets.o boot.o bench.o: $(COMPONENT_PATH)/include/assets.h
@@ -1,44 +1,255 @@
 #include <string.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 #include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
 #include "config.h"
+#include "serial_proto.h"
 
 static const char* TAG = "Config";
 
 /**
- * Configuration records.
+ * Configuration is persisted as a single NVS blob:
+ *
+ *     config_blob_header_t, then `count` records of
+ *     u8 name length, name, u16 (little-endian) value length, value
+ *
+ * with a CRC-32 over the records. Records are keyed by name, so items can be added, removed or
+ * reordered without a schema change; CONFIG_BLOB_VERSION is bumped (with a config_renames[] entry)
+ * when an item is renamed. Values stored as separate NVS strings by older firmware are read once
+ * and migrated into a blob.
  */
-config_entry_t config[] = {
-    {
-        .key = CONFIG_WIFI_SSID,
-        .value = NULL,
-        .default_value = "default_ssid",
-        .is_dirty = false
+
+#define CONFIG_BLOB_KEY "blob"
+#define CONFIG_BLOB_MAGIC 0x46435854
+#define CONFIG_BLOB_VERSION 1
+
+// Largest blob that will be read or written (the NVS limit for a single blob)
+#define CONFIG_BLOB_MAX 4000
+
+// Longest item name (the NVS key length limit)
+#define CONFIG_NAME_MAX 15
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t length;
+    uint32_t crc;
+} config_blob_header_t;
+
+// Items renamed in a schema version: blobs older than `version` have `old_name` read as `new_name`
+static const struct {
+    uint16_t version;
+    const char* old_name;
+    const char* new_name;
+} config_renames[] = {
+    { 0, NULL, NULL }
+};
+
+// CRC-32 (IEEE), a nibble at a time
+static const uint32_t crc32_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+// Guards values against being changed while they're serialised, and serialises writes
+static SemaphoreHandle_t config_lock;
+static SemaphoreHandle_t write_lock;
+
+// Saves waiting to be written, whether per-item strings from older firmware need erasing, and the writer
+static bool save_pending = false;
+static bool legacy_present = false;
+static TaskHandle_t writer_task = NULL;
+
+// Options for enum values, in the order of their parsed values
+static const char* const log_levels[] = { "none", "error", "warn", "info", "debug", "verbose", NULL };
+static const char* const idle_modes[] = { "off", "shutdown", "sleep", NULL };
+static const char* const i2c_modes[] = { "bitbang", "dma", NULL };
+
+/**
+ * Configuration records, indexed by config_key_t.
+ */
+config_entry_t config[CONFIG_COUNT] = {
+    [CONFIG_WIFI_SSID] = {
+        .name = "wifi_ssid",
+        .type = CONFIG_TYPE_STRING,
+        .default_value = "default_ssid"
     },
-    {
-        .key = CONFIG_WIFI_PSK,
-        .value = NULL,
-        .default_value = "default_psk",
-        .is_dirty = false
+    [CONFIG_WIFI_PSK] = {
+        .name = "wifi_psk",
+        .type = CONFIG_TYPE_STRING,
+        .default_value = "default_psk"
     },
-    {
-        .key = CONFIG_GCR,
-        .value = NULL,
+    [CONFIG_GCR] = {
+        .name = "display_gcr",
+        .type = CONFIG_TYPE_INT,
         .default_value = "255",
-        .is_dirty = false
+        .min = 0,
+        .max = 255
+    },
+    [CONFIG_STREAM_PORT] = {
+        .name = "stream_port",
+        .type = CONFIG_TYPE_INT,
+        .default_value = "7000",
+        .min = 1,
+        .max = 65535
+    },
+    [CONFIG_SERIAL_BAUD] = {
+        .name = "serial_baud",
+        .type = CONFIG_TYPE_INT,
+        .default_value = "921600",
+        .min = SERIAL_MIN_BAUD,
+        .max = SERIAL_MAX_BAUD
+    },
+    [CONFIG_PLAYLIST] = {
+        .name = "playlist",
+        .type = CONFIG_TYPE_STRING,
+        .default_value =
+            "effect:checkerboard|cut|1000;"
+            "effect:checkerboard_inverse|cut|1000;"
+            "text:hello ~ transition test =)|cut|0;"
+            "effect:checkerboard_inverse|wipe_down|0;"
+            "effect:blank|fade|1000"
+    },
+    [CONFIG_LOG_VERBOSITY] = {
+        .name = "log_level",
+        .type = CONFIG_TYPE_ENUM,
+        .default_value = "info",
+        .options = log_levels
+    },
+    [CONFIG_IDLE_MODE] = {
+        .name = "idle_mode",
+        .type = CONFIG_TYPE_ENUM,
+        .default_value = "shutdown",
+        .options = idle_modes
+    },
+    [CONFIG_ZONES] = {
+        .name = "zones",
+        .type = CONFIG_TYPE_STRING,
+        .default_value = ""
+    },
+    [CONFIG_SYNC_GROUP] = {
+        .name = "sync_group",
+        .type = CONFIG_TYPE_STRING,
+        .default_value = ""
+    },
+    [CONFIG_SYNC_PORT] = {
+        .name = "sync_port",
+        .type = CONFIG_TYPE_INT,
+        .default_value = "7001",
+        .min = 1,
+        .max = 65535
+    },
+    [CONFIG_I2C_MODE] = {
+        .name = "i2c_mode",
+        .type = CONFIG_TYPE_ENUM,
+        .default_value = "bitbang",
+        .options = i2c_modes
     }
 };
 
-size_t config_count = sizeof(config) / sizeof(config_entry_t);
+// Change callbacks
+static struct {
+    config_key_t key;
+    config_callback_t callback;
+    void* arg;
+} callbacks[CONFIG_MAX_CALLBACKS];
+static size_t callback_count = 0;
 
 /**
- * Initialise the flash storage.
+ * Call everything subscribed to an item.
+ * Subscriptions can arrive from other tasks meanwhile, so the ones to call are copied out under the lock
+ * and called without it (leaving callbacks free to use config_set()).
  */
-void flash_init() 
+static void config_notify(config_key_t key)
 {
+    config_callback_t notify[CONFIG_MAX_CALLBACKS];
+    void* args[CONFIG_MAX_CALLBACKS];
+    size_t count = 0;
+
+    xSemaphoreTake(config_lock, portMAX_DELAY);
+    for (size_t idx = 0; idx < callback_count; idx ++) {
+        if (callbacks[idx].key == key) {
+            notify[count] = callbacks[idx].callback;
+            args[count] = callbacks[idx].arg;
+            count ++;
+        }
+    }
+    xSemaphoreGive(config_lock);
+
+    for (size_t idx = 0; idx < count; idx ++) {
+        notify[idx](key, args[idx]);
+    }
+}
+
+/**
+ * Parse a value for an entry, returning 0 and the parsed value if it's valid.
+ */
+static int config_parse(const config_entry_t* entry, const char* value, int* parsed)
+{
+    switch (entry->type) {
+        case CONFIG_TYPE_STRING:
+            *parsed = 0;
+            return 0;
+
+        case CONFIG_TYPE_INT: {
+            char* end;
+            long number = strtol(value, &end, 0);
+            if (*value == '\0' || *end != '\0' || number < entry->min || number > entry->max) {
+                return -1;
+            }
+            *parsed = number;
+            return 0;
+        }
+
+        case CONFIG_TYPE_ENUM:
+            for (int option = 0; entry->options[option] != NULL; option ++) {
+                if (strcmp(entry->options[option], value) == 0) {
+                    *parsed = option;
+                    return 0;
+                }
+            }
+            return -1;
+    }
+
+    return -1;
+}
+
+/**
+ * Store a (valid) value, reusing the entry's buffer if it's big enough.
+ */
+static void config_store(config_entry_t* entry, const char* value, int parsed)
+{
+    size_t size = strlen(value) + 1;
+
+    if (size > entry->capacity) {
+        free(entry->value);
+        entry->value = malloc(size);
+        entry->capacity = size;
+        ESP_LOGI(TAG, "allocated space (%dB) for %s value @ %p", size, entry->name, entry->value);
+    }
+
+    memcpy(entry->value, value, size);
+    entry->parsed = parsed;
+}
+
+/**
+ * Initialise the flash storage, once.
+ */
+static void flash_init() 
+{
+    static bool initialised = false;
+    if (initialised) {
+        return;
+    }
+
     esp_err_t err = nvs_flash_init();
 
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -48,13 +259,162 @@ void flash_init()
     }
 
     ESP_ERROR_CHECK(err);
+    initialised = true;
+}
+
+/**
+ * Update a CRC-32 (IEEE, initial value 0xFFFFFFFF, final inversion left to the caller) with some data.
+ */
+static uint32_t config_crc32(uint32_t crc, const uint8_t* data, size_t length)
+{
+    while (length --) {
+        crc ^= *data ++;
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+        crc = (crc >> 4) ^ crc32_nibble[crc & 0x0F];
+    }
+
+    return crc;
+}
+
+/**
+ * Apply a single stored name/value record, renaming it first if the blob predates a rename.
+ */
+static void config_apply_record(uint16_t version, const char* name, const char* value)
+{
+    for (int idx = 0; config_renames[idx].old_name != NULL; idx ++) {
+        if (version < config_renames[idx].version && strcmp(name, config_renames[idx].old_name) == 0) {
+            name = config_renames[idx].new_name;
+        }
+    }
+
+    int key = config_find(name);
+    int parsed;
+
+    if (key < 0) {
+        ESP_LOGW(TAG, "dropping stored value for unknown item %s", name);
+        return;
+    }
+
+    if (config_parse(&config[key], value, &parsed) != 0) {
+        ESP_LOGW(TAG, "ignoring invalid stored value for %s: %s", name, value);
+        return;
+    }
+
+    config_store(&config[key], value, parsed);
+}
+
+/**
+ * Decode a blob into config[], returning 0 if it was valid.
+ */
+static int config_decode(const uint8_t* blob, size_t size)
+{
+    const config_blob_header_t* header = (const config_blob_header_t*)blob;
+
+    if (size < sizeof(config_blob_header_t) || header->magic != CONFIG_BLOB_MAGIC || header->length != size - sizeof(config_blob_header_t)) {
+        ESP_LOGW(TAG, "stored config is malformed");
+        return -1;
+    }
+
+    const uint8_t* pos = blob + sizeof(config_blob_header_t);
+    const uint8_t* end = pos + header->length;
+
+    if (~config_crc32(0xFFFFFFFF, pos, header->length) != header->crc) {
+        ESP_LOGW(TAG, "stored config failed its CRC check");
+        return -1;
+    }
+
+    if (header->version > CONFIG_BLOB_VERSION) {
+        ESP_LOGW(TAG, "stored config is from a newer version (%d), ignoring it", header->version);
+        return -1;
+    }
+
+    if (header->version < CONFIG_BLOB_VERSION) {
+        ESP_LOGI(TAG, "migrating stored config from version %d to %d", header->version, CONFIG_BLOB_VERSION);
+        save_pending = true;
+    }
+
+    // Records are a length-prefixed name then a little-endian length-prefixed value
+    char name[CONFIG_NAME_MAX + 1];
+    for (uint16_t record = 0; record < header->count; record ++) {
+        if (end - pos < 1 || end - pos < 1 + pos[0] + 2) {
+            return -1;
+        }
+
+        size_t name_length = *pos ++;
+        if (name_length > CONFIG_NAME_MAX) {
+            return -1;
+        }
+        memcpy(name, pos, name_length);
+        name[name_length] = '\0';
+        pos += name_length;
+
+        size_t value_length = pos[0] | (pos[1] << 8);
+        pos += 2;
+        if (end - pos < value_length) {
+            return -1;
+        }
+
+        char* value = malloc(value_length + 1);
+        memcpy(value, pos, value_length);
+        value[value_length] = '\0';
+        pos += value_length;
+
+        config_apply_record(header->version, name, value);
+        free(value);
+    }
+
+    return 0;
 }
 
 /**
- * Load configuration from NVS, if present.
+ * Load values stored by firmware that kept each item as its own NVS string.
+ * Returns true if any were found, in which case they're rewritten as a blob by the next save.
+ */
+static bool config_load_legacy(nvs_handle flash_handle)
+{
+    bool found = false;
+
+    for (int key = 0; key < CONFIG_COUNT; key ++) {
+        size_t value_size;
+        if (nvs_get_str(flash_handle, config[key].name, NULL, &value_size) != ESP_OK) {
+            continue;
+        }
+
+        char* value = malloc(value_size);
+        if (nvs_get_str(flash_handle, config[key].name, value, &value_size) == ESP_OK) {
+            config_apply_record(0, config[key].name, value);
+            found = true;
+        }
+        free(value);
+    }
+
+    return found;
+}
+
+/**
+ * Set every item to its default, without touching flash.
+ * This is quick, so that tasks started before config_load() has finished see sensible values.
+ */
+void config_init()
+{
+    config_lock = xSemaphoreCreateMutex();
+    write_lock = xSemaphoreCreateMutex();
+
+    for (int key = 0; key < CONFIG_COUNT; key ++) {
+        if (config_parse(&config[key], config[key].default_value, &config[key].parsed) != 0) {
+            ESP_LOGE(TAG, "invalid default for %s: %s", config[key].name, config[key].default_value);
+        }
+    }
+}
+
+/**
+ * Load configuration from NVS, if present, reading the stored blob in a single NVS access.
+ * Anything already subscribed is notified of each stored value, as it would be of a change.
  */
 int config_load() 
 {   
+    int64_t start = esp_timer_get_time();
+
     flash_init();
 
     nvs_handle flash_handle;
@@ -65,150 +425,280 @@ int config_load()
         return -1;
     }
 
-    // For each configuration item
-    for (int cfg_idx = 0; cfg_idx < sizeof(config) / sizeof(config_entry_t); cfg_idx ++) {
+    // Read the whole blob in one go
+    uint8_t* blob = malloc(CONFIG_BLOB_MAX);
+    size_t size = CONFIG_BLOB_MAX;
+    err = nvs_get_blob(flash_handle, CONFIG_BLOB_KEY, blob, &size);
+
+    if (err == ESP_OK) {
+        config_decode(blob, size);
+    } else if (err == ESP_ERR_NVS_NOT_FOUND) {
+        legacy_present = config_load_legacy(flash_handle);
+        if (legacy_present) {
+            ESP_LOGI(TAG, "migrating per-item config to a single blob");
+            save_pending = true;
+        }
+    } else {
+        ESP_LOGW(TAG, "error (%s) reading stored config", esp_err_to_name(err));
+    }
 
-        // Allocate space for each configuration value
-        size_t value_size;
-        err = nvs_get_str(flash_handle, config[cfg_idx].key, NULL, &value_size);
+    free(blob);
+    nvs_close(flash_handle);
 
-        // Does the value just not exist yet?
-        if (err == ESP_ERR_NVS_NOT_FOUND) {
-            ESP_LOGI(TAG, "value for config item %s not found in NVS storage", config[cfg_idx].key);
-            continue;
+    ESP_LOGI(TAG, "loaded config in %lldus", esp_timer_get_time() - start);
+
+    for (int key = 0; key < CONFIG_COUNT; key ++) {
+        if (config[key].value != NULL) {
+            config_notify(key);
         }
+    }
 
-        ESP_ERROR_CHECK(err);
-        config[cfg_idx].value = malloc(value_size);
-        ESP_LOGI(TAG, "allocated space (%dB) for %s value @ %p", value_size, config[cfg_idx].key, config[cfg_idx].value);
+    return 0;
+}
 
-        // Read the value
-        err = nvs_get_str(flash_handle, config[cfg_idx].key, config[cfg_idx].value, &value_size);
-        ESP_ERROR_CHECK(err);
+/**
+ * The size of the blob config_encode() would produce, were `key` set to `value` (CONFIG_COUNT for the
+ * values as they are). Called with config_lock held.
+ */
+static size_t config_encoded_size(config_key_t key, const char* value)
+{
+    size_t size = sizeof(config_blob_header_t);
+    for (int idx = 0; idx < CONFIG_COUNT; idx ++) {
+        const char* stored = idx == key ? value : config[idx].value;
+        if (stored != NULL) {
+            size += 1 + strlen(config[idx].name) + 2 + strlen(stored);
+        }
     }
 
-    // Finished reading flash data, close the handle
-    nvs_close(flash_handle);
-    return 0;
+    return size;
 }
 
 /**
- * Save configuration to NVS.
+ * Serialise config[] into a newly allocated blob, returning its size.
+ * Only values that have been set are stored; everything else keeps its (current firmware's) default.
  */
-int config_save()
+static size_t config_encode(uint8_t** blob)
 {
-    flash_init();
+    xSemaphoreTake(config_lock, portMAX_DELAY);
+
+    size_t size = config_encoded_size(CONFIG_COUNT, NULL);
+    uint16_t count = 0;
+    for (int key = 0; key < CONFIG_COUNT; key ++) {
+        if (config[key].value != NULL) {
+            count ++;
+        }
+    }
+
+    *blob = malloc(size);
+    uint8_t* pos = *blob + sizeof(config_blob_header_t);
+
+    for (int key = 0; key < CONFIG_COUNT; key ++) {
+        if (config[key].value == NULL) {
+            continue;
+        }
+
+        size_t name_length = strlen(config[key].name);
+        size_t value_length = strlen(config[key].value);
+        *pos ++ = name_length;
+        memcpy(pos, config[key].name, name_length);
+        pos += name_length;
+        *pos ++ = value_length & 0xFF;
+        *pos ++ = value_length >> 8;
+        memcpy(pos, config[key].value, value_length);
+        pos += value_length;
+        config[key].is_dirty = false;
+    }
+
+    xSemaphoreGive(config_lock);
+
+    config_blob_header_t* header = (config_blob_header_t*)*blob;
+    header->magic = CONFIG_BLOB_MAGIC;
+    header->version = CONFIG_BLOB_VERSION;
+    header->count = count;
+    header->length = size - sizeof(config_blob_header_t);
+    header->crc = ~config_crc32(0xFFFFFFFF, *blob + sizeof(config_blob_header_t), header->length);
+    return size;
+}
+
+/**
+ * Write the config blob to NVS now, if a save is pending.
+ * This is normally called by the background writer task; it blocks for as long as the NVS commit takes.
+ */
+int config_write()
+{
+    xSemaphoreTake(write_lock, portMAX_DELAY);
+
+    if (!__atomic_exchange_n(&save_pending, false, __ATOMIC_RELAXED)) {
+        xSemaphoreGive(write_lock);
+        return 0;
+    }
+
+    int64_t start = esp_timer_get_time();
+    uint8_t* blob;
+    size_t size = config_encode(&blob);
+    int result = 0;
 
     nvs_handle flash_handle;
     esp_err_t err = nvs_open("config", NVS_READWRITE, &flash_handle);
 
+    // A failed write leaves the save pending, for the writer task to retry
     if (err != ESP_OK) {
-        ESP_LOGI(TAG, "error (%s) opening NVS handle for saving", esp_err_to_name(err));
+        ESP_LOGW(TAG, "error (%s) opening NVS handle for saving", esp_err_to_name(err));
+        __atomic_store_n(&save_pending, true, __ATOMIC_RELAXED);
+        free(blob);
+        xSemaphoreGive(write_lock);
         return -1;
     }
 
-    // For each configuration item
-    for (int cfg_idx = 0; cfg_idx < sizeof(config) / sizeof(config_entry_t); cfg_idx ++) {
-        
-        // Only write dirty entries to NVS
-        if (!config[cfg_idx].is_dirty) {
-            continue;
+    if ((err = nvs_set_blob(flash_handle, CONFIG_BLOB_KEY, blob, size)) != ESP_OK || (err = nvs_commit(flash_handle)) != ESP_OK) {
+        ESP_LOGW(TAG, "error (%s) saving config", esp_err_to_name(err));
+        __atomic_store_n(&save_pending, true, __ATOMIC_RELAXED);
+        result = -2;
+    } else {
+
+        // Once the blob is safely committed, the per-item strings it replaced can go
+        if (legacy_present) {
+            for (int key = 0; key < CONFIG_COUNT; key ++) {
+                nvs_erase_key(flash_handle, config[key].name);
+            }
+            nvs_commit(flash_handle);
+            legacy_present = false;
         }
 
-        // Write the value (or the default if not yet set)
-        err = nvs_set_str(
-            flash_handle,
-            config[cfg_idx].key,
-            config[cfg_idx].value != NULL ? config[cfg_idx].value : config[cfg_idx].default_value
-        );
-
-        ESP_ERROR_CHECK(err);
+        ESP_LOGI(TAG, "saved config (%dB) in %lldus", size, esp_timer_get_time() - start);
     }
 
-    // Commit
-    err = nvs_commit(flash_handle);
-   if (err != ESP_OK) {
-        ESP_LOGI(TAG, "error (%s) committing NVS", esp_err_to_name(err));
-        return -2;
+    nvs_close(flash_handle);
+    free(blob);
+    xSemaphoreGive(write_lock);
+    return result;
+}
+
+/**
+ * Request that configuration is saved to NVS.
+ * Saves are coalesced and written by the background writer task, so this returns immediately
+ * (unless the writer isn't running yet, in which case it writes straight away).
+ */
+int config_save()
+{
+    save_pending = true;
+
+    if (writer_task == NULL) {
+        return config_write();
     }
 
-    // Finished reading flash data, close the handle
-    nvs_close(flash_handle);
+    xTaskNotifyGive(writer_task);
     return 0;
 }
 
 /**
- * Find a configuration item by key, returning a pointer to it.
+ * Write any pending save now, e.g. before restarting.
  */
-config_entry_t* config_find(const char* key)
+int config_flush()
 {
-    for (int cfg_idx = 0; cfg_idx < sizeof(config) / sizeof(config_entry_t); cfg_idx ++) {
-        if (strcmp(config[cfg_idx].key, key) == 0) {
-            return &config[cfg_idx];
+    return config_write();
+}
+
+/**
+ * Register the task that writes coalesced saves, which calls config_write() when notified.
+ */
+void config_set_writer(TaskHandle_t task)
+{
+    writer_task = task;
+}
+
+/**
+ * Find a configuration key by name, e.g. for the console.
+ * Returns the key, or -1 if there's no such item.
+ */
+int config_find(const char* name)
+{
+    for (int key = 0; key < CONFIG_COUNT; key ++) {
+        if (strcmp(config[key].name, name) == 0) {
+            return key;
         }
     }
 
-    return NULL;
+    return -1;
 }
 
 /**
- * Update a configuration value.
+ * Update a configuration value, if it's valid for the item, and notify anything subscribed to it.
  * Note: configuration is only persisted to storage upon config_save() being called.
  */
-int config_set(const char* key, const char* value)
+int config_set(config_key_t key, const char* value)
 {
-    // Find the item to update
-    config_entry_t* config_entry = config_find(key);
+    if (key >= CONFIG_COUNT) {
+        return -1;
+    }
+
+    config_entry_t* entry = &config[key];
+    int parsed;
 
-    if (config_entry == NULL) {
-        ESP_LOGW(TAG, "requested update of non-existent configuration entry: %s", key);
+    if (config_parse(entry, value, &parsed) != 0) {
+        ESP_LOGW(TAG, "invalid value for %s: %s", entry->name, value);
         return -1;
     }
 
-    // Free the previous value if one is present
-    if (config_entry->value != NULL) {
-        ESP_LOGI(TAG, "freeing previous config value for %s @ %p", key, (void*)config_entry->value);
-        free(config_entry->value);
+    // Refuse a value that would make the config too large to save, rather than failing when it's written
+    xSemaphoreTake(config_lock, portMAX_DELAY);
+    if (config_encoded_size(key, value) > CONFIG_BLOB_MAX) {
+        xSemaphoreGive(config_lock);
+        ESP_LOGW(TAG, "value for %s would make the config too large to save", entry->name);
+        return -1;
     }
 
-    // Allocate a new string and copy the new value into it
-    config_entry->value = malloc(strlen(value) + 1);
-    ESP_LOGI(TAG, "allocated space (%dB) for %s value @ %p", strlen(value) + 1, key, config_entry->value);
-    strcpy(config_entry->value, value);
-    config_entry->is_dirty = true;
+    config_store(entry, value, parsed);
+    entry->is_dirty = true;
+    xSemaphoreGive(config_lock);
 
+    config_notify(key);
     return 0;
 }
 
 /**
- * Retrieve a configuration value.
+ * Retrieve a configuration value as a string.
  */
-const char* config_get(const char* key)
+const char* config_get(config_key_t key)
 {
-    // Find the item
-    config_entry_t* config_entry = config_find(key);
-
-    if (config_entry == NULL) {
-        ESP_LOGW(TAG, "requested non-existent configuration entry: %s", key);
+    if (key >= CONFIG_COUNT) {
         return NULL;
     }
 
-    if (config_entry->value == NULL) {
-        return config_entry->default_value;
+    return config[key].value != NULL ? config[key].value : config[key].default_value;
+}
+
+/**
+ * Retrieve an integer value, or the option index of an enum value.
+ */
+int config_get_int(config_key_t key)
+{
+    if (key >= CONFIG_COUNT) {
+        return -1;
     }
 
-    return config_entry->value;
+    return config[key].parsed;
 }
 
 /**
- * Retrieve a configuration value as an integer.
+ * Call `callback` (from the task that made the change) whenever a configuration value changes.
  */
-int config_get_int(const char* key)
+int config_subscribe(config_key_t key, config_callback_t callback, void* arg)
 {
-    const char* value = config_get(key);
-    if (!value) {
+    // Tasks on both cores subscribe while config is loading, so this must come after config_init()
+    xSemaphoreTake(config_lock, portMAX_DELAY);
+
+    if (callback_count == CONFIG_MAX_CALLBACKS) {
+        xSemaphoreGive(config_lock);
+        ESP_LOGW(TAG, "no space for another config callback");
         return -1;
     }
 
-    return atoi(value);
-}
\ No newline at end of file
+    callbacks[callback_count].key = key;
+    callbacks[callback_count].callback = callback;
+    callbacks[callback_count].arg = arg;
+    callback_count ++;
+
+    xSemaphoreGive(config_lock);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <stddef.h>
+#include "debounce.h"
+
+static const char* event_names[] = {
+    [BUTTON_EVENT_PRESS] = "press",
+    [BUTTON_EVENT_RELEASE] = "release",
+    [BUTTON_EVENT_LONG_PRESS] = "long_press",
+    [BUTTON_EVENT_REPEAT] = "repeat"
+};
+
+/**
+ * Start a debouncer with the button settled in the given state.
+ */
+void debounce_init(debounce_t* debounce, bool pressed)
+{
+    debounce->raw = pressed;
+    debounce->edge_us = 0;
+    debounce->burst_us = 0;
+    debounce->settling = false;
+    debounce->pressed = pressed;
+    debounce->long_sent = false;
+    debounce->next_us = 0;
+}
+
+/**
+ * Record a raw edge. Each edge restarts the settling time.
+ */
+void debounce_edge(debounce_t* debounce, bool pressed, int64_t now_us)
+{
+    if (!debounce->settling) {
+        debounce->burst_us = now_us;
+        debounce->settling = true;
+    }
+
+    debounce->raw = pressed;
+    debounce->edge_us = now_us;
+}
+
+/**
+ * Advance the state machine to `now_us`.
+ * A burst that settles back at the level it started from (a glitch) produces no events.
+ */
+int debounce_poll(debounce_t* debounce, int64_t now_us, debounce_event_t* events)
+{
+    int count = 0;
+
+    if (debounce->settling && now_us - debounce->edge_us >= DEBOUNCE_SETTLE_US) {
+        debounce->settling = false;
+
+        if (debounce->raw != debounce->pressed) {
+            debounce->pressed = debounce->raw;
+            events[count].type = debounce->pressed ? BUTTON_EVENT_PRESS : BUTTON_EVENT_RELEASE;
+            events[count].time_us = debounce->burst_us;
+            count ++;
+
+            if (debounce->pressed) {
+                debounce->long_sent = false;
+                debounce->next_us = debounce->burst_us + DEBOUNCE_LONG_PRESS_US;
+            }
+        }
+    }
+
+    // Hold timing pauses while edges are settling, as they may turn out to be a release
+    if (debounce->pressed && !debounce->settling && now_us >= debounce->next_us) {
+        events[count].type = debounce->long_sent ? BUTTON_EVENT_REPEAT : BUTTON_EVENT_LONG_PRESS;
+        events[count].time_us = debounce->next_us;
+        count ++;
+
+        debounce->long_sent = true;
+        debounce->next_us += DEBOUNCE_REPEAT_US;
+    }
+
+    return count;
+}
+
+/**
+ * When the state machine next needs polling, or -1 if nothing will happen until another edge.
+ */
+int64_t debounce_deadline(const debounce_t* debounce)
+{
+    if (debounce->settling) {
+        return debounce->edge_us + DEBOUNCE_SETTLE_US;
+    }
+
+    return debounce->pressed ? debounce->next_us : -1;
+}
+
+/**
+ * The name of an event type.
+ */
+const char* debounce_event_name(button_event_type_t type)
+{
+    return type <= BUTTON_EVENT_REPEAT ? event_names[type] : NULL;
+}
@@ -15,6 +15,7 @@ The display is arranged like this, with chip resposibility represented by #, @ a
 #include <string.h>
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "dlog.h"
 #include "display.h"
 #include "is32.h"
 #include "pins.h"
@@ -56,58 +57,212 @@ void display_init(int gcr)
 }
 
 /**
- * Write the display.
+ * Change the global current control (overall brightness) of every chip.
  */
-void display_update(display_t* display)
+void display_set_gcr(int gcr)
 {
-    // PWM data for a single chip - 4 bytes per LED
-    uint8_t chip_pwm[IS32_WIDTH * IS32_HEIGHT * 4] = {0};
-
-    // On-Off data for a single chip - 4 bits per LED
-    uint8_t chip_on_off[(IS32_WIDTH * IS32_HEIGHT) / 2] = {0};
+    for (uint chip = 0; chip < IS32_CHIPS; chip ++) {
+        is32_write_reg(chip_addrs[chip], IS32_REG_GLOBAL_CURRENT_CONTROL, gcr);
+    }
+}
 
-    // For each of the chips that control the entire display
+/**
+ * Put every chip into software shutdown (which keeps register contents), or back into run mode.
+ */
+void display_shutdown(bool shutdown)
+{
     for (uint chip = 0; chip < IS32_CHIPS; chip ++) {
+        is32_write_reg(chip_addrs[chip], IS32_REG_CONFIG, (shutdown ? IS32_SSD_SHUTDOWN : IS32_SSD_RUN) | (chip == 0 ? IS32_SYNC_MASTER : IS32_SYNC_SLAVE));
+    }
+}
 
-        for (uint row = 0; row < DISPLAY_HEIGHT; row ++) {
-            
-            // Calculate the last column for this chip, which may be bounded by the display width
-            uint last_col = (IS32_LAST_COL(chip) > DISPLAY_WIDTH) ? DISPLAY_WIDTH : IS32_LAST_COL(chip);
+/**
+ * Returns whether nothing on a display is lit.
+ */
+bool display_is_dark(const display_t* display)
+{
+    for (int x = 0; x < DISPLAY_WIDTH; x ++) {
+        for (int y = 0; y < DISPLAY_HEIGHT; y ++) {
+            if ((*display)[x][y].on && (*display)[x][y].pwm > 0) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
 
-            for (uint col = IS32_FIRST_COL(chip); col < last_col; col ++) {
+// Register bytes per chip: 4 PWM bytes and 4 on-off bits per LED, with each row a contiguous run
+#define CHIP_PWM_BYTES (IS32_WIDTH * IS32_HEIGHT * 4)
+#define CHIP_PWM_ROW_BYTES (IS32_WIDTH * 4)
+#define CHIP_ON_OFF_BYTES ((IS32_WIDTH * IS32_HEIGHT) / 2)
+#define CHIP_ON_OFF_ROW_BYTES (IS32_WIDTH / 2)
 
-                uint chip_col = col - IS32_FIRST_COL(chip);
+// Bytes of addressing (chip address and start register) that precede each sequential write
+#define CHIP_WRITE_OVERHEAD 2
 
-                // Just use the lowest PWM byte and spread it to the other three
-                uint8_t pwm = (*display)[DISPLAY_WIDTH - 1 - col][row].pwm > 0xff ? 0xff : (*display)[DISPLAY_WIDTH - 1 - col][row].pwm & 0xff;
+/**
+ * Build the PWM and on-off register contents for one chip from a display.
+ */
+static void chip_registers(const display_t* display, uint chip, uint8_t* chip_pwm, uint8_t* chip_on_off)
+{
+    memset(chip_pwm, 0x00, CHIP_PWM_BYTES);
+    memset(chip_on_off, 0x00, CHIP_ON_OFF_BYTES);
 
-                // Build a list of PWM bytes to write to the chip
-                chip_pwm[(chip_col * 2) + (row * 32)] = pwm;
-                chip_pwm[(chip_col * 2) + (row * 32) + 1] = pwm;
-                chip_pwm[(chip_col * 2) + (row * 32) + 16] = pwm;
-                chip_pwm[(chip_col * 2) + (row * 32) + 17] = pwm;
+    // Calculate the last column for this chip, which may be bounded by the display width
+    uint last_col = (IS32_LAST_COL(chip) > DISPLAY_WIDTH) ? DISPLAY_WIDTH : IS32_LAST_COL(chip);
 
-                // Build the on-off bytes
-                if ((*display)[DISPLAY_WIDTH - 1 - col][row].on) {
-                    chip_on_off[(chip_col / 4) + (row * 4)] |= (0b11 << ((chip_col % 4) * 2));
-                    chip_on_off[(chip_col / 4) + (row * 4) + 2] |= (0b11 << ((chip_col % 4) * 2));
-                }
+    for (uint row = 0; row < DISPLAY_HEIGHT; row ++) {
+        for (uint col = IS32_FIRST_COL(chip); col < last_col; col ++) {
+
+            uint chip_col = col - IS32_FIRST_COL(chip);
+
+            // Just use the lowest PWM byte and spread it to the other three
+            uint8_t pwm = (*display)[DISPLAY_WIDTH - 1 - col][row].pwm > 0xff ? 0xff : (*display)[DISPLAY_WIDTH - 1 - col][row].pwm & 0xff;
+
+            // Build a list of PWM bytes to write to the chip
+            chip_pwm[(chip_col * 2) + (row * 32)] = pwm;
+            chip_pwm[(chip_col * 2) + (row * 32) + 1] = pwm;
+            chip_pwm[(chip_col * 2) + (row * 32) + 16] = pwm;
+            chip_pwm[(chip_col * 2) + (row * 32) + 17] = pwm;
+
+            // Build the on-off bytes
+            if ((*display)[DISPLAY_WIDTH - 1 - col][row].on) {
+                chip_on_off[(chip_col / 4) + (row * 4)] |= (0b11 << ((chip_col % 4) * 2));
+                chip_on_off[(chip_col / 4) + (row * 4) + 2] |= (0b11 << ((chip_col % 4) * 2));
+            }
+        }
+    }
+}
 
+/**
+ * Find the first and last bytes that differ within one row of registers, or -1 for both if none do.
+ */
+static void row_changes(const uint8_t* data, const uint8_t* previous, uint row_start, uint row_bytes, int* first, int* last)
+{
+    *first = -1;
+    *last = -1;
+    for (uint i = row_start; i < row_start + row_bytes; i ++) {
+        if (data[i] != previous[i]) {
+            if (*first < 0) {
+                *first = i;
             }
+            *last = i;
+        }
+    }
+}
+
+/**
+ * Write the registers of one chip that differ from what was last written to it.
+ * Returns false if any write failed.
+ *
+ * The registers are laid out a row (`row_bytes`) at a time. Changed bytes are sent either as one run from
+ * the first to the last change, or as a run per changed row, whichever puts fewer bytes on the bus.
+ */
+static bool chip_write_changed(is32_addr_t addr, uint16_t start_reg, const uint8_t* data, const uint8_t* previous, uint length, uint row_bytes)
+{
+    int first = -1;
+    int last = -1;
+    uint per_row_cost = 0;
+
+    for (uint row_start = 0; row_start < length; row_start += row_bytes) {
+        int row_first;
+        int row_last;
+        row_changes(data, previous, row_start, row_bytes, &row_first, &row_last);
+
+        if (row_first < 0) {
+            continue;
         }
 
+        if (first < 0) {
+            first = row_first;
+        }
+        last = row_last;
+        per_row_cost += CHIP_WRITE_OVERHEAD + row_last - row_first + 1;
+    }
+
+    // Nothing changed
+    if (first < 0) {
+        return true;
+    }
+
+    if (CHIP_WRITE_OVERHEAD + last - first + 1 <= per_row_cost) {
+        return is32_write_seq(addr, start_reg + first, &data[first], last - first + 1);
+    }
+
+    bool result = true;
+
+    for (uint row_start = 0; row_start < length; row_start += row_bytes) {
+        int row_first;
+        int row_last;
+        row_changes(data, previous, row_start, row_bytes, &row_first, &row_last);
+
+        if (row_first >= 0) {
+            result &= is32_write_seq(addr, start_reg + row_first, &data[row_first], row_last - row_first + 1);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Write the display, returning false if any write failed.
+ */
+bool display_update(display_t* display)
+{
+    bool result = true;
+
+    // PWM data for a single chip - 4 bytes per LED
+    uint8_t chip_pwm[CHIP_PWM_BYTES];
+
+    // On-Off data for a single chip - 4 bits per LED
+    uint8_t chip_on_off[CHIP_ON_OFF_BYTES];
+
+    // The whole frame goes out as one batch if the bus is using DMA
+    is32_batch_begin();
+
+    // For each of the chips that control the entire display
+    for (uint chip = 0; chip < IS32_CHIPS; chip ++) {
+
+        chip_registers(display, chip, chip_pwm, chip_on_off);
+
         // Write the chip's PWM register
-        is32_write_seq(chip_addrs[chip], IS32_REG_PWM_START, chip_pwm, IS32_WIDTH * IS32_HEIGHT * 4);
+        result &= is32_write_seq(chip_addrs[chip], IS32_REG_PWM_START, chip_pwm, CHIP_PWM_BYTES);
 
         // Write the chip's LED I/O register
-        is32_write_seq(chip_addrs[chip], IS32_REG_LED_ON_OFF_START, chip_on_off, (IS32_WIDTH * IS32_HEIGHT) / 2);
+        result &= is32_write_seq(chip_addrs[chip], IS32_REG_LED_ON_OFF_START, chip_on_off, CHIP_ON_OFF_BYTES);
+    }
+
+    result &= is32_batch_end();
+    return result;
+}
 
-        // Clear chip states ready for the next chip
-        memset(&chip_pwm, 0x00, sizeof(chip_pwm));
-        memset(&chip_on_off, 0x00, sizeof(chip_on_off));
+/**
+ * Write only the parts of the display that differ from `previous`, which must be what's on the panel.
+ * Chips with no changes aren't addressed at all, so an update confined to a small area costs a
+ * fraction of a full frame on the bus. Returns false if any write failed.
+ */
+bool display_update_changed(const display_t* display, const display_t* previous)
+{
+    bool result = true;
+    uint8_t chip_pwm[CHIP_PWM_BYTES];
+    uint8_t chip_on_off[CHIP_ON_OFF_BYTES];
+    uint8_t previous_pwm[CHIP_PWM_BYTES];
+    uint8_t previous_on_off[CHIP_ON_OFF_BYTES];
+
+    is32_batch_begin();
+
+    for (uint chip = 0; chip < IS32_CHIPS; chip ++) {
+
+        chip_registers(display, chip, chip_pwm, chip_on_off);
+        chip_registers(previous, chip, previous_pwm, previous_on_off);
+
+        result &= chip_write_changed(chip_addrs[chip], IS32_REG_PWM_START, chip_pwm, previous_pwm, CHIP_PWM_BYTES, CHIP_PWM_ROW_BYTES);
+        result &= chip_write_changed(chip_addrs[chip], IS32_REG_LED_ON_OFF_START, chip_on_off, previous_on_off, CHIP_ON_OFF_BYTES, CHIP_ON_OFF_ROW_BYTES);
     }
 
-    return;
+    result &= is32_batch_end();
+    return result;
 }
 
 /**
@@ -168,7 +323,7 @@ void display_rect(display_t* display, int x_pos, int y_pos, int width, int heigh
  */
 void display_copy(const display_t* source, display_t* dest, int src_x_pos, int src_y_pos, int dest_x_pos, int dest_y_pos, int width, int height)
 {
-    ESP_LOGI(TAG, "copy: %p to %p (src: %d,%d, dst: %d,%d, size:%dby%d)", source, dest, src_x_pos, src_y_pos, dest_x_pos, dest_y_pos, width, height);
+    DLOGD(TAG, "copy: %08x to %08x (%dx%d)", (uint32_t)(uintptr_t)source, (uint32_t)(uintptr_t)dest, width, height);
     display_t* source_copy = malloc(sizeof(display_t));
     memcpy(source_copy, source, sizeof(display_t));
 
@@ -227,4 +382,19 @@ void display_checkerboard(display_t* display, bool invert, uint32_t pwm)
             (*display)[x][y].pwm = state ? pwm : 0;
         }
     }
+}
+
+/**
+ * Load a display state from packed PWM values.
+ * One byte per LED in column-major order (x * DISPLAY_HEIGHT + y), with 0 meaning off.
+ */
+void display_load_pwm(display_t* display, const uint8_t* pwm)
+{
+    for (int x = 0; x < DISPLAY_WIDTH; x ++) {
+        for (int y = 0; y < DISPLAY_HEIGHT; y ++) {
+            (*display)[x][y].pwm = *pwm;
+            (*display)[x][y].on = *pwm != 0;
+            pwm ++;
+        }
+    }
 }
\ No newline at end of file
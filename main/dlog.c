@@ -0,0 +1,106 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "dlog.h"
+
+/**
+ * Deferred logging: hot paths record events into a ring buffer, and the log task formats them later.
+ *
+ * The ring is single-consumer: only the log task (via dlog_drain) advances the tail. Writers reserve a
+ * slot under a spinlock, which is held for a handful of stores, so recording is safe from any task on
+ * either core.
+ */
+
+_Static_assert((DLOG_RECORDS & (DLOG_RECORDS - 1)) == 0, "DLOG_RECORDS must be a power of two");
+
+// Longest formatted message
+#define DLOG_LINE_LENGTH 160
+
+static dlog_record_t records[DLOG_RECORDS];
+static uint32_t head = 0;
+static uint32_t tail = 0;
+static uint32_t dropped = 0;
+static TaskHandle_t drain_task = NULL;
+static portMUX_TYPE dlog_mut = portMUX_INITIALIZER_UNLOCKED;
+
+// Level letters as used by ESP_LOGx, indexed by esp_log_level_t
+static const char level_letters[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+
+/**
+ * Record an event, or count it as dropped if the ring is full.
+ * The log task is woken when the ring goes from empty to not, so a burst costs one notification.
+ */
+void dlog_write(const dlog_format_t* format, const char* tag, const uint32_t* args, unsigned int count)
+{
+    uint32_t timestamp = esp_log_timestamp();
+
+    portENTER_CRITICAL(&dlog_mut);
+    if (head - tail == DLOG_RECORDS) {
+        dropped ++;
+        portEXIT_CRITICAL(&dlog_mut);
+        return;
+    }
+
+    bool was_empty = head == tail;
+    dlog_record_t* record = &records[head % DLOG_RECORDS];
+    record->format = format;
+    record->tag = tag;
+    record->timestamp = timestamp;
+    memcpy(record->args, args, count * sizeof(uint32_t));
+    head ++;
+    portEXIT_CRITICAL(&dlog_mut);
+
+    if (was_empty && drain_task != NULL) {
+        xTaskNotifyGive(drain_task);
+    }
+}
+
+/**
+ * Set the task that drains the ring.
+ */
+void dlog_set_drain(TaskHandle_t task)
+{
+    drain_task = task;
+}
+
+/**
+ * Format and write out every waiting record.
+ */
+int dlog_drain()
+{
+    int count = 0;
+
+    while (true) {
+        portENTER_CRITICAL(&dlog_mut);
+        bool empty = head == tail;
+        dlog_record_t record;
+        if (!empty) {
+            record = records[tail % DLOG_RECORDS];
+            tail ++;
+        }
+        portEXIT_CRITICAL(&dlog_mut);
+
+        if (empty) {
+            return count;
+        }
+
+        // Unused arguments are passed too, which is harmless with the 32-bit conversions records are limited to
+        char line[DLOG_LINE_LENGTH];
+        snprintf(line, sizeof(line), record.format->format, record.args[0], record.args[1], record.args[2], record.args[3]);
+        esp_log_write(
+            record.format->level, record.tag, "%c (%u) %s: %s\n",
+            level_letters[record.format->level], record.timestamp, record.tag, line
+        );
+        count ++;
+    }
+}
+
+/**
+ * Number of records dropped because the ring was full.
+ */
+uint32_t dlog_dropped()
+{
+    return dropped;
+}
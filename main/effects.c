@@ -0,0 +1,349 @@
+#include <string.h>
+#include "effects.h"
+#include "cycles.h"
+#include "stats.h"
+
+/**
+ * Procedural effects.
+ *
+ * An effect is a per-frame simulation step (`begin`, which must stay O(pixels)) followed by rendering
+ * each column in turn (`column`). Only integer arithmetic is used: waves come from a sine table and
+ * everything else from shifts and small multiplies.
+ */
+
+typedef struct effect_def {
+    const char* name;
+
+    // Per-frame budget in microseconds
+    uint32_t budget_us;
+
+    // Set up any state beyond zeroing (may be NULL)
+    void (*start)(effect_t* effect);
+
+    // Advance the simulation by one frame (may be NULL), then render a single column
+    void (*begin)(effect_t* effect);
+    void (*column)(effect_t* effect, display_t* display, unsigned int x);
+} effect_def_t;
+
+// One period of a sine wave, offset and scaled to 1..255
+static const uint8_t sin8_table[256] = {
+    128, 131, 134, 137, 140, 144, 147, 150, 153, 156, 159, 162, 165, 168, 171, 174,
+    177, 179, 182, 185, 188, 191, 193, 196, 199, 201, 204, 206, 209, 211, 213, 216,
+    218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 239, 240, 241, 243, 244,
+    245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255,
+    255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246,
+    245, 244, 243, 241, 240, 239, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220,
+    218, 216, 213, 211, 209, 206, 204, 201, 199, 196, 193, 191, 188, 185, 182, 179,
+    177, 174, 171, 168, 165, 162, 159, 156, 153, 150, 147, 144, 140, 137, 134, 131,
+    128, 125, 122, 119, 116, 112, 109, 106, 103, 100,  97,  94,  91,  88,  85,  82,
+     79,  77,  74,  71,  68,  65,  63,  60,  57,  55,  52,  50,  47,  45,  43,  40,
+     38,  36,  34,  32,  30,  28,  26,  24,  22,  21,  19,  17,  16,  15,  13,  12,
+     11,  10,   8,   7,   6,   6,   5,   4,   3,   3,   2,   2,   2,   1,   1,   1,
+      1,   1,   1,   1,   2,   2,   2,   3,   3,   4,   5,   6,   6,   7,   8,  10,
+     11,  12,  13,  15,  16,  17,  19,  21,  22,  24,  26,  28,  30,  32,  34,  36,
+     38,  40,  43,  45,  47,  50,  52,  55,  57,  60,  63,  65,  68,  71,  74,  77,
+     79,  82,  85,  88,  91,  94,  97, 100, 103, 106, 109, 112, 116, 119, 122, 125,
+};
+
+#define SIN8(angle) (sin8_table[(angle) & 0xff])
+
+/**
+ * Next value from the effect's xorshift32 generator.
+ */
+static inline uint32_t effect_rand(effect_t* effect)
+{
+    uint32_t x = effect->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    effect->rng = x;
+    return x;
+}
+
+/**
+ * Set a pixel, squaring the level so that low values fall away smoothly.
+ */
+static inline void effect_set(display_t* display, unsigned int x, unsigned int y, uint32_t level)
+{
+    (*display)[x][y].pwm = (level * level) >> 8;
+    (*display)[x][y].on = true;
+}
+
+/**
+ * Fade a column of a level buffer and copy it to the display.
+ */
+static void fade_column(uint8_t* level, display_t* display, unsigned int x)
+{
+    for (unsigned int y = 0; y < DISPLAY_HEIGHT; y ++) {
+        effect_set(display, x, y, level[y]);
+        level[y] -= (level[y] >> 2) + (level[y] ? 1 : 0);
+    }
+}
+
+/** Plasma: the sum of three travelling sine waves. **/
+
+static void plasma_column(effect_t* effect, display_t* display, unsigned int x)
+{
+    uint32_t t = effect->frame;
+    uint32_t wave_x = SIN8(x * 11 + t * 3);
+
+    for (unsigned int y = 0; y < DISPLAY_HEIGHT; y ++) {
+        uint32_t wave_y = SIN8(y * 37 - t * 2);
+        uint32_t wave_xy = SIN8((x + y) * 13 + SIN8(t) / 2);
+        effect_set(display, x, y, (wave_x + wave_y + wave_xy) / 3);
+    }
+}
+
+/** Fire: heat rises from a random row below the display and cools as it goes. **/
+
+static void fire_begin(effect_t* effect)
+{
+    uint8_t (*heat)[DISPLAY_HEIGHT + 1] = effect->data.heat;
+
+    for (unsigned int x = 0; x < DISPLAY_WIDTH; x ++) {
+        heat[x][DISPLAY_HEIGHT] = 128 + (effect_rand(effect) & 0x7f);
+    }
+
+    // Working top down means each row only reads the row below it from the previous frame
+    for (unsigned int y = 0; y < DISPLAY_HEIGHT; y ++) {
+        for (unsigned int x = 0; x < DISPLAY_WIDTH; x ++) {
+            uint32_t left = heat[x > 0 ? x - 1 : x][y + 1];
+            uint32_t right = heat[x < DISPLAY_WIDTH - 1 ? x + 1 : x][y + 1];
+            uint32_t sum = left + heat[x][y + 1] * 2 + right;
+            uint32_t cooling = effect_rand(effect) & 0x1f;
+            heat[x][y] = sum / 4 > cooling ? sum / 4 - cooling : 0;
+        }
+    }
+}
+
+static void fire_column(effect_t* effect, display_t* display, unsigned int x)
+{
+    for (unsigned int y = 0; y < DISPLAY_HEIGHT; y ++) {
+        effect_set(display, x, y, effect->data.heat[x][y]);
+    }
+}
+
+/** Noise: smoothly interpolated value noise drifting across the display. **/
+
+/**
+ * A pseudo-random lattice value for a cell.
+ */
+static inline uint32_t noise_lattice(uint32_t cx, uint32_t cy, uint32_t seed)
+{
+    uint32_t h = cx * 0x27d4eb2d ^ cy * 0x165667b1 ^ seed;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6d;
+    h ^= h >> 12;
+    return h & 0xff;
+}
+
+/**
+ * Smoothstep of an 8 bit fraction.
+ */
+static inline uint32_t noise_fade(uint32_t f)
+{
+    return (f * f * (3 * 256 - 2 * f)) >> 16;
+}
+
+static inline uint32_t noise_lerp(uint32_t a, uint32_t b, uint32_t f)
+{
+    return (a * (256 - f) + b * f) >> 8;
+}
+
+static void noise_column(effect_t* effect, display_t* display, unsigned int x)
+{
+    // Positions are 8.8 fixed point lattice coordinates: cells are 4 pixels wide and 3 tall
+    uint32_t px = x * 64 + effect->frame * 6;
+    uint32_t fx = noise_fade(px & 0xff);
+
+    for (unsigned int y = 0; y < DISPLAY_HEIGHT; y ++) {
+        uint32_t py = y * 85 + effect->frame * 2;
+        uint32_t fy = noise_fade(py & 0xff);
+        uint32_t cx = px >> 8;
+        uint32_t cy = py >> 8;
+
+        uint32_t top = noise_lerp(noise_lattice(cx, cy, effect->rng), noise_lattice(cx + 1, cy, effect->rng), fx);
+        uint32_t bottom = noise_lerp(noise_lattice(cx, cy + 1, effect->rng), noise_lattice(cx + 1, cy + 1, effect->rng), fx);
+        effect_set(display, x, y, noise_lerp(top, bottom, fy));
+    }
+}
+
+/** Sparkles: random pixels flash and fade. **/
+
+static void sparkles_begin(effect_t* effect)
+{
+    for (unsigned int n = 0; n < 2; n ++) {
+        uint32_t r = effect_rand(effect);
+        effect->data.level[(r >> 8) % DISPLAY_WIDTH][(r >> 16) % DISPLAY_HEIGHT] = 0xff;
+    }
+}
+
+static void sparkles_column(effect_t* effect, display_t* display, unsigned int x)
+{
+    fade_column(effect->data.level[x], display, x);
+}
+
+/** Bars: level meter bars chasing random heights. **/
+
+// Bar heights are in 1/32nds of a pixel
+#define BARS_SCALE 32
+
+static void bars_begin(effect_t* effect)
+{
+    if (effect->frame % 8 != 0) {
+        return;
+    }
+
+    for (unsigned int x = 0; x < DISPLAY_WIDTH; x ++) {
+        effect->data.bars.target[x] = effect_rand(effect) % (DISPLAY_HEIGHT * BARS_SCALE + 1);
+    }
+}
+
+static void bars_column(effect_t* effect, display_t* display, unsigned int x)
+{
+    // Ease a quarter of the way towards the target each frame
+    int height = effect->data.bars.height[x];
+    height += ((int)effect->data.bars.target[x] - height) / 4;
+    effect->data.bars.height[x] = height;
+
+    // Light from the bottom up, with a partially lit top pixel
+    for (unsigned int y = 0; y < DISPLAY_HEIGHT; y ++) {
+        int lit = height - (int)(DISPLAY_HEIGHT - 1 - y) * BARS_SCALE;
+        lit = lit < 0 ? 0 : lit > BARS_SCALE ? BARS_SCALE : lit;
+        effect_set(display, x, y, lit * 255 / BARS_SCALE);
+    }
+}
+
+/** Particles: a fountain drawn from a fixed pool of particles. **/
+
+// Velocities and gravity are in 8.8 fixed point pixels per frame
+#define PARTICLE_GRAVITY 12
+#define PARTICLE_SPAWN 2
+
+static void particles_start(effect_t* effect)
+{
+    for (unsigned int idx = 0; idx < EFFECT_PARTICLES; idx ++) {
+        effect->data.particles.free[idx] = idx;
+    }
+    effect->data.particles.free_count = EFFECT_PARTICLES;
+}
+
+static void particles_begin(effect_t* effect)
+{
+    // Spawn from the pool, never allocating
+    for (unsigned int n = 0; n < PARTICLE_SPAWN && effect->data.particles.free_count > 0; n ++) {
+        uint32_t r = effect_rand(effect);
+        effect_particle_t* p = &effect->data.particles.pool[effect->data.particles.free[-- effect->data.particles.free_count]];
+        p->x = (DISPLAY_WIDTH / 2) << 8;
+        p->y = (DISPLAY_HEIGHT - 1) << 8;
+        p->vx = (int)(r & 0xff) - 128;
+        p->vy = -160 - (int)((r >> 8) & 0x7f);
+        p->life = 24 + ((r >> 16) & 0x0f);
+    }
+
+    // Move the live particles, returning any that die or leave the display
+    for (unsigned int idx = 0; idx < EFFECT_PARTICLES; idx ++) {
+        effect_particle_t* p = &effect->data.particles.pool[idx];
+        if (p->life == 0) {
+            continue;
+        }
+
+        p->x += p->vx;
+        p->y += p->vy;
+        p->vy += PARTICLE_GRAVITY;
+
+        int x = p->x >> 8;
+        int y = p->y >> 8;
+        if (-- p->life == 0 || x < 0 || x >= DISPLAY_WIDTH || y >= DISPLAY_HEIGHT) {
+            p->life = 0;
+            effect->data.particles.free[effect->data.particles.free_count ++] = idx;
+            continue;
+        }
+
+        if (y >= 0) {
+            effect->data.particles.level[x][y] = 0xff;
+        }
+    }
+}
+
+static void particles_column(effect_t* effect, display_t* display, unsigned int x)
+{
+    fade_column(effect->data.particles.level[x], display, x);
+}
+
+static const effect_def_t effects[] = {
+    { .name = "plasma", .budget_us = 100, .column = &plasma_column },
+    { .name = "fire", .budget_us = 150, .begin = &fire_begin, .column = &fire_column },
+    { .name = "noise", .budget_us = 200, .column = &noise_column },
+    { .name = "sparkles", .budget_us = 50, .begin = &sparkles_begin, .column = &sparkles_column },
+    { .name = "bars", .budget_us = 50, .begin = &bars_begin, .column = &bars_column },
+    { .name = "particles", .budget_us = 75, .start = &particles_start, .begin = &particles_begin, .column = &particles_column }
+};
+
+#define EFFECT_COUNT (sizeof(effects) / sizeof(effect_def_t))
+
+/**
+ * Find an effect by name.
+ */
+int effect_find(const char* name)
+{
+    for (unsigned int idx = 0; idx < EFFECT_COUNT; idx ++) {
+        if (strcmp(effects[idx].name, name) == 0) {
+            return idx;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Name of the effect at `index`, for listing them.
+ */
+const char* effect_name(unsigned int index)
+{
+    return index < EFFECT_COUNT ? effects[index].name : NULL;
+}
+
+/**
+ * Start an effect.
+ */
+void effect_start(effect_t* effect, int index, uint32_t seed)
+{
+    memset(effect, 0, sizeof(effect_t));
+    effect->def = &effects[index];
+    effect->budget_cycles = effects[index].budget_us * CYCLES_PER_US;
+    effect->rng = seed ? seed : 0x9e3779b9;
+
+    if (effect->def->start != NULL) {
+        effect->def->start(effect);
+    }
+}
+
+/**
+ * Render (the rest of) a frame, stopping early if the budget runs out.
+ */
+bool effect_render(effect_t* effect, display_t* display)
+{
+    uint32_t start = cycles_now();
+
+    if (effect->column == 0) {
+        effect->frame ++;
+        if (effect->def->begin != NULL) {
+            effect->def->begin(effect);
+        }
+    }
+
+    while (effect->column < DISPLAY_WIDTH) {
+        effect->def->column(effect, display, effect->column ++);
+
+        if (effect->budget_cycles && effect->column < DISPLAY_WIDTH && cycles_now() - start > effect->budget_cycles) {
+            effect->overruns ++;
+            stats_render(cycles_now() - start);
+            return false;
+        }
+    }
+
+    effect->column = 0;
+    stats_render(cycles_now() - start);
+    return true;
+}
@@ -1,61 +1,378 @@
 #include <string.h>
 #include "display.h"
 #include "frame_buffer.h"
+#include "cycles.h"
+#include "i2c.h"
+#include "stats.h"
 #include "esp_log.h"
+#include "dlog.h"
+#include "esp_timer.h"
 
 frame_buffer_t frame_buffer;
 static const char* TAG = "FB";
 
 /**
- * Initialise the framebuffer.
+ * Initialise the framebuffer, with every slot free.
  */
 void fb_init()
 {
-    frame_buffer.dirty = true;
-    frame_buffer.sem = xSemaphoreCreateBinary();
-    xSemaphoreGive(frame_buffer.sem);
+    frame_buffer.ready = xQueueCreate(FB_SLOTS, sizeof(uint8_t));
+    frame_buffer.free = xQueueCreate(FB_SLOTS, sizeof(uint8_t));
+    for (uint8_t slot = 0; slot < FB_SLOTS; slot ++) {
+        xQueueSend(frame_buffer.free, &slot, 0);
+    }
+
+    frame_buffer.latest = -1;
+    frame_buffer.latest_flushed = false;
+    frame_buffer.latest_lock = xSemaphoreCreateMutex();
+    frame_buffer.bus = xSemaphoreCreateMutex();
 }
 
 /**
- * Push a new frame.
+ * Take a free slot, waiting up to `timeout` for one.
  */
-void fb_push(display_t* new)
+static display_t* fb_take(TickType_t timeout)
 {
-    // Acquire the semaphore for the frame buffer
-    // if we can't update the current frame, just drop this one and try again next time
-    if (xSemaphoreTake(frame_buffer.sem, 0) == pdTRUE) {
+    uint8_t slot;
+    if (xQueueReceive(frame_buffer.free, &slot, timeout) != pdTRUE) {
+        stats_push(true);
+        return NULL;
+    }
 
-        // Copy the frame into place
-        memcpy(frame_buffer.frame, new, sizeof(display_t));
+    return &frame_buffer.frames[slot];
+}
 
-        // Mark the frame as dirty
-        frame_buffer.dirty = true;
+/**
+ * Hand back a slot the display task has finished flushing.
+ * The latest frame stays out of the free list, as fb_acquire() copies from it.
+ */
+static void fb_release(uint8_t slot)
+{
+    xSemaphoreTake(frame_buffer.latest_lock, portMAX_DELAY);
+    bool keep = slot == frame_buffer.latest;
+    if (keep) {
+        frame_buffer.latest_flushed = true;
+    }
+    xSemaphoreGive(frame_buffer.latest_lock);
 
-        xSemaphoreGive(frame_buffer.sem);
+    if (!keep) {
+        xQueueSend(frame_buffer.free, &slot, 0);
+    }
+}
 
+/**
+ * Queue a copy of a frame.
+ * Returns the queue depth after pushing, or -1 if no slot came free within `timeout` and the frame was dropped.
+ */
+int fb_push(const display_t* frame, TickType_t timeout)
+{
+    display_t* slot = fb_take(timeout);
+    if (slot == NULL) {
+        DLOGD(TAG, "frame queue full, dropping frame");
+        return -1;
+    }
+
+    memcpy(slot, frame, sizeof(display_t));
+    return fb_commit(slot, true);
+}
+
+/**
+ * Acquire a slot to render into in place, e.g. to decode straight into it.
+ * The slot starts as a copy of the latest frame, so partial updates (deltas, regions) can be applied to it.
+ * Returns NULL (counting a dropped frame) if no slot came free within `timeout`.
+ * Every successful call must be followed by fb_commit().
+ */
+display_t* fb_acquire(TickType_t timeout)
+{
+    display_t* frame = fb_take(timeout);
+    if (frame == NULL) {
+        return NULL;
+    }
+
+    xSemaphoreTake(frame_buffer.latest_lock, portMAX_DELAY);
+    if (frame_buffer.latest >= 0) {
+        memcpy(frame, &frame_buffer.frames[frame_buffer.latest], sizeof(display_t));
+    }
+    xSemaphoreGive(frame_buffer.latest_lock);
+
+    return frame;
+}
+
+/**
+ * Queue a slot to be shown at `present_us` (0 for as soon as possible).
+ * Returns the queue depth afterwards.
+ */
+static int fb_queue(uint8_t slot, int64_t present_us)
+{
+    // This becomes the latest frame; the previous one can be reused once it has been flushed
+    xSemaphoreTake(frame_buffer.latest_lock, portMAX_DELAY);
+    int previous = frame_buffer.latest;
+    bool previous_flushed = frame_buffer.latest_flushed;
+    frame_buffer.latest = slot;
+    frame_buffer.latest_flushed = false;
+    xSemaphoreGive(frame_buffer.latest_lock);
+
+    if (previous >= 0 && previous_flushed) {
+        uint8_t previous_slot = previous;
+        xQueueSend(frame_buffer.free, &previous_slot, 0);
+    }
+
+    frame_buffer.committed_us[slot] = esp_timer_get_time();
+    frame_buffer.present_us[slot] = present_us;
+    xQueueSend(frame_buffer.ready, &slot, 0);
+    stats_push(false);
+
+    int depth = fb_depth();
+    stats_queue(depth);
+    return depth;
+}
+
+/**
+ * Queue a slot acquired with fb_acquire() for display, or release it if it wasn't changed.
+ * Returns the queue depth afterwards.
+ */
+int fb_commit(display_t* frame, bool changed)
+{
+    uint8_t slot = frame - frame_buffer.frames;
+
+    if (!changed) {
+        xQueueSend(frame_buffer.free, &slot, 0);
+        return fb_depth();
+    }
+
+    return fb_queue(slot, 0);
+}
+
+/**
+ * Queue a slot acquired with fb_acquire() to be shown at `present_us`, e.g. in step with other panels.
+ * Frames are shown in the order they're committed, so one held for its time holds up those behind it.
+ * Returns the queue depth afterwards.
+ */
+int fb_commit_at(display_t* frame, int64_t present_us)
+{
+    return fb_queue(frame - frame_buffer.frames, present_us);
+}
+
+/**
+ * When the next queued frame is to be shown: its presentation time, 0 if it has none, or -1 if nothing is queued.
+ */
+int64_t fb_due()
+{
+    uint8_t slot;
+    if (xQueuePeek(frame_buffer.ready, &slot, 0) != pdTRUE) {
+        return -1;
+    }
+
+    return frame_buffer.present_us[slot];
+}
+
+/**
+ * Number of frames waiting to be flushed.
+ */
+int fb_depth()
+{
+    return uxQueueMessagesWaiting(frame_buffer.ready);
+}
+
+/**
+ * Flush a frame, with the bus held, unless it matches what's already shown.
+ * Returns true if the panel changed.
+ */
+static bool fb_flush(const display_t* frame)
+{
+    if (frame_buffer.shown_valid && memcmp(&frame_buffer.shown, frame, sizeof(display_t)) == 0) {
+        stats_unchanged();
+        return false;
+    }
+
+    uint32_t start = cycles_now();
+    uint32_t bytes_start = i2c_bytes_sent();
+    bool written;
+    if (frame_buffer.shown_valid) {
+        written = display_update_changed(frame, &frame_buffer.shown);
     } else {
-        ESP_LOGW(TAG, "couldn't obtain framebuffer sem, dropping frame");
+        written = display_update((display_t*)frame);
+    }
+    stats_flush(cycles_now() - start, i2c_bytes_sent() - bytes_start);
+    if (frame_buffer.on_flush != NULL) {
+        frame_buffer.on_flush(frame);
     }
+
+    // If a write failed the panel may not match the frame, and only a full write will put it right:
+    // deltas against it would skip the registers that didn't take
+    memcpy(&frame_buffer.shown, frame, sizeof(display_t));
+    frame_buffer.shown_valid = written;
+    if (!written) {
+        DLOGW(TAG, "flush failed, next frame written in full");
+    }
+    return true;
 }
 
 /**
- * Write the current frame.
- * Returns true if the display needed an update, or false otherwise.
+ * Detach the running animation, with the bus held, leaving its last frame as the latest one so
+ * fb_acquire() carries on from it.
  */
-bool fb_write()
+static void fb_animation_end()
 {
-    // Acquire the semaphore and write the display state
-    if (xSemaphoreTake(frame_buffer.sem, 25 / portTICK_PERIOD_MS) == pdTRUE) {
+    frame_buffer.animation = NULL;
+    if (frame_buffer.shown_valid) {
+        fb_push(&frame_buffer.shown, 0);
+    }
+}
 
-        if (!frame_buffer.dirty) {
-            xSemaphoreGive(frame_buffer.sem);
-            return false;
+/**
+ * Render and flush the next frame of the running animation, if there is one.
+ * Returns true if the panel changed.
+ */
+static bool fb_write_animation()
+{
+    fb_animation_t* finished = NULL;
+    bool changed = false;
+
+    xSemaphoreTake(frame_buffer.bus, portMAX_DELAY);
+    fb_animation_t* animation = frame_buffer.animation;
+    if (animation != NULL) {
+        uint32_t start = cycles_now();
+        const display_t* frame = animation->render(animation, esp_timer_get_time());
+        stats_render(cycles_now() - start);
+
+        if (frame != NULL) {
+            changed = fb_flush(frame);
         }
 
-        display_update(&(frame_buffer.frame));
-        frame_buffer.dirty = false;
-        xSemaphoreGive(frame_buffer.sem);
+        if (animation->is_finished) {
+            fb_animation_end();
+            finished = animation;
+        }
     }
-    
-    return true;
+    xSemaphoreGive(frame_buffer.bus);
+
+    if (finished != NULL && finished->notify != NULL) {
+        xTaskNotifyGive(finished->notify);
+    }
+
+    return changed;
+}
+
+/**
+ * Flush the next queued frame or, with none queued, the next frame of the running animation.
+ * A frame queued with a presentation time isn't flushed before then, and nothing else is meanwhile.
+ * Returns true if the panel changed, or false if there was nothing to flush or it matched what's already shown.
+ */
+bool fb_write()
+{
+    int64_t due = fb_due();
+    if (due > esp_timer_get_time()) {
+        return false;
+    }
+
+    uint8_t slot;
+    if (due < 0 || xQueueReceive(frame_buffer.ready, &slot, 0) != pdTRUE) {
+        return fb_write_animation();
+    }
+
+    if (frame_buffer.present_us[slot] != 0) {
+        stats_present(esp_timer_get_time() - frame_buffer.present_us[slot]);
+    }
+
+    xSemaphoreTake(frame_buffer.bus, portMAX_DELAY);
+    bool changed = fb_flush(&frame_buffer.frames[slot]);
+    xSemaphoreGive(frame_buffer.bus);
+
+    fb_release(slot);
+    return changed;
+}
+
+/**
+ * Hand an animation to the display task, which renders it at each refresh until it finishes and then
+ * notifies `animation->notify`. Its first frame is rendered and queued here, which also wakes the display
+ * task if it's idle. Replaces any animation already running.
+ */
+void fb_animate(fb_animation_t* animation)
+{
+    animation->is_finished = false;
+    const display_t* frame = animation->render(animation, esp_timer_get_time());
+    if (frame != NULL) {
+        fb_push(frame, portMAX_DELAY);
+    }
+
+    xSemaphoreTake(frame_buffer.bus, portMAX_DELAY);
+    frame_buffer.animation = animation->is_finished ? NULL : animation;
+    xSemaphoreGive(frame_buffer.bus);
+}
+
+/**
+ * Stop an animation early. Once this returns the display task won't touch it again.
+ */
+void fb_stop(fb_animation_t* animation)
+{
+    xSemaphoreTake(frame_buffer.bus, portMAX_DELAY);
+    if (frame_buffer.animation == animation) {
+        fb_animation_end();
+    }
+    xSemaphoreGive(frame_buffer.bus);
+}
+
+/**
+ * Whether the display task has an animation to render.
+ */
+bool fb_animating()
+{
+    return frame_buffer.animation != NULL;
+}
+
+/**
+ * Block until a frame is queued (without taking it), for up to `timeout`.
+ * Returns the time the frame was committed, or -1 if none arrived.
+ */
+int64_t fb_wait(TickType_t timeout)
+{
+    uint8_t slot;
+    if (xQueuePeek(frame_buffer.ready, &slot, timeout) != pdTRUE) {
+        return -1;
+    }
+
+    return frame_buffer.committed_us[slot];
+}
+
+/**
+ * The frame currently on the panel. Only for use by the display task.
+ */
+const display_t* fb_shown()
+{
+    return &frame_buffer.shown;
+}
+
+/**
+ * Forget what's on the panel, so the next frame is written in full.
+ * Call after writing the display other than through the frame buffer, with the bus held.
+ */
+void fb_invalidate()
+{
+    frame_buffer.shown_valid = false;
+}
+
+/**
+ * Set a function to call with each frame once it has been flushed (e.g. to keep a copy of it).
+ * It runs on the display task, so it should be quick.
+ */
+void fb_on_flush(fb_flush_callback_t callback)
+{
+    frame_buffer.on_flush = callback;
+}
+
+/**
+ * Take exclusive ownership of the display bus until fb_unlock() is called.
+ */
+void fb_lock()
+{
+    xSemaphoreTake(frame_buffer.bus, portMAX_DELAY);
+}
+
+/**
+ * Release the display bus after fb_lock().
+ */
+void fb_unlock()
+{
+    xSemaphoreGive(frame_buffer.bus);
 }
@@ -10,6 +10,9 @@
            
 static const char* TAG = "I2C";
 
+// Total bytes clocked out by i2c_tx()
+static uint32_t tx_bytes = 0;
+
 /**
  * Set up the I2C GPIO pads.
  */
@@ -93,6 +96,8 @@ void i2c_stop()
  */
 bool i2c_tx(uint8_t data)
 {
+  tx_bytes ++;
+
   // Shift out `data`
   for (uint x = 8; x; x--) {
     if (data & 0x80) {
@@ -148,3 +153,19 @@ uint8_t i2c_rx(bool send_ack)
 
   return data;
 }
+
+/**
+ * Returns the total number of bytes transmitted so far.
+ */
+uint32_t i2c_bytes_sent()
+{
+  return tx_bytes;
+}
+
+/**
+ * Count bytes sent on the bus other than by i2c_tx(), i.e. by DMA.
+ */
+void i2c_bytes_add(uint32_t bytes)
+{
+  tx_bytes += bytes;
+}
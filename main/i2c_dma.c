@@ -0,0 +1,246 @@
+#include <string.h>
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_intr_alloc.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "driver/periph_ctrl.h"
+#include "rom/gpio.h"
+#include "rom/lldesc.h"
+#include "soc/gpio_sig_map.h"
+#include "soc/i2s_struct.h"
+#include "pins.h"
+#include "i2c.h"
+#include "i2c_dma.h"
+
+static const char* TAG = "I2C DMA";
+
+/**
+ * I2C writes clocked out of I2S0 by DMA.
+ *
+ * In LCD mode with 16-bit samples, I2S0 drives its parallel outputs from I2S0O_DATA_OUT8 up, a sample
+ * per 2 * I2C_DMA_BCK_DIV cycles of the 160MHz PLL_D2 clock divided by I2C_DMA_CLKM_DIV. SDA and SCL
+ * keep their open-drain pad configuration from i2c_init() while they're routed to it.
+ */
+
+// Sample rate divider from the 160MHz I2S base clock: 160MHz / (10 * 2 * 2) = 4MHz = 4 * I2C_DMA_SCL_HZ
+#define I2C_DMA_BCK_DIV 2
+#define I2C_DMA_CLKM_DIV (160000000 / (2 * I2C_DMA_BCK_DIV * I2C_WAVE_SYMBOL_SAMPLES * I2C_DMA_SCL_HZ))
+
+// First parallel output signal in 16-bit mode
+#define I2C_DMA_SIGNAL_BASE I2S0O_DATA_OUT8_IDX
+
+// How long to wait for the FIFO to drain once the last buffer has been read
+#define I2C_DMA_DRAIN_US 100
+
+static uint16_t* buffers[2];
+static lldesc_t descs[2];
+static i2c_wave_encoder_t encoder;
+static TaskHandle_t waiting = NULL;
+
+// The descriptor the DMA will finish with next, and how many it has yet to finish
+static int next_done = 0;
+static int in_flight = 0;
+static intr_handle_t interrupt;
+
+/**
+ * Fill a buffer from the encoder, ending the descriptor chain there if it's the last.
+ */
+static void IRAM_ATTR fill(int idx)
+{
+    size_t samples = i2c_wave_encode(&encoder, buffers[idx], I2C_DMA_BUFFER_SAMPLES);
+
+    descs[idx].length = samples * sizeof(uint16_t);
+    descs[idx].owner = 1;
+    descs[idx].qe.stqe_next = i2c_wave_done(&encoder) ? NULL : &descs[idx ^ 1];
+    in_flight ++;
+}
+
+/**
+ * Buffers have been read into the FIFO: refill them, or wake the writer once the last has been.
+ * Both may have been read by the time the interrupt is handled, so every descriptor the DMA has handed
+ * back (cleared its owner bit) is dealt with, in the order it reads them, not just the one
+ * out_eof_des_addr names.
+ */
+static void IRAM_ATTR i2c_dma_isr(void* arg)
+{
+    BaseType_t woken = pdFALSE;
+
+    if (I2S0.int_st.out_eof) {
+        while (in_flight > 0 && descs[next_done].owner == 0) {
+            int idx = next_done;
+            next_done ^= 1;
+            in_flight --;
+
+            if (descs[idx].qe.stqe_next == NULL) {
+                vTaskNotifyGiveFromISR(waiting, &woken);
+            } else if (!i2c_wave_done(&encoder)) {
+                fill(idx);
+            }
+        }
+    }
+
+    I2S0.int_clr.val = I2S0.int_st.val;
+
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+/**
+ * Route SDA and SCL to the I2S outputs, or back to their GPIOs (released high).
+ */
+static void route(bool to_i2s)
+{
+    if (to_i2s) {
+        gpio_matrix_out(PIN_SDA, I2C_DMA_SIGNAL_BASE + I2C_WAVE_SDA_BIT, false, false);
+        gpio_matrix_out(PIN_SCL, I2C_DMA_SIGNAL_BASE + I2C_WAVE_SCL_BIT, false, false);
+    } else {
+        gpio_set_level(PIN_SDA, 1);
+        gpio_set_level(PIN_SCL, 1);
+        gpio_matrix_out(PIN_SDA, SIG_GPIO_OUT_IDX, false, false);
+        gpio_matrix_out(PIN_SCL, SIG_GPIO_OUT_IDX, false, false);
+    }
+}
+
+/**
+ * Set up I2S0 for 16-bit parallel output by DMA.
+ */
+bool i2c_dma_init()
+{
+    for (int idx = 0; idx < 2; idx ++) {
+        buffers[idx] = heap_caps_malloc(I2C_DMA_BUFFER_SAMPLES * sizeof(uint16_t), MALLOC_CAP_DMA);
+        if (buffers[idx] == NULL) {
+            ESP_LOGE(TAG, "no DMA memory for buffers");
+            return false;
+        }
+
+        memset(&descs[idx], 0, sizeof(lldesc_t));
+        descs[idx].size = I2C_DMA_BUFFER_SAMPLES * sizeof(uint16_t);
+        descs[idx].buf = (uint8_t*)buffers[idx];
+        descs[idx].eof = 1;
+    }
+
+    periph_module_enable(PERIPH_I2S0_MODULE);
+
+    // Reset the peripheral, its FIFO and DMA
+    I2S0.conf.tx_reset = 1;
+    I2S0.conf.tx_reset = 0;
+    I2S0.conf.tx_fifo_reset = 1;
+    I2S0.conf.tx_fifo_reset = 0;
+    I2S0.lc_conf.out_rst = 1;
+    I2S0.lc_conf.out_rst = 0;
+
+    // LCD (parallel) mode, 16 bits per sample, one sample per FIFO word
+    I2S0.conf2.val = 0;
+    I2S0.conf2.lcd_en = 1;
+    I2S0.conf.val = 0;
+    I2S0.conf.tx_right_first = 1;
+    I2S0.conf.tx_mono = 1;
+    I2S0.conf1.val = 0;
+    I2S0.conf1.tx_pcm_bypass = 1;
+    I2S0.conf1.tx_stop_en = 1;
+    I2S0.conf_chan.val = 0;
+    I2S0.conf_chan.tx_chan_mod = 1;
+    I2S0.fifo_conf.val = 0;
+    I2S0.fifo_conf.tx_fifo_mod_force_en = 1;
+    I2S0.fifo_conf.tx_fifo_mod = 1;
+    I2S0.fifo_conf.tx_data_num = 32;
+    I2S0.fifo_conf.dscr_en = 1;
+    I2S0.timing.val = 0;
+
+    // The sample clock
+    I2S0.clkm_conf.val = 0;
+    I2S0.clkm_conf.clka_en = 0;
+    I2S0.clkm_conf.clkm_div_num = I2C_DMA_CLKM_DIV;
+    I2S0.clkm_conf.clkm_div_a = 1;
+    I2S0.clkm_conf.clkm_div_b = 0;
+    I2S0.clkm_conf.clk_en = 1;
+    I2S0.sample_rate_conf.val = 0;
+    I2S0.sample_rate_conf.tx_bits_mod = 16;
+    I2S0.sample_rate_conf.tx_bck_div_num = I2C_DMA_BCK_DIV;
+
+    // DMA, with an interrupt as each descriptor is read, and its owner bit cleared once it has been
+    I2S0.lc_conf.val = 0;
+    I2S0.lc_conf.out_eof_mode = 1;
+    I2S0.lc_conf.out_auto_wrback = 1;
+    I2S0.lc_conf.outdscr_burst_en = 1;
+    I2S0.lc_conf.out_data_burst_en = 1;
+    I2S0.int_ena.val = 0;
+    I2S0.int_clr.val = 0xFFFFFFFF;
+    I2S0.int_ena.out_eof = 1;
+
+    // In IRAM, so buffers are refilled on time even while flash is being written
+    esp_err_t err = esp_intr_alloc(ETS_I2S0_INTR_SOURCE, ESP_INTR_FLAG_IRAM, &i2c_dma_isr, NULL, &interrupt);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "unable to allocate interrupt: %d", err);
+        return false;
+    }
+
+    ESP_LOGI(TAG, "ready: SCL %dHz, %d sample buffers", I2C_DMA_SCL_HZ, I2C_DMA_BUFFER_SAMPLES);
+    return true;
+}
+
+/**
+ * Send a list of write transactions.
+ */
+bool i2c_dma_write(const i2c_wave_txn_t* txns, size_t count, TickType_t timeout)
+{
+    if (count == 0) {
+        return true;
+    }
+
+    // Counted as sent, as bit-banged bytes are, whether or not they're acknowledged
+    uint32_t bytes = 0;
+    for (size_t idx = 0; idx < count; idx ++) {
+        bytes += 2 + txns[idx].length;
+    }
+    i2c_bytes_add(bytes);
+
+    // Fill both buffers up front; the second is only used if the first isn't enough
+    i2c_wave_encoder_init(&encoder, txns, count, true);
+    next_done = 0;
+    in_flight = 0;
+    fill(0);
+    if (descs[0].qe.stqe_next != NULL) {
+        fill(1);
+    }
+
+    waiting = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0);
+
+    I2S0.conf.tx_fifo_reset = 1;
+    I2S0.conf.tx_fifo_reset = 0;
+    I2S0.lc_conf.out_rst = 1;
+    I2S0.lc_conf.out_rst = 0;
+    I2S0.int_clr.val = 0xFFFFFFFF;
+    I2S0.out_link.addr = (uint32_t)&descs[0];
+    I2S0.out_link.start = 1;
+
+    route(true);
+    I2S0.conf.tx_start = 1;
+
+    bool finished = ulTaskNotifyTake(pdTRUE, timeout) != 0;
+
+    // The last buffer is in the FIFO, not yet on the bus
+    if (finished) {
+        int64_t deadline = esp_timer_get_time() + I2C_DMA_DRAIN_US;
+        while (!I2S0.state.tx_idle && esp_timer_get_time() < deadline);
+    } else {
+        ESP_LOGW(TAG, "write of %u transactions timed out", (unsigned int)count);
+    }
+
+    I2S0.conf.tx_start = 0;
+    I2S0.out_link.stop = 1;
+    route(false);
+
+    // A transaction cut off part way leaves the chip mid-write until it sees a stop
+    if (!finished) {
+        i2c_stop();
+    }
+
+    return finished;
+}
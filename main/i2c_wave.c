@@ -0,0 +1,191 @@
+#include "i2c_wave.h"
+
+/**
+ * I2C waveform encoder and decoder.
+ *
+ * The encoder works a symbol (start, stop or bit) at a time, so it can stop whenever a buffer is full and
+ * carry on into the next one: i2c_dma refills each DMA buffer from it as the last one goes out.
+ */
+
+static inline void I2C_WAVE_IRAM put_symbol(uint16_t* out, uint16_t a, uint16_t b, uint16_t c, uint16_t d, bool swap)
+{
+    if (swap) {
+        out[0] = b;
+        out[1] = a;
+        out[2] = d;
+        out[3] = c;
+    } else {
+        out[0] = a;
+        out[1] = b;
+        out[2] = c;
+        out[3] = d;
+    }
+}
+
+/**
+ * Total samples for a list of transactions.
+ */
+size_t i2c_wave_samples(const i2c_wave_txn_t* txns, size_t count)
+{
+    size_t symbols = 0;
+    for (size_t idx = 0; idx < count; idx ++) {
+        symbols += I2C_WAVE_TXN_SYMBOLS(txns[idx].length);
+    }
+
+    return symbols * I2C_WAVE_SYMBOL_SAMPLES;
+}
+
+/**
+ * Start encoding a list of transactions.
+ */
+void i2c_wave_encoder_init(i2c_wave_encoder_t* encoder, const i2c_wave_txn_t* txns, size_t count, bool swap_halves)
+{
+    encoder->txns = txns;
+    encoder->count = count;
+    encoder->txn = 0;
+    encoder->symbol = 0;
+    encoder->swap_halves = swap_halves;
+}
+
+/**
+ * Whether every transaction has been encoded.
+ */
+bool I2C_WAVE_IRAM i2c_wave_done(const i2c_wave_encoder_t* encoder)
+{
+    return encoder->txn >= encoder->count;
+}
+
+/**
+ * Encode whole symbols into `samples` until it's full or every transaction is done.
+ * Returns the number of samples written (a multiple of I2C_WAVE_SYMBOL_SAMPLES).
+ */
+size_t I2C_WAVE_IRAM i2c_wave_encode(i2c_wave_encoder_t* encoder, uint16_t* samples, size_t max)
+{
+    size_t written = 0;
+
+    while (!i2c_wave_done(encoder) && written + I2C_WAVE_SYMBOL_SAMPLES <= max) {
+        const i2c_wave_txn_t* txn = &encoder->txns[encoder->txn];
+        uint32_t last = I2C_WAVE_TXN_SYMBOLS(txn->length) - 1;
+        uint16_t* out = &samples[written];
+
+        if (encoder->symbol == 0) {
+            put_symbol(out, I2C_WAVE_SDA | I2C_WAVE_SCL, I2C_WAVE_SDA | I2C_WAVE_SCL, I2C_WAVE_SCL, 0, encoder->swap_halves);
+        } else if (encoder->symbol == last) {
+            put_symbol(out, 0, I2C_WAVE_SCL, I2C_WAVE_SDA | I2C_WAVE_SCL, I2C_WAVE_SDA | I2C_WAVE_SCL, encoder->swap_halves);
+        } else {
+            uint32_t bit = encoder->symbol - 1;
+            uint32_t byte = bit / 9;
+            bit %= 9;
+
+            // The ACK bit releases SDA
+            uint16_t sda = I2C_WAVE_SDA;
+            if (bit < 8) {
+                uint8_t value = byte == 0 ? txn->address : byte == 1 ? txn->reg : txn->data[byte - 2];
+                sda = (value >> (7 - bit)) & 1 ? I2C_WAVE_SDA : 0;
+            }
+            put_symbol(out, sda, sda | I2C_WAVE_SCL, sda | I2C_WAVE_SCL, sda, encoder->swap_halves);
+        }
+
+        written += I2C_WAVE_SYMBOL_SAMPLES;
+        if (encoder->symbol == last) {
+            encoder->txn ++;
+            encoder->symbol = 0;
+        } else {
+            encoder->symbol ++;
+        }
+    }
+
+    return written;
+}
+
+/**
+ * Decode a sample stream as an I2C bus analyser would, from the lines' edges: a start or stop is SDA
+ * changing while SCL is high, and a bit is SDA as SCL rises, counted once SCL falls again (a stop raises
+ * SCL too, but SDA rises before SCL falls). The bus is taken to be idle (both lines high) before the first
+ * sample.
+ */
+int i2c_wave_decode(
+    const uint16_t* samples, size_t count, bool swap_halves,
+    i2c_wave_txn_t* txns, size_t max_txns, uint8_t* data, size_t data_size
+)
+{
+    uint16_t previous = I2C_WAVE_SDA | I2C_WAVE_SCL;
+    bool in_txn = false;
+    bool clocked = false;
+    bool latched = false;
+    size_t txn_count = 0;
+    size_t used = 0;
+    size_t bytes = 0;
+    uint32_t bit = 0;
+    uint8_t value = 0;
+    uint8_t header[2];
+
+    // Swapped samples come in pairs
+    if (swap_halves && count % 2 != 0) {
+        return -1;
+    }
+
+    for (size_t idx = 0; idx < count; idx ++) {
+        uint16_t sample = samples[swap_halves ? idx ^ 1 : idx];
+        bool scl_held = (previous & I2C_WAVE_SCL) && (sample & I2C_WAVE_SCL);
+
+        if (scl_held && (previous & I2C_WAVE_SDA) && !(sample & I2C_WAVE_SDA)) {
+
+            // Start: a repeated start without a stop isn't used
+            if (in_txn || txn_count >= max_txns) {
+                return -1;
+            }
+            in_txn = true;
+            clocked = false;
+            bytes = 0;
+            bit = 0;
+            value = 0;
+        } else if (scl_held && !(previous & I2C_WAVE_SDA) && (sample & I2C_WAVE_SDA)) {
+
+            // Stop: the transaction must have ended on a byte boundary, after its address and register
+            if (!in_txn || bit != 0 || bytes < 2) {
+                return -1;
+            }
+            txns[txn_count].address = header[0];
+            txns[txn_count].reg = header[1];
+            txns[txn_count].data = &data[used - (bytes - 2)];
+            txns[txn_count].length = bytes - 2;
+            txn_count ++;
+            in_txn = false;
+            clocked = false;
+        } else if (!(previous & I2C_WAVE_SCL) && (sample & I2C_WAVE_SCL)) {
+
+            // SCL rising: SDA is the bit, unless this turns out to be a stop
+            if (!in_txn) {
+                return -1;
+            }
+            clocked = true;
+            latched = (sample & I2C_WAVE_SDA) != 0;
+        } else if ((previous & I2C_WAVE_SCL) && !(sample & I2C_WAVE_SCL) && clocked) {
+
+            // SCL falling after a bit
+            clocked = false;
+            if (bit < 8) {
+                value = (value << 1) | (latched ? 1 : 0);
+                bit ++;
+            } else {
+                // The ACK bit ends the byte
+                if (bytes < 2) {
+                    header[bytes] = value;
+                } else if (used < data_size) {
+                    data[used ++] = value;
+                } else {
+                    return -1;
+                }
+                bytes ++;
+                bit = 0;
+                value = 0;
+            }
+        }
+
+        previous = sample;
+    }
+
+    // A transaction left open means the stream was cut short
+    return in_txn ? -1 : (int)txn_count;
+}
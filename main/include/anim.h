@@ -0,0 +1,82 @@
+//
+// Compressed animations, decoded frame by frame straight from (memory-mapped) flash.
+//
+
+#ifndef ANIM_H
+#define ANIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "display.h"
+
+/*
+
+An animation is a header followed by frame records, all little-endian:
+
+    anim_header_t
+    anim_frame_t, uint8 data[length]     (repeated frame_count times)
+
+Frame data is one of:
+
+    ANIM_KEY        the frame's DISPLAY_PIXELS PWM bytes (packed as for display_load_pwm()), RLE-encoded
+    ANIM_DELTA      the frame XORed with the previous frame, RLE-encoded
+
+The RLE scheme is a PackBits variant. Each run starts with a control byte c:
+
+    c < 0x80        c + 1 literal bytes follow
+    c >= 0x80       the next byte is repeated c - 0x80 + 3 times
+
+Animations are built with tools/anim_encode.py and written to the "anim" partition.
+
+*/
+
+#define ANIM_MAGIC "TXA1"
+#define ANIM_VERSION 1
+
+// Partition holding the animation (see partitions.csv)
+#define ANIM_PARTITION_LABEL "anim"
+#define ANIM_PARTITION_SUBTYPE 0x40
+
+typedef enum {
+    ANIM_KEY = 1,
+    ANIM_DELTA = 2
+} anim_frame_type_t;
+
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint16_t version;
+    uint16_t frame_count;
+    uint8_t width;
+    uint8_t height;
+    uint16_t reserved;
+    uint32_t data_length;
+} anim_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t reserved;
+    uint16_t duration_ms;
+    uint16_t length;
+} anim_frame_t;
+
+// Playback state - the animation data itself is never copied
+typedef struct {
+    const uint8_t* data;
+    const anim_header_t* header;
+
+    // Offset of the next frame record, and its index
+    size_t pos;
+    uint16_t frame_index;
+
+    // The most recently decoded frame and how long to show it
+    uint8_t frame[DISPLAY_PIXELS];
+    uint16_t duration_ms;
+} anim_t;
+
+// Methods
+int anim_open(anim_t* anim, const uint8_t* data, size_t size);
+bool anim_next(anim_t* anim);
+int anim_open_partition(anim_t* anim);
+
+#endif
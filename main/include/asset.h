@@ -0,0 +1,38 @@
+//
+// Images and fixed text compiled into flash at build time, and drawn with a single blit.
+//
+// Assets are listed in assets/assets.txt and converted by tools/asset_gen.py into main/assets.c and
+// main/include/assets.h, which names each one (ASSET_<NAME>) and lists their sizes.
+//
+
+#ifndef ASSET_H
+#define ASSET_H
+
+#include <stdint.h>
+#include "display.h"
+
+typedef enum {
+
+    // `width` * `height` PWM bytes, column by column (as display_load_pwm() takes them)
+    ASSET_FRAME,
+
+    // `width` bytes, one per column, bit n lighting row n
+    ASSET_COLUMNS
+} asset_format_t;
+
+typedef struct {
+    const char* name;
+    asset_format_t format;
+    uint16_t width;
+    uint8_t height;
+    const uint8_t* data;
+} asset_t;
+
+// Draw an asset with its top left at (x_pos, y_pos), overwriting every pixel it covers; `pwm` is the
+// brightness of lit pixels in column bitmaps (frames carry their own)
+void asset_blit(display_t* display, const asset_t* asset, int x_pos, int y_pos, uint32_t pwm);
+
+// Look an asset up by name, returning NULL if there's no such asset
+const asset_t* asset_find(const char* name);
+
+#endif
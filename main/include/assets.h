@@ -0,0 +1,29 @@
+//
+// Assets compiled into flash, by name.
+// Generated by tools/asset_gen.py from assets/assets.txt - do not edit.
+//
+//     name         format   size    bytes  source
+//     splash       columns  24x6       24  splash.pbm
+//     ramp         frame    24x6      144  ramp.pgm
+//     bench        columns  24x5       24  text:bench
+//     banner       columns  239x5     239  text:Welcome - this banner was rendered at build time
+//
+// 4 assets, 431 bytes of data.
+//
+
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "asset.h"
+
+typedef enum {
+    ASSET_SPLASH,
+    ASSET_RAMP,
+    ASSET_BENCH,
+    ASSET_BANNER,
+    ASSET_COUNT
+} asset_id_t;
+
+extern const asset_t assets[ASSET_COUNT];
+
+#endif
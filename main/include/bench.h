@@ -0,0 +1,39 @@
+//
+// Microbenchmarks for the render and flush hot paths.
+//
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+// Default and maximum number of samples taken per stage
+#define BENCH_DEFAULT_ITERATIONS 101
+#define BENCH_MAX_ITERATIONS 512
+
+// Results for a single benchmarked stage
+typedef struct {
+    const char* stage;
+    unsigned int iterations;
+    uint32_t min;
+    uint32_t median;
+    uint32_t p99;
+    uint32_t max;
+
+    // Bytes clocked out on the I2C bus per iteration
+    uint32_t wire_bytes;
+
+    // The stage's own per-iteration budget, or 0 if it doesn't have one
+    uint32_t budget;
+} bench_result_t;
+
+// Called with the results of each stage as it completes
+typedef void (*bench_report_t)(const bench_result_t* result);
+
+// Methods
+int bench_run(const char* stage, unsigned int iterations, bench_report_t report);
+void bench_print(const bench_result_t* result);
+const char* bench_stage_name(unsigned int index);
+void bench_set_frames(const uint8_t* frames, unsigned int count);
+
+#endif
@@ -0,0 +1,40 @@
+//
+// Boot instrumentation, and the first frame shown while the rest of the system comes up.
+//
+// Each boot phase is timestamped (microseconds since reset) with boot_mark(); `boot` on the console
+// prints them. The last frame flushed before a reset is kept in RTC memory so it can be put straight
+// back on the panel after a soft reset, rather than leaving it dark until content starts.
+//
+
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "display.h"
+
+// Maximum number of phases recorded
+#define BOOT_MAX_PHASES 16
+
+// Brightness of the splash shown when there's no last-known frame
+#define BOOT_SPLASH_PWM 0x20
+
+typedef struct {
+    const char* name;
+    int64_t us;
+} boot_phase_t;
+
+// Record that a phase has been reached (only the first time, for a given name)
+void boot_mark(const char* name);
+
+// Render the first frame: the last-known frame if it survived the reset, or a splash
+// Returns true if it's the last-known frame
+bool boot_splash(display_t* frame);
+
+// Keep a copy of a frame that has been flushed, to restore after a reset
+void boot_remember(const display_t* frame);
+
+// Print the boot timings
+void boot_print();
+
+#endif
@@ -1,16 +1,40 @@
+//
+// Buttons, read by GPIO edge interrupts and debounced by a timer (see debounce.h).
+//
+// Presses, releases, long presses and repeats are queued as timestamped events, so consumers block on
+// buttons_receive() rather than polling the pins.
+//
+
 #ifndef BUTTONS_H
 #define BUTTONS_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
 #include "pins.h"
+#include "debounce.h"
 
 typedef enum {
     BUTTON_A = PIN_BUTTON_A,
     BUTTON_B = PIN_BUTTON_B
 } button_t;
 
+// Number of buttons
+#define BUTTON_COUNT 2
+
+// How many events can be waiting before new ones are dropped
+#define BUTTON_QUEUE_LENGTH 16
+
+typedef struct {
+    button_t button;
+    button_event_type_t type;
+    int64_t time_us;
+} button_event_t;
+
 // Methods
 void buttons_init();
 bool button_is_pressed(button_t button);
+bool buttons_receive(button_event_t* event, TickType_t timeout);
+uint32_t buttons_dropped();
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,60 @@
+//
+// Virtual canvases: on/off content far wider than the display (up to CANVAS_MAX_WIDTH columns), drawn once
+// and shown through a DISPLAY_WIDTH-wide viewport.
+//
+// Columns are stored as in mono.h, a byte each, so moving the viewport costs nothing and showing it is a
+// copy of the columns it covers. A canvas can be allocated in internal RAM or PSRAM and drawn on, or be a
+// column asset used in place in flash, so a pre-composed banner scrolls with no rendering at all.
+//
+
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "display.h"
+#include "mono.h"
+#include "asset.h"
+
+// Widest canvas that can be allocated
+#define CANVAS_MAX_WIDTH 8192
+
+typedef enum {
+    CANVAS_INTERNAL,
+
+    // PSRAM if there is any, otherwise internal RAM
+    CANVAS_PSRAM,
+
+    // A column asset, read in place (and not drawn on)
+    CANVAS_FLASH
+} canvas_storage_t;
+
+typedef struct {
+    const uint8_t* columns;
+
+    // The same columns, or NULL for a flash-backed canvas
+    uint8_t* writable;
+
+    int width;
+    canvas_storage_t storage;
+
+    // Column shown at the left of the display; columns off either end of the canvas are blank
+    int viewport;
+} canvas_t;
+
+// Allocate a blank canvas, returning false if it's too wide or there's no memory for it
+bool canvas_init(canvas_t* canvas, int width, canvas_storage_t storage);
+
+// Show a column asset through a viewport, returning false if the asset isn't a column bitmap
+bool canvas_init_asset(canvas_t* canvas, const asset_t* asset);
+
+// Free an allocated canvas's columns
+void canvas_free(canvas_t* canvas);
+
+// Draw text at a given x-coordinate, as mono_text() does
+void canvas_text(canvas_t* canvas, int x_pos, const char* text);
+
+// Copy the columns under the viewport into a plane
+void canvas_view(const canvas_t* canvas, mono_t* window);
+
+#endif
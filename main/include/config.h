@@ -3,27 +3,72 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
-// Config key names
-#define CONFIG_WIFI_SSID "wifi_ssid"
-#define CONFIG_WIFI_PSK "wifi_psk"
-#define CONFIG_GCR "display_gcr"
+// Config keys, which index config[]
+typedef enum {
+    CONFIG_WIFI_SSID,
+    CONFIG_WIFI_PSK,
+    CONFIG_GCR,
+    CONFIG_STREAM_PORT,
+    CONFIG_SERIAL_BAUD,
+    CONFIG_PLAYLIST,
+    CONFIG_LOG_VERBOSITY,
+    CONFIG_IDLE_MODE,
+    CONFIG_ZONES,
+    CONFIG_SYNC_GROUP,
+    CONFIG_SYNC_PORT,
+    CONFIG_I2C_MODE,
+    CONFIG_COUNT
+} config_key_t;
+
+// Value types: integers are range checked and enums matched against their options when set,
+// and both are parsed once and cached
+typedef enum {
+    CONFIG_TYPE_STRING,
+    CONFIG_TYPE_INT,
+    CONFIG_TYPE_ENUM
+} config_type_t;
 
 typedef struct {
-    char* key;
-    char* value;
+
+    // Definition
+    const char* name;
+    config_type_t type;
     const char* default_value;
+    int min;
+    int max;
+    const char* const* options;
+
+    // Current value as a string (NULL while the default applies), the space allocated for it,
+    // and the parsed value for integers (or option index for enums)
+    char* value;
+    size_t capacity;
+    int parsed;
     bool is_dirty;
+
 } config_entry_t;
 
-extern config_entry_t config[];
-extern size_t config_count;
+// Called after a config value changes
+typedef void (*config_callback_t)(config_key_t key, void* arg);
+
+// Maximum number of change callbacks
+#define CONFIG_MAX_CALLBACKS 8
+
+extern config_entry_t config[CONFIG_COUNT];
 
 // Methods
+void config_init();
 int config_load();
 int config_save();
-const char* config_get(const char* key);
-int config_get_int(const char* key);
-int config_set(const char* key, const char* value);
+int config_flush();
+int config_write();
+void config_set_writer(TaskHandle_t task);
+int config_find(const char* name);
+const char* config_get(config_key_t key);
+int config_get_int(config_key_t key);
+int config_set(config_key_t key, const char* value);
+int config_subscribe(config_key_t key, config_callback_t callback, void* arg);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,42 @@
+//
+// A free-running cycle counter used for timing hot paths.
+// On target this is the Xtensa CCOUNT register, on host builds it's a monotonic clock in nanoseconds.
+//
+
+#ifndef CYCLES_H
+#define CYCLES_H
+
+#include <stdint.h>
+
+#ifdef HOST_BUILD
+
+#include <time.h>
+
+// Unit reported alongside cycle counts
+#define CYCLES_UNIT "ns"
+#define CYCLES_PER_US 1000
+
+static inline uint32_t cycles_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+#else
+
+#include "sdkconfig.h"
+#include "xtensa/core-macros.h"
+
+// Unit reported alongside cycle counts
+#define CYCLES_UNIT "cycles"
+#define CYCLES_PER_US CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ
+
+static inline uint32_t cycles_now()
+{
+    return XTHAL_GET_CCOUNT();
+}
+
+#endif
+
+#endif
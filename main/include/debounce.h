@@ -0,0 +1,70 @@
+//
+// Button debouncing and gesture state machine.
+//
+// Raw edges are fed in as they happen (from the GPIO interrupt) and debounce_poll() is called at or
+// after debounce_deadline() (from a timer). A new level is accepted once it has been stable for
+// DEBOUNCE_SETTLE_US, and events are timestamped with the first edge of the burst, so bounce adds
+// latency but not timestamp error. Holding a button gives a long press, then repeats.
+//
+// This has no dependencies on the RTOS or drivers, so it can be driven by synthetic edges on the host.
+//
+
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// How long a level must be stable to be accepted
+#define DEBOUNCE_SETTLE_US 5000
+
+// How long a button is held before a long press, and the interval between repeats after that
+#define DEBOUNCE_LONG_PRESS_US 800000
+#define DEBOUNCE_REPEAT_US 200000
+
+// Most events a single poll can produce
+#define DEBOUNCE_MAX_EVENTS 2
+
+typedef enum {
+    BUTTON_EVENT_PRESS,
+    BUTTON_EVENT_RELEASE,
+    BUTTON_EVENT_LONG_PRESS,
+    BUTTON_EVENT_REPEAT
+} button_event_type_t;
+
+typedef struct {
+    button_event_type_t type;
+    int64_t time_us;
+} debounce_event_t;
+
+typedef struct {
+
+    // The raw level, when it last changed, and when the current burst of edges started
+    bool raw;
+    int64_t edge_us;
+    int64_t burst_us;
+    bool settling;
+
+    // The debounced state, and when the next long press or repeat is due while pressed
+    bool pressed;
+    bool long_sent;
+    int64_t next_us;
+
+} debounce_t;
+
+// Start in a known state
+void debounce_init(debounce_t* debounce, bool pressed);
+
+// Record a raw edge
+void debounce_edge(debounce_t* debounce, bool pressed, int64_t now_us);
+
+// Advance to `now_us`, writing up to DEBOUNCE_MAX_EVENTS events and returning how many
+int debounce_poll(debounce_t* debounce, int64_t now_us, debounce_event_t* events);
+
+// When debounce_poll() next needs calling, or -1 if not until another edge
+int64_t debounce_deadline(const debounce_t* debounce);
+
+// Name of an event type
+const char* debounce_event_name(button_event_type_t type);
+
+#endif
@@ -7,6 +7,7 @@
 // Define the width and height of the full display
 #define DISPLAY_WIDTH 24
 #define DISPLAY_HEIGHT 6
+#define DISPLAY_PIXELS (DISPLAY_WIDTH * DISPLAY_HEIGHT)
 
 // Define the maximum area covered by each chip
 #define IS32_WIDTH 8
@@ -51,11 +52,16 @@ typedef column_t display_t[DISPLAY_WIDTH];
 
 // Procs
 void display_init();
-void display_update(display_t* display);
+bool display_update(display_t* display);
+bool display_update_changed(const display_t* display, const display_t* previous);
+void display_set_gcr(int gcr);
+void display_shutdown(bool shutdown);
+bool display_is_dark(const display_t* display);
 void display_fill(display_t* display, uint32_t pwm, bool on);
 void display_checkerboard(display_t* display, bool invert, uint32_t pwm);
 void display_text(display_t* display, int x_pos, uint32_t pwm, const char* text);
 void display_rect(display_t* display, int x_pos, int y_pos, int width, int height, uint32_t pwm, bool on);
 void display_copy(const display_t* source, display_t* dest, int src_x_pos, int src_y_pos, int dest_x_pos, int dest_y_pos, int width, int height);
+void display_load_pwm(display_t* display, const uint8_t* pwm);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,72 @@
+//
+// Deferred logging for hot paths (rendering, flushing, transitions).
+//
+// DLOGx(tag, format, ...) records the tag, a pointer to the (static) format and up to DLOG_MAX_ARGS
+// 32-bit arguments in a ring buffer, which the low-priority log task formats and writes out later through
+// the normal log output. Recording is a few dozen cycles and never blocks; if the ring is full the
+// record is dropped and counted.
+//
+// Arguments are stored as uint32_t, so formats may only use 32-bit conversions (%d, %u, %x, %c), with
+// pointers cast to uint32_t, and strings must be static. Levels above DLOG_LEVEL (which can be
+// defined before including this file) compile to nothing; the runtime log level still applies when
+// records are written out.
+//
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#ifndef DLOG_LEVEL
+#define DLOG_LEVEL ESP_LOG_INFO
+#endif
+
+// Maximum arguments per record, and the number of records the ring holds (a power of two)
+#define DLOG_MAX_ARGS 4
+#define DLOG_RECORDS 64
+
+// A log statement's level and format, kept in rodata and referred to by pointer
+typedef struct {
+    esp_log_level_t level;
+    const char* format;
+} dlog_format_t;
+
+typedef struct {
+    const dlog_format_t* format;
+    const char* tag;
+    uint32_t timestamp;
+    uint32_t args[DLOG_MAX_ARGS];
+} dlog_record_t;
+
+// Record an event; use the DLOGx macros rather than calling this directly
+void dlog_write(const dlog_format_t* format, const char* tag, const uint32_t* args, unsigned int count);
+
+// Set the task to notify when records are waiting
+void dlog_set_drain(TaskHandle_t task);
+
+// Write out every waiting record, returning how many there were
+int dlog_drain();
+
+// Number of records dropped because the ring was full
+uint32_t dlog_dropped();
+
+#define DLOG_WRITE(level, tag, format, ...) do { \
+    if ((level) <= DLOG_LEVEL) { \
+        static const dlog_format_t dlog_format_ = { (level), (format) }; \
+        const uint32_t dlog_args_[] = { 0, ##__VA_ARGS__ }; \
+        _Static_assert(sizeof(dlog_args_) / sizeof(uint32_t) - 1 <= DLOG_MAX_ARGS, "too many log arguments"); \
+        dlog_write(&dlog_format_, (tag), &dlog_args_[1], sizeof(dlog_args_) / sizeof(uint32_t) - 1); \
+    } \
+} while (0)
+
+#define DLOGE(tag, format, ...) DLOG_WRITE(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define DLOGW(tag, format, ...) DLOG_WRITE(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define DLOGI(tag, format, ...) DLOG_WRITE(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define DLOGD(tag, format, ...) DLOG_WRITE(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define DLOGV(tag, format, ...) DLOG_WRITE(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+#endif
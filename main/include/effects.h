@@ -0,0 +1,77 @@
+//
+// Procedural effects, rendered with integer arithmetic and lookup tables only.
+//
+// Each effect declares a per-frame budget. Frames are rendered a column at a time and rendering stops
+// once the budget is spent; the rest of the frame is finished on the next call, with the columns not
+// yet reached keeping their previous contents. An effect that runs long drops to a lower frame rate
+// rather than holding up the caller.
+//
+
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "display.h"
+
+// Size of the particle pool
+#define EFFECT_PARTICLES 24
+
+// Intended time between frames
+#define EFFECT_FRAME_MS 40
+
+// A pooled particle, with position and velocity in 8.8 fixed point
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t vx;
+    int16_t vy;
+    uint8_t life;
+} effect_particle_t;
+
+struct effect_def;
+
+typedef struct {
+    const struct effect_def* def;
+
+    // Frames started, and the first column still to be rendered for the current one
+    uint32_t frame;
+    uint8_t column;
+
+    // Per-frame budget (0 for unlimited), and how many frames ran out of it
+    uint32_t budget_cycles;
+    uint32_t overruns;
+
+    // xorshift32 state
+    uint32_t rng;
+
+    // Per-effect state
+    union {
+        uint8_t heat[DISPLAY_WIDTH][DISPLAY_HEIGHT + 1];
+        uint8_t level[DISPLAY_WIDTH][DISPLAY_HEIGHT];
+        struct {
+            uint8_t height[DISPLAY_WIDTH];
+            uint8_t target[DISPLAY_WIDTH];
+        } bars;
+        struct {
+            uint8_t level[DISPLAY_WIDTH][DISPLAY_HEIGHT];
+            effect_particle_t pool[EFFECT_PARTICLES];
+            uint8_t free[EFFECT_PARTICLES];
+            uint8_t free_count;
+        } particles;
+    } data;
+} effect_t;
+
+// Find an effect by name, returning its index or -1
+int effect_find(const char* name);
+
+// The name of the effect at `index`, or NULL past the last one
+const char* effect_name(unsigned int index);
+
+// Start an effect from scratch
+void effect_start(effect_t* effect, int index, uint32_t seed);
+
+// Render the next frame into `display`, returning false if it ran out of budget part way through
+bool effect_render(effect_t* effect, display_t* display);
+
+#endif
@@ -1,27 +1,123 @@
 //
-// A frame buffer that keeps display updates synchronised.
+// A bounded render-ahead queue of frames between producers and the display task.
+//
+// Producers render into a free slot (fb_acquire) and queue it (fb_commit), or copy a finished frame in
+// with fb_push. When the queue is full they block for up to their timeout, so a burst rendered ahead
+// of time absorbs a slow flush instead of being dropped. The display task flushes one queued frame per
+// refresh with fb_write, or a frame committed with a presentation time (fb_commit_at) at that time.
+//
+// Animations (transitions, effects) can instead be handed over with fb_animate: the display task then
+// renders each one itself at every refresh, straight from the producer's buffers, and notifies the
+// producer when it's done, so the producer needn't wake for each frame.
 //
 
 #ifndef FRAME_BUFFER_H
 #define FRAME_BUFFER_H
 
+#include <stdint.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
 #include "display.h"
 
+// Number of frames that can be queued ahead of the display
+#define FB_QUEUE_DEPTH 4
+
+// Slots: the queue, plus one for either the frame being flushed or, once it has been, the latest frame
+// (which is kept as the starting point for fb_acquire)
+#define FB_SLOTS (FB_QUEUE_DEPTH + 1)
+
+// Called with each frame just after it has been flushed, while the bus is still held
+typedef void (*fb_flush_callback_t)(const display_t* frame);
+
+// An animation rendered by the display task
+typedef struct fb_animation {
+
+  // Bring the animation up to `now_us`, returning the frame to show (which must stay valid until the next
+  // call or until the animation is stopped), or NULL if it hasn't changed. Sets is_finished at the end.
+  const display_t* (*render)(struct fb_animation* animation, int64_t now_us);
+  void* arg;
+  volatile bool is_finished;
+
+  // Notified once the animation finishes by itself
+  TaskHandle_t notify;
+} fb_animation_t;
+
 typedef struct {
-  display_t frame;
-  SemaphoreHandle_t sem;
-  bool dirty;
+  display_t frames[FB_SLOTS];
+
+  // Slot indices ready to flush, and free to render into
+  QueueHandle_t ready;
+  QueueHandle_t free;
+
+  // The most recently committed slot (-1 before the first), and whether the display task is done with it
+  int latest;
+  bool latest_flushed;
+  SemaphoreHandle_t latest_lock;
+
+  // Held while driving the display bus
+  SemaphoreHandle_t bus;
+
+  // Called after each flush, if set
+  fb_flush_callback_t on_flush;
+
+  // Rendered when no frames are queued, if set (and only changed with the bus held)
+  fb_animation_t* animation;
+
+  // When each slot was last committed, and when it's to be shown (0 for as soon as possible)
+  int64_t committed_us[FB_SLOTS];
+  int64_t present_us[FB_SLOTS];
+
+  // What's on the panel (only touched by the display task), so unchanged frames needn't be flushed and
+  // changed ones need only send the registers that differ
+  display_t shown;
+  bool shown_valid;
 } frame_buffer_t;
 
 // Initialise the framebuffer
 void fb_init();
 
-// Push a new frame
-void fb_push(display_t* new);
+// Queue a copy of a frame, waiting up to `timeout` for space
+// Returns the number of frames queued afterwards, or -1 if the frame was dropped
+int fb_push(const display_t* frame, TickType_t timeout);
+
+// Render into a free slot in place, starting from the latest frame, then queue it (or, if unchanged, release it)
+display_t* fb_acquire(TickType_t timeout);
+int fb_commit(display_t* frame, bool changed);
+
+// Queue a slot acquired with fb_acquire() to be shown at `present_us` (esp_timer time) rather than as soon as
+// possible; it's held at the head of the queue until then
+int fb_commit_at(display_t* frame, int64_t present_us);
+
+// When the next queued frame is to be shown: its presentation time, 0 if it has none, or -1 if nothing is queued
+int64_t fb_due();
+
+// Number of frames waiting to be flushed
+int fb_depth();
 
-// Write the current frame to the display
+// Flush the next queued frame (or animation frame) to the display, returning true if the panel changed
 bool fb_write();
 
-#endif
\ No newline at end of file
+// Have the display task render an animation until it finishes, or stop it early
+void fb_animate(fb_animation_t* animation);
+void fb_stop(fb_animation_t* animation);
+bool fb_animating();
+
+// Wait up to `timeout` for a frame to be queued, returning when it was committed, or -1 on timeout
+int64_t fb_wait(TickType_t timeout);
+
+// The frame on the panel
+const display_t* fb_shown();
+
+// Forget what's on the panel, after writing it other than through the frame buffer
+void fb_invalidate();
+
+// Set a function to call with each frame once it has been flushed
+void fb_on_flush(fb_flush_callback_t callback);
+
+// Hold the display bus exclusively
+void fb_lock();
+void fb_unlock();
+
+#endif
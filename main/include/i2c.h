@@ -2,6 +2,7 @@
 #define I2C_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 // Cycle count delay for software I2C interface
 #define I2C_WAIT_CYCLES 25
@@ -16,6 +17,8 @@ void i2c_start();
 void i2c_stop();
 uint8_t i2c_rx(bool send_ack);
 bool i2c_tx(uint8_t data);
+uint32_t i2c_bytes_sent();
+void i2c_bytes_add(uint32_t bytes);
 
 
 #endif
\ No newline at end of file
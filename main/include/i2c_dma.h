@@ -0,0 +1,32 @@
+//
+// Sends I2C writes as a waveform clocked out of the I2S peripheral in parallel (LCD) mode by DMA, leaving
+// the CPU free while they're on the bus.
+//
+// The transactions are encoded into samples (see i2c_wave.h) I2C_DMA_BUFFER_SAMPLES at a time: two
+// buffers take turns, each refilled from the DMA interrupt once it has gone out. SDA and SCL are routed to
+// the I2S outputs only for the length of a write, so the bit-banged driver in i2c.c can still be used in
+// between - for reads, and wherever an ACK has to be checked.
+//
+
+#ifndef I2C_DMA_H
+#define I2C_DMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "i2c_wave.h"
+
+// SCL frequency (the IS32FL3737 is rated for 1MHz Fast-mode Plus); samples go out at four times this
+#define I2C_DMA_SCL_HZ 1000000
+
+// Samples in each of the two DMA buffers (two bytes each)
+#define I2C_DMA_BUFFER_SAMPLES 1024
+
+// Set up the I2S peripheral and DMA buffers, returning false if they can't be had
+bool i2c_dma_init();
+
+// Send a list of write transactions, blocking the calling task (but not the CPU) until they've gone out.
+// Returns false if they didn't finish within `timeout`; ACKs aren't checked.
+bool i2c_dma_write(const i2c_wave_txn_t* txns, size_t count, TickType_t timeout);
+
+#endif
@@ -0,0 +1,89 @@
+//
+// I2C as a precomputed waveform: a list of write transactions encoded as a stream of SDA/SCL samples for
+// a peripheral to clock out by DMA (see i2c_dma.h), and a decoder that reads them back.
+//
+// Each sample is a 16-bit word of the I2S peripheral's parallel bus, with SDA in bit I2C_WAVE_SDA_BIT and
+// SCL in bit I2C_WAVE_SCL_BIT. Everything on the bus - a start, a stop or a bit - takes
+// I2C_WAVE_SYMBOL_SAMPLES samples, each a quarter of an SCL period:
+//
+//     start   SDA 1 1 0 0   SCL 1 1 1 0
+//     bit     SDA b b b b   SCL 0 1 1 0
+//     stop    SDA 0 0 1 1   SCL 0 1 1 1
+//
+// A transaction is a start, the address, the register, the data and a stop, each byte sent MSB first and
+// followed by an ACK bit with SDA released (1) for the chip to pull low. The samples go out blind, so
+// ACKs aren't checked and a NACK doesn't end a transaction early.
+//
+// Like the stream and sync decoders this has no hardware dependencies, so the encoder and decoder can be
+// run against each other on the host (host/i2c_wave).
+//
+
+#ifndef I2C_WAVE_H
+#define I2C_WAVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef HOST_BUILD
+#define I2C_WAVE_IRAM
+#else
+#include "esp_attr.h"
+
+// The encoder runs in the DMA interrupt, which has to keep running while flash is busy
+#define I2C_WAVE_IRAM IRAM_ATTR
+#endif
+
+// Where the lines are in a sample
+#define I2C_WAVE_SDA_BIT 0
+#define I2C_WAVE_SCL_BIT 1
+
+#define I2C_WAVE_SDA (1 << I2C_WAVE_SDA_BIT)
+#define I2C_WAVE_SCL (1 << I2C_WAVE_SCL_BIT)
+
+// Samples per start, stop or bit
+#define I2C_WAVE_SYMBOL_SAMPLES 4
+
+// Symbols in a transaction writing `length` data bytes: start, (address, register, data) x 9 bits, stop
+#define I2C_WAVE_TXN_SYMBOLS(length) (2 + 9 * (2 + (length)))
+
+// A register write: `length` bytes of `data` from register `reg` of the chip at (8-bit) `address`
+typedef struct {
+    uint8_t address;
+    uint8_t reg;
+    const uint8_t* data;
+    uint16_t length;
+} i2c_wave_txn_t;
+
+// Where an encoder is up to in its list of transactions
+typedef struct {
+    const i2c_wave_txn_t* txns;
+    size_t count;
+    size_t txn;
+    uint32_t symbol;
+
+    // Swap the samples of each pair, as the I2S peripheral sends the high half of each 32-bit word first
+    // in 16-bit parallel mode
+    bool swap_halves;
+} i2c_wave_encoder_t;
+
+// Total samples for a list of transactions
+size_t i2c_wave_samples(const i2c_wave_txn_t* txns, size_t count);
+
+// Start encoding a list of transactions, which must stay in place until they're encoded
+void i2c_wave_encoder_init(i2c_wave_encoder_t* encoder, const i2c_wave_txn_t* txns, size_t count, bool swap_halves);
+
+// Encode as many whole symbols as fit in `max` samples, returning how many samples were written
+size_t i2c_wave_encode(i2c_wave_encoder_t* encoder, uint16_t* samples, size_t max);
+
+// Whether every transaction has been encoded
+bool i2c_wave_done(const i2c_wave_encoder_t* encoder);
+
+// Decode a sample stream back into transactions, with their data stored in `data`.
+// Returns how many there were, or -1 if the stream isn't valid I2C or doesn't fit.
+int i2c_wave_decode(
+    const uint16_t* samples, size_t count, bool swap_halves,
+    i2c_wave_txn_t* txns, size_t max_txns, uint8_t* data, size_t data_size
+);
+
+#endif
@@ -1,6 +1,10 @@
 #ifndef IS32_H
 #define IS32_H
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
 // Make an actual I2C address from an is32_addr_t
 #define IS32_ADDRESS(a) ((0x50 | a) << 1)
 
@@ -71,10 +75,22 @@ typedef enum {
     IS32_SSD_RUN = 0b00000001
 } is32_config_ssd_t;
 
+// Options for CONFIG_I2C_MODE, in order
+typedef enum {
+    IS32_BUS_BITBANG,
+    IS32_BUS_DMA
+} is32_bus_mode_t;
+
 // Procedures
 void is32_init();
 bool is32_select_page(is32_addr_t addr, is32_page_t page, bool use_cache);
 bool is32_write_reg(is32_addr_t addr, uint16_t reg, uint8_t value);
 bool is32_write_seq(is32_addr_t addr, uint16_t start_reg, const uint8_t *data, uint length);
 
+// Batched writes: between begin and end, writes are collected and sent together by DMA (if enabled
+// with is32_use_dma), unacknowledged, rather than bit-banged one by one
+void is32_use_dma(bool enable);
+void is32_batch_begin();
+bool is32_batch_end();
+
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+//
+// 1-bit drawing on the display's on/off plane, held as a byte per column with bit n lighting row n (as
+// image: content and column assets are).
+//
+// The whole plane is DISPLAY_WIDTH bytes, so drawing sets or clears whole columns with a mask, and
+// shifting and combining planes works on MONO_WORDS words, four columns at a time. Build on/off content
+// here and convert it to PWM once, as it's flushed, with mono_render().
+//
+
+#ifndef MONO_H
+#define MONO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "display.h"
+
+// Columns are packed four to a word
+#define MONO_WORDS ((DISPLAY_WIDTH + 3) / 4)
+
+// The bits of a column that are rows of the display
+#define MONO_COLUMN_MASK ((1 << DISPLAY_HEIGHT) - 1)
+
+// A plane; bits outside the display are always clear
+typedef union {
+    uint8_t columns[MONO_WORDS * 4];
+    uint32_t words[MONO_WORDS];
+} mono_t;
+
+// How a source is combined with what's already drawn
+typedef enum {
+    MONO_SET,
+    MONO_AND,
+    MONO_OR,
+    MONO_XOR,
+    MONO_AND_NOT
+} mono_op_t;
+
+// Drawing
+void mono_clear(mono_t* mono, bool on);
+void mono_pixel(mono_t* mono, int x, int y, bool on);
+bool mono_get(const mono_t* mono, int x, int y);
+void mono_rect(mono_t* mono, int x_pos, int y_pos, int width, int height, bool on);
+void mono_line(mono_t* mono, int x0, int y0, int x1, int y1, bool on);
+void mono_checkerboard(mono_t* mono, bool invert);
+void mono_text(mono_t* mono, int x_pos, const char* text);
+const uint8_t* mono_glyph(char ch);
+void mono_sprite(mono_t* mono, const uint8_t* columns, int width, int x_pos, int y_pos, mono_op_t op);
+
+// Whole planes: shift (bringing in blank columns and rows), combine with another plane, invert
+void mono_shift(mono_t* mono, int dx, int dy);
+void mono_combine(mono_t* dest, const mono_t* source, mono_op_t op);
+void mono_invert(mono_t* mono);
+
+// Set the top left `width` x `height` of a display from a plane, lit pixels at `pwm` and the rest off
+void mono_render(const mono_t* mono, display_t* display, int width, int height, uint32_t pwm);
+
+#endif
@@ -0,0 +1,31 @@
+//
+// Power management for when the display is idle.
+//
+// While frames are being flushed the display task holds a lock that keeps the CPU out of light sleep.
+// Once the display has been static for a while it releases the lock, shuts the IS32 chips down if
+// nothing is lit, and blocks until the next frame is committed. With idle_mode set to sleep, automatic
+// light sleep (with tickless idle) is enabled, so the CPU sleeps whenever every task is blocked.
+//
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdbool.h>
+
+// Options for CONFIG_IDLE_MODE, in order
+typedef enum {
+    POWER_IDLE_OFF,
+    POWER_IDLE_SHUTDOWN,
+    POWER_IDLE_SLEEP
+} power_idle_mode_t;
+
+// Set up power management according to config, and follow changes to it
+void power_init();
+
+// Allow (or stop allowing) light sleep while the display is idle
+void power_idle(bool idle);
+
+// Keep the CPU out of light sleep regardless of the display, e.g. while receiving on the UART
+void power_busy(bool busy);
+
+#endif
@@ -0,0 +1,123 @@
+//
+// Scene scheduler: plays a playlist of content, each entered with a transition.
+//
+// A playlist is a string of entries separated by ';', each with fields separated by '|':
+//
+//     content|transition[:ms]|duration_ms|priority
+//
+// where content is one of:
+//
+//     text:<text>       Centred if it fits, otherwise scrolled across the display
+//     image:<hex>       DISPLAY_WIDTH column bytes, bit n of each byte lighting row n
+//     asset:<name>      An image or text compiled in from assets/ (see asset.h), centred if it fits,
+//                       otherwise scrolled across the display if it's 1-bit (or cut off if not)
+//     effect:<name>     blank, fill, checkerboard, checkerboard_inverse, left or right, or one of the
+//                       procedural effects in effects.h, which animate while the scene is held
+//
+// transition is cut, fade, wipe_<direction>, push_<direction>, slide_<direction> (where direction is up,
+// down, left or right), iris_open, iris_close or dissolve, optionally with the time it takes (which it
+// keeps to however long each frame takes to render and flush; by default a fixed time per step); duration
+// is how long the scene is held once it has fully appeared (and finished scrolling); priority decides
+// whether a scene injected with scene_show() interrupts the current one. Only the content is required.
+//
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "display.h"
+#include "transition.h"
+#include "asset.h"
+
+// Limits on playlist size and text content
+#define SCENE_MAX_ENTRIES 16
+#define SCENE_TEXT_LENGTH 64
+
+// Defaults for omitted fields
+#define SCENE_DEFAULT_DURATION_MS 1000
+#define SCENE_DEFAULT_PRIORITY 0
+
+// How many injected scenes can be waiting at once
+#define SCENE_QUEUE_LENGTH 4
+
+typedef enum {
+    SCENE_TEXT,
+    SCENE_IMAGE,
+    SCENE_EFFECT,
+    SCENE_PROCEDURAL,
+    SCENE_ASSET
+} scene_content_type_t;
+
+typedef enum {
+    SCENE_EFFECT_BLANK,
+    SCENE_EFFECT_FILL,
+    SCENE_EFFECT_CHECKERBOARD,
+    SCENE_EFFECT_CHECKERBOARD_INVERSE,
+    SCENE_EFFECT_LEFT,
+    SCENE_EFFECT_RIGHT
+} scene_effect_t;
+
+typedef enum {
+    SCENE_CUT,
+    SCENE_WIPE_UP,
+    SCENE_WIPE_DOWN,
+    SCENE_FADE,
+    SCENE_WIPE_LEFT,
+    SCENE_WIPE_RIGHT,
+    SCENE_PUSH_UP,
+    SCENE_PUSH_DOWN,
+    SCENE_PUSH_LEFT,
+    SCENE_PUSH_RIGHT,
+    SCENE_SLIDE_UP,
+    SCENE_SLIDE_DOWN,
+    SCENE_SLIDE_LEFT,
+    SCENE_SLIDE_RIGHT,
+    SCENE_IRIS_OPEN,
+    SCENE_IRIS_CLOSE,
+    SCENE_DISSOLVE
+} scene_transition_t;
+
+// A single playlist entry
+typedef struct {
+    scene_content_type_t type;
+    union {
+        char text[SCENE_TEXT_LENGTH];
+        uint8_t image[DISPLAY_WIDTH];
+        scene_effect_t effect;
+        int procedural;
+        const asset_t* asset;
+    } content;
+    scene_transition_t transition;
+    uint32_t transition_ms;
+    uint32_t duration_ms;
+    uint8_t priority;
+} scene_entry_t;
+
+// Set up the scheduler; call before scene_show() can be used
+void scene_init();
+
+// Parse a playlist string into at most `max` entries, returning the number parsed or -1 on error
+int scene_parse(const char* spec, scene_entry_t* entries, size_t max);
+
+// Reload the playlist from config once the current scene finishes
+void scene_reload();
+
+// Queue a scene to play next, interrupting the current one if it has a higher priority
+int scene_show(const scene_entry_t* entry);
+
+// Run the playlist forever
+void scene_run();
+
+// Print the playlist
+void scene_print();
+
+// Render an entry's first frame into the top left `width` x `height` of a display (procedural effects and
+// text scrolling aren't handled; text that doesn't fit is cut off)
+void scene_render(const scene_entry_t* entry, display_t* target, int width, int height);
+
+// Set up a transition between two frames (NULL for a cut), and how long an entry's transition takes
+trans_handle_t* scene_transition(scene_transition_t transition, const display_t* from, const display_t* to);
+uint32_t scene_transition_ms(const scene_entry_t* entry, const trans_handle_t* handle);
+
+#endif
@@ -0,0 +1,86 @@
+//
+// Binary frame protocol for the console UART.
+//
+
+#ifndef SERIAL_PROTO_H
+#define SERIAL_PROTO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "display.h"
+
+/*
+
+Packets are framed as:
+
+    uint8  sync[2]    0xA5, 0x5A
+    uint8  type       serial_packet_type_t
+    uint16 length     payload bytes, little-endian
+    uint8  payload[length]
+    uint16 crc        CRC-16/CCITT-FALSE of type, length and payload, little-endian
+
+SERIAL_FRAME payload: DISPLAY_PIXELS PWM bytes, packed as for display_load_pwm().
+
+SERIAL_REGION payload: uint8 x, y, width, height, followed by width * height PWM bytes
+in column-major order within the region.
+
+SERIAL_PING has no payload and SERIAL_EXIT returns the UART to the text console.
+
+Each packet is answered with a single SERIAL_ACK or SERIAL_NAK byte once it has been applied.
+
+*/
+
+#define SERIAL_SYNC_0 0xA5
+#define SERIAL_SYNC_1 0x5A
+#define SERIAL_MAX_PAYLOAD 512
+
+// Baud rates binary mode accepts. The UART runs from the 80MHz APB clock in binary mode, whose divider
+// (in 1/16 steps) puts any of these within 0.2%, and the ESP32's UART is rated to 5 Mbaud.
+#define SERIAL_MIN_BAUD 9600
+#define SERIAL_MAX_BAUD 4000000
+
+#define SERIAL_ACK 0x06
+#define SERIAL_NAK 0x15
+
+typedef enum {
+    SERIAL_NONE = 0,
+    SERIAL_FRAME = 1,
+    SERIAL_REGION = 2,
+    SERIAL_PING = 3,
+    SERIAL_EXIT = 4
+} serial_packet_type_t;
+
+typedef enum {
+    SERIAL_STATE_SYNC_0,
+    SERIAL_STATE_SYNC_1,
+    SERIAL_STATE_TYPE,
+    SERIAL_STATE_LENGTH_LO,
+    SERIAL_STATE_LENGTH_HI,
+    SERIAL_STATE_PAYLOAD,
+    SERIAL_STATE_CRC_LO,
+    SERIAL_STATE_CRC_HI
+} serial_state_t;
+
+typedef struct {
+    serial_state_t state;
+    uint8_t type;
+    uint16_t length;
+    uint16_t pos;
+    uint16_t crc;
+    uint16_t received_crc;
+    uint8_t payload[SERIAL_MAX_PAYLOAD];
+
+    // Counters
+    uint32_t packets;
+    uint32_t crc_errors;
+    uint32_t invalid;
+} serial_parser_t;
+
+// Methods
+void serial_parser_init(serial_parser_t* parser);
+serial_packet_type_t serial_parse(serial_parser_t* parser, const uint8_t* data, size_t length, size_t* consumed);
+bool serial_decode(serial_parser_t* parser, display_t* display);
+uint16_t serial_crc16(uint16_t crc, const uint8_t* data, size_t length);
+
+#endif
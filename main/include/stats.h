@@ -0,0 +1,87 @@
+//
+// Always-on frame pipeline statistics.
+//
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "is32.h"
+
+// Histograms have power-of-two buckets: bucket n counts samples in [2^(n-1), 2^n) microseconds
+#define STATS_HIST_BUCKETS 20
+
+// Number of recent frames kept in the frame ring
+#define STATS_RING_SIZE 32
+
+typedef struct {
+    uint32_t buckets[STATS_HIST_BUCKETS];
+    uint32_t max_us;
+} stats_hist_t;
+
+// A single presented frame
+typedef struct {
+    uint32_t seq;
+    uint32_t flush_us;
+    int32_t lateness_us;
+    uint32_t i2c_bytes;
+} stats_frame_t;
+
+typedef struct {
+
+    // Frame buffer traffic
+    uint32_t frames_pushed;
+    uint32_t frames_dropped;
+    uint32_t frames_presented;
+
+    // Deepest the render-ahead queue has been
+    uint32_t queue_max;
+
+    // Flushes skipped because the frame was already on the panel
+    uint32_t frames_unchanged;
+
+    // Times the display went idle (and how many of those with the chips shut down), and the time from the
+    // frame that ended each idle period being committed to it being on the panel
+    uint32_t idle_entries;
+    uint32_t idle_shutdowns;
+    stats_hist_t resume;
+
+    // Time spent rendering, flushing, and how late the display task woke
+    stats_hist_t render;
+    stats_hist_t flush;
+    stats_hist_t lateness;
+
+    // How late frames with a presentation time (see fb_commit_at) started flushing
+    stats_hist_t present;
+
+    // I2C traffic per chip, indexed by is32_addr_t / 5 (as for the page cache)
+    uint32_t i2c_bytes[IS32_CHIPS_PER_BUS];
+    uint32_t i2c_nacks[IS32_CHIPS_PER_BUS];
+
+    // Ring of the most recently presented frames, written only by the display task
+    // `ring_head` is the number of frames ever written - the newest is at (ring_head - 1) % STATS_RING_SIZE
+    stats_frame_t ring[STATS_RING_SIZE];
+    uint32_t ring_head;
+
+} stats_t;
+
+extern stats_t stats;
+
+// Recording - cheap enough to be called on every frame
+void stats_push(bool dropped);
+void stats_queue(uint32_t depth);
+void stats_render(uint32_t cycles);
+void stats_flush(uint32_t cycles, uint32_t i2c_bytes);
+void stats_lateness(int32_t lateness_us);
+void stats_unchanged();
+void stats_idle(bool shutdown);
+void stats_resume(uint32_t resume_us);
+void stats_present(int32_t late_us);
+void stats_i2c(is32_addr_t addr, uint32_t bytes, bool nack);
+
+// Reporting
+void stats_reset();
+void stats_print();
+
+#endif
@@ -0,0 +1,94 @@
+//
+// Decoder and jitter buffer for the UDP frame streaming protocol.
+//
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "display.h"
+
+/*
+
+Every packet starts with a 12-byte little-endian header:
+
+    uint8  magic[2]   'T', 'X'
+    uint8  version    STREAM_VERSION
+    uint8  type       STREAM_FULL or STREAM_DELTA
+    uint16 seq        incremented by one per frame, wrapping
+    uint16 length     payload bytes following the header
+    uint32 epoch      chosen at random when the sender starts, so the receiver can tell it has restarted
+
+STREAM_FULL payload: DISPLAY_PIXELS PWM bytes, packed as for display_load_pwm().
+
+STREAM_DELTA payload: changes against the previous frame, as a list of runs:
+
+    uint8  index      first pixel (x * DISPLAY_HEIGHT + y)
+    uint8  count      number of pixels in the run
+    uint8  pwm[count]
+
+Deltas can only be applied on top of the frame before them, so after any loss the receiver waits
+for the next full frame. Senders should send a full frame periodically.
+
+A packet with a new epoch starts the receiver over: buffered packets are dropped, and its sequence
+number is taken as the next expected. Datagrams are received into STREAM_RECV_BUFFER bytes, one more
+than the largest packet, so that one too large to be valid can't be truncated to a valid length.
+
+*/
+
+#define STREAM_MAGIC_0 'T'
+#define STREAM_MAGIC_1 'X'
+#define STREAM_VERSION 2
+#define STREAM_HEADER_SIZE 12
+#define STREAM_MAX_PACKET 512
+#define STREAM_RECV_BUFFER (STREAM_MAX_PACKET + 1)
+
+// Number of packets held for reordering
+#define STREAM_JITTER_SLOTS 4
+
+typedef enum {
+    STREAM_FULL = 1,
+    STREAM_DELTA = 2
+} stream_packet_type_t;
+
+// A received packet waiting in the jitter buffer
+typedef struct {
+    uint8_t data[STREAM_RECV_BUFFER];
+    uint16_t seq;
+    bool used;
+} stream_slot_t;
+
+typedef struct {
+    stream_slot_t slots[STREAM_JITTER_SLOTS];
+
+    // The slot the next packet is being received into
+    stream_slot_t* receiving;
+
+    // Sender's epoch, and the sequence number of the next frame to present
+    uint32_t epoch;
+    uint16_t next_seq;
+
+    // Have we started a stream, and do we have a frame deltas can be applied to?
+    bool started;
+    bool synced;
+
+    // Counters
+    uint32_t received;
+    uint32_t decoded;
+    uint32_t late;
+    uint32_t lost;
+    uint32_t unsynced;
+    uint32_t invalid;
+    uint32_t restarts;
+} stream_t;
+
+// Methods
+void stream_init(stream_t* stream);
+uint8_t* stream_rx_buffer(stream_t* stream);
+void stream_rx_commit(stream_t* stream, size_t length);
+bool stream_ready(stream_t* stream);
+bool stream_pop(stream_t* stream, display_t* display);
+
+#endif
@@ -0,0 +1,147 @@
+//
+// Multi-node synchronised presentation: a time-sync exchange with a leader, and frames tagged with the
+// time (on the leader's clock) they should appear, so that several panels driven as one sign all show
+// each frame together.
+//
+
+#ifndef SYNC_H
+#define SYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "display.h"
+
+/*
+
+Every packet starts with a 4-byte header, and all fields are little-endian:
+
+    uint8  magic[2]   'T', 'S'
+    uint8  version    SYNC_VERSION
+    uint8  type       sync_packet_type_t
+
+SYNC_FRAME (leader to the multicast group):
+
+    uint32 seq        incremented by one per frame
+    uint32 epoch      chosen at random when the leader starts, so nodes can tell it has restarted
+    int64  present_us when to show the frame, on the leader's clock
+    uint8  pwm[DISPLAY_PIXELS], packed as for display_load_pwm()
+
+SYNC_REQUEST (node to the address frames come from):
+
+    uint32 node
+    int64  t1         when the node sent it, on its own clock
+
+SYNC_RESPONSE (leader to the node):
+
+    uint32 node
+    int64  t1         echoed from the request
+    int64  t2         when the leader received the request, on its clock
+    int64  t3         when the leader sent the response, on its clock
+
+SYNC_REPORT (node to leader, sent by test nodes to measure skew):
+
+    uint32 node
+    uint32 seq
+    int64  presented_us when the frame was shown, on the leader's clock
+
+A node receiving the response at t4 estimates the leader's clock to be ahead of its own by
+((t2 - t1) + (t3 - t4)) / 2, which is exact when the delay is the same each way; the error is at most
+half the round trip. Of the last SYNC_WINDOW exchanges, the one with the smallest bound on its error now
+is used: half its round trip (a short one was delayed least by queuing), plus how far the clocks may have
+drifted apart since. Frames are full frames only, as a node that missed one can't ask for it
+again in time, and are dropped rather than shown late. A frame with a new epoch starts the node over:
+its sequence number is taken as the next expected, and the clock is re-estimated from new exchanges.
+
+Datagrams are received into SYNC_RECV_BUFFER bytes, one more than the largest packet, so that one
+too large to be valid can't be truncated to a valid length.
+
+*/
+
+#define SYNC_MAGIC_0 'T'
+#define SYNC_MAGIC_1 'S'
+#define SYNC_VERSION 2
+#define SYNC_HEADER_SIZE 4
+
+// Packet sizes, including the header
+#define SYNC_FRAME_SIZE (SYNC_HEADER_SIZE + 16 + DISPLAY_PIXELS)
+#define SYNC_REQUEST_SIZE (SYNC_HEADER_SIZE + 12)
+#define SYNC_RESPONSE_SIZE (SYNC_HEADER_SIZE + 28)
+#define SYNC_REPORT_SIZE (SYNC_HEADER_SIZE + 16)
+#define SYNC_MAX_PACKET SYNC_FRAME_SIZE
+#define SYNC_RECV_BUFFER (SYNC_MAX_PACKET + 1)
+
+// Time-sync exchanges kept, and how often a node starts one
+#define SYNC_WINDOW 8
+#define SYNC_REQUEST_MS 250
+
+// Exchanges needed before frames are shown
+#define SYNC_MIN_SAMPLES 2
+
+typedef enum {
+    SYNC_INVALID = 0,
+    SYNC_FRAME = 1,
+    SYNC_REQUEST = 2,
+    SYNC_RESPONSE = 3,
+    SYNC_REPORT = 4
+} sync_packet_type_t;
+
+// Most the node's and leader's clocks are expected to drift apart, in parts per million
+#define SYNC_MAX_DRIFT_PPM 50
+
+// One time-sync exchange, and when it completed on the node's clock
+typedef struct {
+    int64_t offset_us;
+    uint32_t rtt_us;
+    int64_t at_us;
+} sync_sample_t;
+
+typedef struct {
+    uint32_t node;
+
+    // The most recent exchanges, and how many there have been
+    sync_sample_t samples[SYNC_WINDOW];
+    uint32_t sample_count;
+
+    // When the outstanding request was sent (0 if none), so stale responses are ignored
+    int64_t request_t1;
+
+    // Current estimate of the leader's clock less ours, and the round trip it was measured with
+    int64_t offset_us;
+    uint32_t rtt_us;
+
+    // The leader's epoch, and the sequence number of the next frame expected
+    uint32_t epoch;
+    uint32_t next_seq;
+    bool started;
+
+    // Counters
+    uint32_t frames;
+    uint32_t late;
+    uint32_t lost;
+    uint32_t unsynced;
+    uint32_t invalid;
+    uint32_t restarts;
+} sync_node_t;
+
+// Check a packet, returning its type or SYNC_INVALID
+sync_packet_type_t sync_packet_type(const uint8_t* data, size_t length);
+
+// Node side
+void sync_init(sync_node_t* node, uint32_t id);
+bool sync_synced(const sync_node_t* node);
+size_t sync_request(sync_node_t* node, int64_t now_us, uint8_t* packet);
+bool sync_response(sync_node_t* node, const uint8_t* packet, int64_t now_us);
+bool sync_frame(sync_node_t* node, const uint8_t* packet, int64_t now_us, display_t* display, int64_t* present_us);
+size_t sync_report(const sync_node_t* node, uint32_t seq, int64_t presented_us, uint8_t* packet);
+
+// Convert between the leader's clock and the node's
+int64_t sync_to_local(const sync_node_t* node, int64_t leader_us);
+int64_t sync_to_leader(const sync_node_t* node, int64_t local_us);
+
+// Leader side
+size_t sync_encode_frame(uint32_t epoch, uint32_t seq, int64_t present_us, const uint8_t* pwm, uint8_t* packet);
+size_t sync_respond(const uint8_t* request, int64_t received_us, int64_t sent_us, uint8_t* packet);
+void sync_parse_report(const uint8_t* packet, uint32_t* node, uint32_t* seq, int64_t* presented_us);
+
+#endif
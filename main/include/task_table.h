@@ -0,0 +1,68 @@
+//
+// The application's tasks, created from a single table with statically allocated stacks.
+//
+// Each task's stack size, priority and core are set in the table in main/task_table.c. Stacks are sampled
+// every TASK_SAMPLE_MS for their high-water marks, along with the heap, and `tasks` on the console
+// prints what each task has used, so stack sizes can be trimmed to measured usage.
+//
+
+#ifndef TASK_TABLE_H
+#define TASK_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// How often stacks and the heap are sampled
+#define TASK_SAMPLE_MS 1000
+
+// Free stack below which a task is warned about (once)
+#define TASK_STACK_MARGIN 512
+
+typedef enum {
+    TASK_LOG,
+    TASK_DISPLAY,
+    TASK_CLI,
+    TASK_MAIN,
+    TASK_STREAM,
+    TASK_CONFIG,
+    TASK_SYNC,
+    TASK_COUNT
+} task_id_t;
+
+// When a task is started: early tasks come up before config is loaded, the rest once the system is ready
+typedef enum {
+    TASK_START_EARLY,
+    TASK_START_LATE
+} task_start_t;
+
+typedef struct {
+    const char* name;
+    TaskFunction_t function;
+    StackType_t* stack;
+    uint32_t stack_size;
+    UBaseType_t priority;
+    BaseType_t core;
+    task_start_t start;
+
+    StaticTask_t tcb;
+    TaskHandle_t handle;
+
+    // Least free stack seen, in bytes, and whether it has been warned about
+    uint32_t stack_min_free;
+    bool warned;
+} task_entry_t;
+
+extern task_entry_t tasks[TASK_COUNT];
+
+// Create every task to be started at `start`
+void task_table_start(task_start_t start);
+
+// Start sampling stacks and the heap every TASK_SAMPLE_MS
+void task_table_monitor();
+
+// Print each task's stack usage, and the heap
+void task_table_print();
+
+#endif
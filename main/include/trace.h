@@ -0,0 +1,51 @@
+//
+// Capture of IS32 I2C transactions into a fixed RAM ring.
+//
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "is32.h"
+
+// Size of the capture ring
+#define TRACE_BUFFER_SIZE 16384
+
+// Dump format version, bumped whenever trace_record_t changes
+#define TRACE_VERSION 1
+
+// Record flags
+#define TRACE_FLAG_NACK 0x01
+
+// Header of a single captured transaction, followed in the ring by `length` payload bytes
+// All fields are little-endian
+typedef struct __attribute__((packed)) {
+
+    // Capture time (esp_timer, microseconds, wraps)
+    uint32_t timestamp_us;
+
+    // 7-bit I2C address and the register written
+    uint8_t addr;
+    uint8_t reg;
+
+    // TRACE_FLAG_*
+    uint8_t flags;
+    uint8_t reserved;
+
+    // Payload length, and the index of the first NACKed byte (0 being the address byte)
+    // `nack_at` is only meaningful if TRACE_FLAG_NACK is set - sequential writes stop at the first NACK
+    uint16_t length;
+    uint16_t nack_at;
+
+} trace_record_t;
+
+// Methods
+void trace_start();
+void trace_stop();
+void trace_clear();
+bool trace_is_enabled();
+void trace_record(is32_addr_t addr, uint8_t reg, const uint8_t* data, uint16_t length, int nack_at);
+void trace_dump();
+
+#endif
@@ -2,8 +2,10 @@
 #define TRANSITION_H
 
 #include <stdio.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include "display.h"
+#include "canvas.h"
 
 /** Types **/
 
@@ -13,12 +15,16 @@
 typedef enum {
     TRANS_WIPE,
     TRANS_FADE,
-    TRANS_SCROLL_TEXT
+    TRANS_SCROLL_TEXT,
+    TRANS_PUSH,
+    TRANS_SLIDE,
+    TRANS_IRIS,
+    TRANS_DISSOLVE
 } trans_type_t;
 
-/** Wipe **/
+/** Wipe, push and slide **/
 
-// Wipe directions
+// Directions of travel for wipes, pushes and slides (e.g. WIPE_UP brings the new state in from the bottom)
 #define TRANS_WIPE_DIRECTION_VERTICAL_MASK 0x01
 typedef enum {
     WIPE_UP = 1,
@@ -27,12 +33,34 @@ typedef enum {
     WIPE_LEFT = 4
 } trans_wipe_direction_t;
 
-// Wipe state
+// Wipe, push and slide state, moving across a rectangle (the whole display unless clipped)
 typedef struct {
     trans_wipe_direction_t direction;
     unsigned int step;
+    int x;
+    int y;
+    int width;
+    int height;
 } trans_wipe_data_t;
 
+/** Iris **/
+
+// Iris state
+typedef struct {
+    bool closing;
+    unsigned int step;
+} trans_iris_data_t;
+
+/** Dissolve **/
+
+// Dissolve state: pixels are revealed in the order of an 8-bit maximal-length LFSR
+typedef struct {
+    uint8_t lfsr;
+    unsigned int per_step;
+    unsigned int remaining;
+    unsigned int step;
+} trans_dissolve_data_t;
+
 /** Fade **/
 
 // Fade state
@@ -66,11 +94,11 @@ typedef enum {
 
 } trans_scroll_text_end_behaviour_t;
 
-// Scroll Text state
+// Scroll Text state: the text is drawn onto a canvas once, and each step moves the viewport
 typedef struct {
     bool invert;
     unsigned int step;
-    const char* text;
+    canvas_t canvas;
     trans_scroll_text_start_behaviour_t start_behaviour;
     trans_scroll_text_end_behaviour_t end_behaviour;
 } trans_scroll_text_data_t;
@@ -89,8 +117,15 @@ typedef struct trans_handle {
     const display_t* to;
     display_t* current;
     
-    // Is the transition finished?
+    // Is the transition finished, how many calls to trans_progress() it takes to finish, and how many
+    // have been made
     bool is_finished;
+    unsigned int steps;
+    unsigned int step;
+
+    // When a timed transition started and how long it lasts (0 if it isn't timed), see trans_start()
+    int64_t start_us;
+    int64_t duration_us;
 
     // The transition type
     trans_type_t type;
@@ -100,6 +135,8 @@ typedef struct trans_handle {
         trans_wipe_data_t* wipe;
         trans_fade_data_t* fade;
         trans_scroll_text_data_t* scroll_text;
+        trans_iris_data_t* iris;
+        trans_dissolve_data_t* dissolve;
     } trans_data;
 
 } trans_handle_t;
@@ -107,9 +144,23 @@ typedef struct trans_handle {
 /** Procedures **/
 
 // These functions create transitions
-// Wipes upwards or downwards from one display state to another
+// Geometric transitions only touch the pixels that change on each step
+
+// Wipes from one display state to another, revealing a row or column per step
 trans_handle_t* trans_wipe(const display_t* from, const display_t* to, trans_wipe_direction_t direction);
 
+// Moves the new state in, pushing the old one out ahead of it, a row or column per step
+trans_handle_t* trans_push(const display_t* from, const display_t* to, trans_wipe_direction_t direction);
+
+// Moves the new state in over the old one, a row or column per step
+trans_handle_t* trans_slide(const display_t* from, const display_t* to, trans_wipe_direction_t direction);
+
+// Reveals the new state in rings, from the centre out (or the edges in when closing)
+trans_handle_t* trans_iris(const display_t* from, const display_t* to, bool closing);
+
+// Reveals the new state a pseudo-random set of pixels at a time, over `steps` steps
+trans_handle_t* trans_dissolve(const display_t* from, const display_t* to, unsigned int steps);
+
 // Fades from one display state to another in the defined number of steps
 // The step for each pixel is calculated when trans_fade is called and each pixel is incremented on trans_progress()
 trans_handle_t* trans_fade(const display_t* from, const display_t* to, unsigned int steps);
@@ -117,10 +168,28 @@ trans_handle_t* trans_fade(const display_t* from, const display_t* to, unsigned
 // Scroll a piece of text on the display
 trans_handle_t* trans_scroll_text(const char* text, bool invert, trans_scroll_text_start_behaviour_t start, trans_scroll_text_end_behaviour_t end);
 
+// Scroll a column asset (e.g. a long banner) across the display, straight from flash
+trans_handle_t* trans_scroll_asset(const asset_t* asset, bool invert, trans_scroll_text_start_behaviour_t start, trans_scroll_text_end_behaviour_t end);
+
+// Confines a transition to a rectangle before its first step; `from` and `to` must match outside it
+// Wipes, pushes and slides move across the rectangle instead of the display; other types are unaffected
+void trans_clip(trans_handle_t* handle, int x, int y, int width, int height);
+
 // Progresses a transition.
 // Check is_finished on the trans_hand_t object to ascertain if the transition is complete.
 trans_handle_t* trans_progress(trans_handle_t* handle);
 
+// Times a transition to take `duration_ms` from `start_us`, with its steps evenly spaced from the start
+// and the last one shown for a step's time before it ends
+void trans_start(trans_handle_t* handle, int64_t start_us, uint32_t duration_ms);
+
+// Progresses a timed transition to where it should be at `now_us`, taking every step that's due (however
+// many have been missed), and returns how many were taken
+unsigned int trans_progress_to(trans_handle_t* handle, int64_t now_us);
+
+// When the next step of a timed transition is due, or once they've all been taken, when it ends
+int64_t trans_next_due_us(const trans_handle_t* handle);
+
 // Free the resources used by a completed (or aborted) transition
 // The new transition functions allocate trans_data with space to store any transition-specific progress data
 // so it is critical that transition handles are freed after use.
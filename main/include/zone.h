@@ -0,0 +1,41 @@
+//
+// Zones: named rectangles of the display, each showing its own content and updated independently.
+//
+// Zones are defined by the `zones` config item (read at startup) as entries separated by ';':
+//
+//     name:x,y,width,height
+//
+// and each is updated with zone_set() using a single playlist entry (content|transition, see scene.h).
+// A zone moves to its new content with its own transition while the rest of the display stays put, so
+// only the registers of the chips it covers are rewritten. Pixels outside every zone stay blank, and
+// where zones overlap the later one wins.
+//
+
+#ifndef ZONE_H
+#define ZONE_H
+
+#include "display.h"
+
+// Limits on the number of zones and the length of their names
+#define ZONE_MAX 4
+#define ZONE_NAME_LENGTH 12
+
+// How many updates can be waiting at once, across all zones
+#define ZONE_QUEUE_LENGTH 8
+
+// Read the zone definitions from config, returning how many there are or -1 if they're invalid
+int zone_init();
+
+// Number of zones defined
+int zone_count();
+
+// Queue new content for a zone, returning -1 if the zone or entry is invalid or the queue is full
+int zone_set(const char* name, const char* spec);
+
+// Show the zones forever
+void zone_run();
+
+// Print the zones
+void zone_print();
+
+#endif
@@ -1,15 +1,37 @@
 #include <stdbool.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "esp_log.h"
 #include "i2c.h"
+#include "i2c_dma.h"
 #include "is32.h"
+#include "stats.h"
+#include "trace.h"
 
 static const char* TAG = "IS32";
-#define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
 
 // Mutex protecting critical sections for the IS32 driver.
 static portMUX_TYPE is32_mut = portMUX_INITIALIZER_UNLOCKED;
 
+// Writes collected between is32_batch_begin() and is32_batch_end() to go out by DMA
+#define IS32_BATCH_TXNS 64
+#define IS32_BATCH_BYTES 1024
+
+// How long a batch may take on the bus (a full one is ~11ms at 1MHz)
+#define IS32_BATCH_TIMEOUT_TICKS (100 / portTICK_PERIOD_MS)
+
+static bool dma_wanted = false;
+static bool dma_ready = false;
+static bool batching = false;
+static bool batch_ok = true;
+static i2c_wave_txn_t batch_txns[IS32_BATCH_TXNS];
+static uint8_t batch_data[IS32_BATCH_BYTES];
+static size_t batch_count = 0;
+static size_t batch_used = 0;
+
+// Last page selected on each chip, invalid at first (and after a failed batch) so the next write selects it
+static uint8_t last_page_cache[IS32_CHIPS_PER_BUS] = {0xFF, 0xFF, 0xFF, 0xFF};
+
 /**
  * Initialise the IS32 driver.
  */
@@ -18,6 +40,88 @@ void is32_init()
     i2c_init();
 }
 
+/**
+ * Send writes by DMA between is32_batch_begin() and is32_batch_end(), or bit-bang everything.
+ * The DMA driver is set up the first time it's enabled; if it can't be, writes stay bit-banged.
+ */
+void is32_use_dma(bool enable)
+{
+    if (enable && !dma_ready) {
+        dma_ready = i2c_dma_init();
+        if (!dma_ready) {
+            ESP_LOGW(TAG, "DMA unavailable, writes stay bit-banged");
+        }
+    }
+
+    dma_wanted = enable;
+}
+
+/**
+ * Send the batched writes and empty the batch.
+ */
+static void batch_flush()
+{
+    batch_ok &= i2c_dma_write(batch_txns, batch_count, IS32_BATCH_TIMEOUT_TICKS);
+    batch_count = 0;
+    batch_used = 0;
+}
+
+/**
+ * Add a write to the batch, flushing it first if it's full.
+ */
+static void batch_add(is32_addr_t addr, uint8_t reg, const uint8_t* data, uint length)
+{
+    if (batch_count == IS32_BATCH_TXNS || batch_used + length > IS32_BATCH_BYTES) {
+        batch_flush();
+    }
+
+    memcpy(&batch_data[batch_used], data, length);
+    batch_txns[batch_count ++] = (i2c_wave_txn_t){
+        .address = IS32_ADDRESS(addr) | I2C_WRITE_BIT,
+        .reg = reg,
+        .data = &batch_data[batch_used],
+        .length = length
+    };
+    batch_used += length;
+
+    // ACKs aren't seen, so every byte counts as sent and acknowledged
+    stats_i2c(addr, length + 2, false);
+    trace_record(addr, reg, data, length, -1);
+}
+
+/**
+ * Start collecting writes, to be sent together by is32_batch_end().
+ * Only has an effect if DMA is in use.
+ */
+void is32_batch_begin()
+{
+    batching = dma_wanted && dma_ready;
+    batch_ok = true;
+}
+
+/**
+ * Send the writes collected since is32_batch_begin(), returning false if any didn't go out in time.
+ * A batch cut short may not have selected the pages it was written against, so they're selected
+ * again next time.
+ */
+bool is32_batch_end()
+{
+    if (!batching) {
+        return true;
+    }
+
+    if (batch_count > 0) {
+        batch_flush();
+    }
+
+    if (!batch_ok) {
+        memset(last_page_cache, 0xFF, sizeof(last_page_cache));
+    }
+
+    batching = false;
+    return batch_ok;
+}
+
 /**
  * Sequential-write to an IS32.
  * Changes page automatically if required by the target register.
@@ -38,23 +142,40 @@ bool is32_write_seq(is32_addr_t addr, uint16_t start_reg, const uint8_t *data, u
         return result;
     }
 
+    if (batching) {
+        batch_add(addr, start_reg & 0xFF, data, length);
+        return true;
+    }
+
     // Write the registers
+    uint32_t sent = i2c_bytes_sent();
     portENTER_CRITICAL(&is32_mut);
     i2c_start();
     
-    // Write address and register
-    result &= i2c_tx(IS32_ADDRESS(addr) | I2C_WRITE_BIT);
-    result &= i2c_tx(start_reg & 0xFF);
-    
-    // Write each byte
-    for (;length && result; length --) {
-        // Transmit a byte, then increment to the next one - anding the result to ensure it didn't fail
-        result &= i2c_tx(*data ++);
+    // Write address and register, noting the index (0 for the address) of the first byte NACKed
+    int nack_at = -1;
+    if (!i2c_tx(IS32_ADDRESS(addr) | I2C_WRITE_BIT)) {
+        nack_at = 0;
+    }
+    if (!i2c_tx(start_reg & 0xFF) && nack_at < 0) {
+        nack_at = 1;
+    }
+
+    // Write each byte, stopping at the first NACK
+    for (uint idx = 0; idx < length && nack_at < 0; idx ++) {
+        if (!i2c_tx(data[idx])) {
+            nack_at = 2 + idx;
+        }
     }
 
     i2c_stop();
     portEXIT_CRITICAL(&is32_mut);
 
+    result &= nack_at < 0;
+    sent = i2c_bytes_sent() - sent;
+    stats_i2c(addr, sent, !result);
+
+    trace_record(addr, start_reg & 0xFF, data, length, nack_at);
     return result;
 }
 
@@ -74,15 +195,27 @@ bool is32_write_reg(is32_addr_t addr, uint16_t reg, uint8_t value)
         }
     }
     
+    if (batching) {
+        batch_add(addr, reg & 0xFF, &value, 1);
+        return true;
+    }
+
     // Write the register
+    bool acks[3];
     portENTER_CRITICAL(&is32_mut);
     i2c_start();
-    result &= i2c_tx(IS32_ADDRESS(addr) | I2C_WRITE_BIT);
-    result &= i2c_tx(reg & 0xFF);
-    result &= i2c_tx(value);
+    acks[0] = i2c_tx(IS32_ADDRESS(addr) | I2C_WRITE_BIT);
+    acks[1] = i2c_tx(reg & 0xFF);
+    acks[2] = i2c_tx(value);
     i2c_stop();
     portEXIT_CRITICAL(&is32_mut);
 
+    int nack_at = !acks[0] ? 0 : !acks[1] ? 1 : !acks[2] ? 2 : -1;
+    result &= nack_at < 0;
+
+    stats_i2c(addr, 3, !result);
+    trace_record(addr, reg & 0xFF, &value, 1, nack_at);
+
     return result;
 }
 
@@ -94,9 +227,6 @@ bool is32_write_reg(is32_addr_t addr, uint16_t reg, uint8_t value)
  */
 bool is32_select_page(is32_addr_t addr, is32_page_t page, bool use_cache)
 {
-    // Last-page cache initialised to invalid pages such that the first update always happens
-    static uint8_t last_page_cache[IS32_CHIPS_PER_BUS] = {0xFF, 0xFF, 0xFF, 0xFF};
-
     // Is an update needed?
     if (last_page_cache[addr/5] == page) {
         return true;
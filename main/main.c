@@ -3,16 +3,31 @@
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "tasks/cli/include/task_cli.h"
-#include "tasks/main/include/task_main.h"
-#include "tasks/display/include/task_display.h"
 #include "config.h"
 #include "buttons.h"
 #include "frame_buffer.h"
+#include "events.h"
+#include "scene.h"
+#include "zone.h"
+#include "boot.h"
+#include "wifi.h"
+#include "power.h"
+#include "task_table.h"
 
 // Log Tag
 static const char* TAG = "Init";
 
+// The system event group
+EventGroupHandle_t sys_event_group;
+
+/**
+ * Apply the configured log level, including when it changes.
+ */
+static void apply_log_level(config_key_t key, void* arg)
+{
+    esp_log_level_set("*", config_get_int(key));
+}
+
 /**
  * Main application entry point.
  */
@@ -20,18 +35,45 @@ void app_main()
 {
     // Initialise
     ESP_LOGI(TAG, "TXLED System Startup");
+    boot_mark("app_main");
+
+    // Start from default configuration, so the display can come up before flash has been read
+    config_init();
+
+    // Power management, before the display task can go idle (a stored idle mode is applied once loaded)
+    power_init();
+
+    // Queue the frame from before the reset (or a splash), and start the display task, which brings the
+    // panel up and shows it while the rest of the system initialises (with the log task, which writes out
+    // what it and the other hot paths log)
+    static display_t first_frame;
+    boot_splash(&first_frame);
+    fb_init();
+    fb_push(&first_frame, 0);
+    task_table_start(TASK_START_EARLY);
 
     // Load configuration from flash
     config_load();
+    boot_mark("config loaded");
+    apply_log_level(CONFIG_LOG_VERBOSITY, NULL);
+    config_subscribe(CONFIG_LOG_VERBOSITY, &apply_log_level, NULL);
 
     // Initialise inputs
     buttons_init();
 
-    // Initialise framebuffer
-    fb_init();
+    // Initialise the scene scheduler and zones, so content can be queued as soon as the CLI is up
+    scene_init();
+    zone_init();
+
+    // Create the event group for system (e.g. Wi-Fi state change) events
+    sys_event_group = xEventGroupCreate();
+
+    // Start the rest of the tasks (see task_table.c), and sampling how much stack they use
+    task_table_start(TASK_START_LATE);
+    task_table_monitor();
+    boot_mark("tasks started");
 
-    // Start tasks
-    xTaskCreatePinnedToCore(&task_cli, "cli_task", 30000, NULL, 5, NULL, 0);
-    xTaskCreatePinnedToCore(&task_main, "main_task", 30000, NULL, 5, NULL, 0);
-    xTaskCreatePinnedToCore(&task_display, "display_task", 30000, NULL, 5, NULL, 1);
+    // Bring up Wi-Fi last, here rather than in the main task, so content doesn't wait for it
+    wifi_init();
+    boot_mark("wifi started");
 }
\ No newline at end of file
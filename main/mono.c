@@ -0,0 +1,285 @@
+#include <string.h>
+#include "mono.h"
+
+/**
+ * 1-bit drawing on column bitmasks.
+ *
+ * Columns are bytes in a union with the words they're packed into, so whole-plane operations run over
+ * MONO_WORDS words; this relies on the words being little-endian (as they are on the ESP32 and the host)
+ * only where a word is masked to the columns that exist.
+ */
+
+// MONO_COLUMN_MASK in each of a word's four columns
+#define MONO_LANES ((uint32_t)MONO_COLUMN_MASK * 0x01010101u)
+
+// The font, as its columns: built from font_4x5 (see display.c) the first time text is drawn
+extern char font_4x5[128][8];
+static uint8_t font_columns[128][DISPLAY_CHAR_WIDTH - 1];
+static bool font_ready = false;
+
+static void build_font()
+{
+    for (int ch = 0; ch < 128; ch ++) {
+        for (int col = 0; col < DISPLAY_CHAR_WIDTH - 1; col ++) {
+            uint8_t bits = 0;
+            for (int row = 0; row < DISPLAY_CHAR_HEIGHT; row ++) {
+                if (font_4x5[ch][row] & (1 << (3 - col))) {
+                    bits |= 1 << row;
+                }
+            }
+            font_columns[ch][col] = bits;
+        }
+    }
+
+    font_ready = true;
+}
+
+/**
+ * The bits of a word that are on the display.
+ */
+static uint32_t word_mask(int idx)
+{
+    int columns = DISPLAY_WIDTH - idx * 4;
+    return columns >= 4 ? MONO_LANES : MONO_LANES & ((1u << (columns * 8)) - 1);
+}
+
+static inline uint32_t combine(uint32_t dest, uint32_t source, mono_op_t op)
+{
+    switch (op) {
+        case MONO_SET: return source;
+        case MONO_AND: return dest & source;
+        case MONO_OR: return dest | source;
+        case MONO_XOR: return dest ^ source;
+        case MONO_AND_NOT: return dest & ~source;
+    }
+
+    return dest;
+}
+
+/**
+ * Set every pixel on or off.
+ */
+void mono_clear(mono_t* mono, bool on)
+{
+    for (int idx = 0; idx < MONO_WORDS; idx ++) {
+        mono->words[idx] = on ? word_mask(idx) : 0;
+    }
+}
+
+/**
+ * Set a single pixel, if it's on the display.
+ */
+void mono_pixel(mono_t* mono, int x, int y, bool on)
+{
+    if (x < 0 || y < 0 || x >= DISPLAY_WIDTH || y >= DISPLAY_HEIGHT) {
+        return;
+    }
+
+    if (on) {
+        mono->columns[x] |= 1 << y;
+    } else {
+        mono->columns[x] &= ~(1 << y);
+    }
+}
+
+/**
+ * Whether a pixel is lit (false if it's off the display).
+ */
+bool mono_get(const mono_t* mono, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= DISPLAY_WIDTH || y >= DISPLAY_HEIGHT) {
+        return false;
+    }
+
+    return (mono->columns[x] >> y) & 1;
+}
+
+/**
+ * Set a rectangle on or off, clipped to the display: a mask applied to each column it covers.
+ */
+void mono_rect(mono_t* mono, int x_pos, int y_pos, int width, int height, bool on)
+{
+    int first_row = y_pos < 0 ? 0 : y_pos;
+    int last_row = y_pos + height > DISPLAY_HEIGHT ? DISPLAY_HEIGHT : y_pos + height;
+    if (first_row >= last_row) {
+        return;
+    }
+
+    uint8_t mask = ((1 << (last_row - first_row)) - 1) << first_row;
+
+    int first_col = x_pos < 0 ? 0 : x_pos;
+    int last_col = x_pos + width > DISPLAY_WIDTH ? DISPLAY_WIDTH : x_pos + width;
+    for (int x = first_col; x < last_col; x ++) {
+        if (on) {
+            mono->columns[x] |= mask;
+        } else {
+            mono->columns[x] &= ~mask;
+        }
+    }
+}
+
+/**
+ * Draw a line between two points (inclusive), clipped to the display.
+ */
+void mono_line(mono_t* mono, int x0, int y0, int x1, int y1, bool on)
+{
+    // Straight lines are rectangles
+    if (x0 == x1 || y0 == y1) {
+        int x = x0 < x1 ? x0 : x1;
+        int y = y0 < y1 ? y0 : y1;
+        mono_rect(mono, x, y, (x0 > x1 ? x0 - x1 : x1 - x0) + 1, (y0 > y1 ? y0 - y1 : y1 - y0) + 1, on);
+        return;
+    }
+
+    // Otherwise Bresenham
+    int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+    int dy = y1 > y0 ? y0 - y1 : y1 - y0;
+    int step_x = x1 > x0 ? 1 : -1;
+    int step_y = y1 > y0 ? 1 : -1;
+    int error = dx + dy;
+
+    while (true) {
+        mono_pixel(mono, x0, y0, on);
+        if (x0 == x1 && y0 == y1) {
+            break;
+        }
+
+        int twice = 2 * error;
+        if (twice >= dy) {
+            error += dy;
+            x0 += step_x;
+        }
+        if (twice <= dx) {
+            error += dx;
+            y0 += step_y;
+        }
+    }
+}
+
+/**
+ * Fill with a checkerboard, as display_checkerboard() draws it.
+ */
+void mono_checkerboard(mono_t* mono, bool invert)
+{
+    // Odd rows in even columns, and even rows in odd columns (or the other way round)
+    uint8_t even = (0xaa & MONO_COLUMN_MASK) ^ (invert ? MONO_COLUMN_MASK : 0);
+    uint8_t odd = even ^ MONO_COLUMN_MASK;
+    uint32_t pattern = even | (odd << 8) | (even << 16) | ((uint32_t)odd << 24);
+
+    for (int idx = 0; idx < MONO_WORDS; idx ++) {
+        mono->words[idx] = pattern & word_mask(idx);
+    }
+}
+
+/**
+ * A character's DISPLAY_CHAR_WIDTH - 1 columns in the display font.
+ */
+const uint8_t* mono_glyph(char ch)
+{
+    if (!font_ready) {
+        build_font();
+    }
+
+    return font_columns[ch & 0x7f];
+}
+
+/**
+ * Draw text at a given x-coordinate, lighting its pixels (the rest are left as they are), as
+ * display_text() does.
+ */
+void mono_text(mono_t* mono, int x_pos, const char* text)
+{
+    for (const char* ch = text; *ch != '\0' && x_pos < DISPLAY_WIDTH; ch ++, x_pos += DISPLAY_CHAR_WIDTH) {
+        const uint8_t* columns = mono_glyph(*ch);
+        for (int col = 0; col < DISPLAY_CHAR_WIDTH - 1; col ++) {
+            int x = x_pos + col;
+            if (x >= 0 && x < DISPLAY_WIDTH) {
+                mono->columns[x] |= columns[col];
+            }
+        }
+    }
+}
+
+/**
+ * Draw `width` columns of bits (e.g. a column asset's data) with their top left at (x_pos, y_pos),
+ * combined with what's there. MONO_SET replaces the whole of each column the sprite covers.
+ */
+void mono_sprite(mono_t* mono, const uint8_t* columns, int width, int x_pos, int y_pos, mono_op_t op)
+{
+    int first_col = x_pos < 0 ? -x_pos : 0;
+    int last_col = x_pos + width > DISPLAY_WIDTH ? DISPLAY_WIDTH - x_pos : width;
+
+    for (int col = first_col; col < last_col; col ++) {
+        uint8_t bits = y_pos >= 0 ? columns[col] << y_pos : columns[col] >> -y_pos;
+        uint8_t* dest = &mono->columns[x_pos + col];
+        *dest = combine(*dest, bits, op) & MONO_COLUMN_MASK;
+    }
+}
+
+/**
+ * Move everything `dx` columns right and `dy` rows down (or left and up, if negative), bringing in blank
+ * columns and rows.
+ */
+void mono_shift(mono_t* mono, int dx, int dy)
+{
+    if (dx >= DISPLAY_WIDTH || dx <= -DISPLAY_WIDTH || dy >= DISPLAY_HEIGHT || dy <= -DISPLAY_HEIGHT) {
+        mono_clear(mono, false);
+        return;
+    }
+
+    if (dx > 0) {
+        memmove(&mono->columns[dx], mono->columns, DISPLAY_WIDTH - dx);
+        memset(mono->columns, 0, dx);
+    } else if (dx < 0) {
+        memmove(mono->columns, &mono->columns[-dx], DISPLAY_WIDTH + dx);
+        memset(&mono->columns[DISPLAY_WIDTH + dx], 0, -dx);
+    }
+
+    // Every column at once: bits carried into the next column land outside the kept rows
+    if (dy > 0) {
+        uint32_t keep = (uint32_t)((MONO_COLUMN_MASK << dy) & MONO_COLUMN_MASK) * 0x01010101u;
+        for (int idx = 0; idx < MONO_WORDS; idx ++) {
+            mono->words[idx] = (mono->words[idx] << dy) & keep;
+        }
+    } else if (dy < 0) {
+        uint32_t keep = (uint32_t)(MONO_COLUMN_MASK >> -dy) * 0x01010101u;
+        for (int idx = 0; idx < MONO_WORDS; idx ++) {
+            mono->words[idx] = (mono->words[idx] >> -dy) & keep;
+        }
+    }
+}
+
+/**
+ * Combine another plane into this one.
+ */
+void mono_combine(mono_t* dest, const mono_t* source, mono_op_t op)
+{
+    for (int idx = 0; idx < MONO_WORDS; idx ++) {
+        dest->words[idx] = combine(dest->words[idx], source->words[idx], op) & word_mask(idx);
+    }
+}
+
+/**
+ * Swap lit and unlit pixels.
+ */
+void mono_invert(mono_t* mono)
+{
+    for (int idx = 0; idx < MONO_WORDS; idx ++) {
+        mono->words[idx] ^= word_mask(idx);
+    }
+}
+
+/**
+ * Convert a plane to PWM values in the top left `width` x `height` of a display.
+ */
+void mono_render(const mono_t* mono, display_t* display, int width, int height, uint32_t pwm)
+{
+    for (int x = 0; x < width; x ++) {
+        uint8_t bits = mono->columns[x];
+        led_t* column = (*display)[x];
+        for (int y = 0; y < height; y ++) {
+            column[y].on = true;
+            column[y].pwm = (bits >> y) & 1 ? pwm : 0;
+        }
+    }
+}
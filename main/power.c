@@ -0,0 +1,99 @@
+#include <stdbool.h>
+#include "esp_log.h"
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#include "driver/uart.h"
+#include "sdkconfig.h"
+#include "config.h"
+#include "power.h"
+
+static const char* TAG = "Power";
+
+// Console UART edges needed to wake from light sleep (the characters that wake it are lost)
+#define POWER_UART_WAKE_THRESHOLD 3
+
+// Held whenever the display is active, and by anything else that can't tolerate light sleep
+static esp_pm_lock_handle_t active_lock;
+static esp_pm_lock_handle_t busy_lock;
+
+/**
+ * Apply the configured idle mode.
+ * The CPU frequency is fixed (no DFS), as the bit-banged I2C is timed in CPU cycles.
+ */
+static void power_configure(config_key_t key, void* arg)
+{
+    bool sleep = config_get_int(CONFIG_IDLE_MODE) == POWER_IDLE_SLEEP;
+
+    esp_pm_config_esp32_t pm_config = {
+        .max_freq_mhz = CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ,
+        .min_freq_mhz = CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ,
+        .light_sleep_enable = sleep
+    };
+
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "error (%s) configuring power management", esp_err_to_name(err));
+        return;
+    }
+
+    if (sleep) {
+        uart_set_wakeup_threshold(CONFIG_CONSOLE_UART_NUM, POWER_UART_WAKE_THRESHOLD);
+        esp_sleep_enable_uart_wakeup(CONFIG_CONSOLE_UART_NUM);
+    }
+
+    ESP_LOGI(TAG, "light sleep when idle %s", sleep ? "enabled" : "disabled");
+}
+
+/**
+ * Set up power management, starting out active.
+ */
+void power_init()
+{
+    esp_err_t err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "display", &active_lock);
+    if (err == ESP_OK) {
+        err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "busy", &busy_lock);
+    }
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "error (%s) creating power management locks", esp_err_to_name(err));
+        active_lock = NULL;
+        busy_lock = NULL;
+    } else {
+        esp_pm_lock_acquire(active_lock);
+    }
+
+    power_configure(CONFIG_IDLE_MODE, NULL);
+    config_subscribe(CONFIG_IDLE_MODE, &power_configure, NULL);
+}
+
+/**
+ * Allow light sleep while the display is idle, or prevent it once it's active again.
+ */
+void power_idle(bool idle)
+{
+    if (active_lock == NULL) {
+        return;
+    }
+
+    if (idle) {
+        esp_pm_lock_release(active_lock);
+    } else {
+        esp_pm_lock_acquire(active_lock);
+    }
+}
+
+/**
+ * Keep the CPU out of light sleep until power_busy(false) is called. Calls nest.
+ */
+void power_busy(bool busy)
+{
+    if (busy_lock == NULL) {
+        return;
+    }
+
+    if (busy) {
+        esp_pm_lock_acquire(busy_lock);
+    } else {
+        esp_pm_lock_release(busy_lock);
+    }
+}
@@ -0,0 +1,792 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "dlog.h"
+#include "esp_timer.h"
+#include "scene.h"
+#include "config.h"
+#include "transition.h"
+#include "frame_buffer.h"
+#include "cycles.h"
+#include "effects.h"
+#include "mono.h"
+
+/**
+ * Plays a playlist of scenes, moving between them with transitions.
+ *
+ * The next scene is built (its first frame rendered and its transition set up) as soon as the current
+ * one has fully appeared, so the transition out of a held scene starts without a render spike.
+ * Procedural effects keep animating until the end of the hold, so the scene after one of them is built
+ * from its final frame instead.
+ *
+ * Transitions, scrolling and effects are handed to the display task to render at each refresh (see
+ * fb_animate()), so the scheduler sleeps until they finish or a higher priority scene interrupts.
+ */
+
+static const char* TAG = "Scene";
+
+// Default time per step of each transition, and the time per step of scrolling text
+// Horizontal movements have four times as many steps as vertical ones, so take roughly the same time overall
+static const uint32_t transition_step_ms[] = {
+    [SCENE_CUT] = 0,
+    [SCENE_WIPE_UP] = 100, [SCENE_WIPE_DOWN] = 100, [SCENE_WIPE_LEFT] = 30, [SCENE_WIPE_RIGHT] = 30,
+    [SCENE_PUSH_UP] = 100, [SCENE_PUSH_DOWN] = 100, [SCENE_PUSH_LEFT] = 30, [SCENE_PUSH_RIGHT] = 30,
+    [SCENE_SLIDE_UP] = 100, [SCENE_SLIDE_DOWN] = 100, [SCENE_SLIDE_LEFT] = 30, [SCENE_SLIDE_RIGHT] = 30,
+    [SCENE_FADE] = 30,
+    [SCENE_IRIS_OPEN] = 50, [SCENE_IRIS_CLOSE] = 50,
+    [SCENE_DISSOLVE] = 20
+};
+#define SCENE_SCROLL_STEP_MS 75
+
+// How long to wait for space in the render-ahead queue before dropping a frame
+#define SCENE_PUSH_TIMEOUT_MS 100
+
+// Number of steps in a fade and a dissolve
+#define SCENE_FADE_STEPS 32
+#define SCENE_DISSOLVE_STEPS 32
+
+// Names used in playlists, indexed by scene_effect_t and scene_transition_t
+static const char* effect_names[] = { "blank", "fill", "checkerboard", "checkerboard_inverse", "left", "right" };
+static const char* transition_names[] = {
+    "cut", "wipe_up", "wipe_down", "fade", "wipe_left", "wipe_right",
+    "push_up", "push_down", "push_left", "push_right", "slide_up", "slide_down", "slide_left", "slide_right",
+    "iris_open", "iris_close", "dissolve"
+};
+
+/**
+ * A scene being played or waiting to be played.
+ */
+typedef struct {
+    scene_entry_t entry;
+
+    // Whether the entry came from the injected queue rather than the playlist
+    bool queued;
+
+    // The first frame of the scene
+    display_t target;
+
+    // The transition into the scene (NULL for a cut), and the text scroll (NULL for static content)
+    trans_handle_t* transition;
+    trans_handle_t* scroll;
+
+    // Procedural effect state, and when its next frame is due and its hold ends
+    effect_t effect;
+    int64_t next_frame_us;
+    int64_t hold_end_us;
+} scene_t;
+
+// The playlist, and scratch space for parsing a new one
+static scene_entry_t playlist[SCENE_MAX_ENTRIES];
+static scene_entry_t parsed[SCENE_MAX_ENTRIES];
+static size_t playlist_length;
+static size_t playlist_index;
+static volatile bool reload_requested;
+
+// Scenes injected with scene_show(), and what's needed to decide whether they interrupt
+static QueueHandle_t scene_queue;
+static TaskHandle_t scheduler_task;
+static volatile uint8_t current_priority;
+
+// The scene playing and the one being built, plus the frame last shown
+static scene_t scenes[2];
+static const display_t* shown;
+
+/**
+ * Look a name up in a table, returning its index or -1.
+ */
+static int name_index(const char* name, const char** names, size_t count)
+{
+    for (size_t idx = 0; idx < count; idx ++) {
+        if (strcmp(name, names[idx]) == 0) {
+            return idx;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Describe an entry's content for logging.
+ */
+static const char* content_name(const scene_entry_t* entry)
+{
+    switch (entry->type) {
+        case SCENE_TEXT: return entry->content.text;
+        case SCENE_EFFECT: return effect_names[entry->content.effect];
+        case SCENE_PROCEDURAL: return effect_name(entry->content.procedural);
+        case SCENE_ASSET: return entry->content.asset->name;
+        default: return "";
+    }
+}
+
+/**
+ * Parse the content field of a playlist entry.
+ */
+static int parse_content(const char* field, scene_entry_t* entry)
+{
+    if (strncmp(field, "text:", 5) == 0) {
+        entry->type = SCENE_TEXT;
+        snprintf(entry->content.text, sizeof(entry->content.text), "%s", field + 5);
+        return 0;
+    }
+
+    if (strncmp(field, "image:", 6) == 0) {
+        const char* hex = field + 6;
+        if (strlen(hex) != DISPLAY_WIDTH * 2) {
+            return -1;
+        }
+
+        entry->type = SCENE_IMAGE;
+        for (int col = 0; col < DISPLAY_WIDTH; col ++) {
+            char byte[3] = { hex[col * 2], hex[col * 2 + 1], '\0' };
+            char* end;
+            entry->content.image[col] = strtoul(byte, &end, 16);
+            if (*end != '\0') {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    if (strncmp(field, "asset:", 6) == 0) {
+        entry->type = SCENE_ASSET;
+        entry->content.asset = asset_find(field + 6);
+        return entry->content.asset != NULL ? 0 : -1;
+    }
+
+    if (strncmp(field, "effect:", 7) == 0) {
+        int effect = name_index(field + 7, effect_names, sizeof(effect_names) / sizeof(effect_names[0]));
+        if (effect >= 0) {
+            entry->type = SCENE_EFFECT;
+            entry->content.effect = effect;
+            return 0;
+        }
+
+        effect = effect_find(field + 7);
+        if (effect >= 0) {
+            entry->type = SCENE_PROCEDURAL;
+            entry->content.procedural = effect;
+            return 0;
+        }
+
+        return -1;
+    }
+
+    return -1;
+}
+
+/**
+ * Parse a single playlist entry (content|transition[:ms]|duration_ms|priority).
+ * Modifies `item`.
+ */
+static int parse_entry(char* item, scene_entry_t* entry)
+{
+    char* content = strsep(&item, "|");
+    char* transition = strsep(&item, "|");
+    char* duration = strsep(&item, "|");
+    char* priority = strsep(&item, "|");
+
+    memset(entry, 0, sizeof(scene_entry_t));
+    entry->transition = SCENE_CUT;
+    entry->duration_ms = SCENE_DEFAULT_DURATION_MS;
+    entry->priority = SCENE_DEFAULT_PRIORITY;
+
+    if (parse_content(content, entry) != 0) {
+        return -1;
+    }
+
+    if (transition != NULL && *transition != '\0') {
+        char* transition_ms = transition;
+        transition = strsep(&transition_ms, ":");
+        if (transition_ms != NULL) {
+            entry->transition_ms = strtoul(transition_ms, NULL, 10);
+        }
+
+        int idx = name_index(transition, transition_names, sizeof(transition_names) / sizeof(transition_names[0]));
+        if (idx < 0) {
+            return -1;
+        }
+        entry->transition = idx;
+    }
+
+    if (duration != NULL && *duration != '\0') {
+        entry->duration_ms = strtoul(duration, NULL, 10);
+    }
+
+    if (priority != NULL && *priority != '\0') {
+        entry->priority = atoi(priority);
+    }
+
+    return 0;
+}
+
+/**
+ * Parse a playlist.
+ */
+int scene_parse(const char* spec, scene_entry_t* entries, size_t max)
+{
+    if (spec == NULL) {
+        return -1;
+    }
+
+    char* copy = strdup(spec);
+    char* rest = copy;
+    char* item;
+    int count = 0;
+
+    while ((item = strsep(&rest, ";")) != NULL) {
+
+        // Allow empty entries, e.g. a trailing separator
+        if (*item == '\0') {
+            continue;
+        }
+
+        if (count == max) {
+            ESP_LOGW(TAG, "playlist has more than %d entries", (int)max);
+            count = -1;
+            break;
+        }
+
+        if (parse_entry(item, &entries[count]) != 0) {
+            ESP_LOGW(TAG, "invalid playlist entry %d", count + 1);
+            count = -1;
+            break;
+        }
+
+        count ++;
+    }
+
+    free(copy);
+    return count;
+}
+
+/**
+ * (Re)load the playlist from config, keeping the current one if the new one is invalid.
+ */
+static void load_playlist()
+{
+    int count = scene_parse(config_get(CONFIG_PLAYLIST), parsed, SCENE_MAX_ENTRIES);
+
+    if (count > 0) {
+        memcpy(playlist, parsed, count * sizeof(scene_entry_t));
+        playlist_length = count;
+        playlist_index = 0;
+        ESP_LOGI(TAG, "loaded playlist of %d scenes", count);
+        return;
+    }
+
+    if (playlist_length == 0) {
+        ESP_LOGW(TAG, "no valid playlist, showing a blank display");
+        memset(&playlist[0], 0, sizeof(scene_entry_t));
+        playlist[0].type = SCENE_EFFECT;
+        playlist[0].content.effect = SCENE_EFFECT_BLANK;
+        playlist[0].duration_ms = SCENE_DEFAULT_DURATION_MS;
+        playlist_length = 1;
+        playlist_index = 0;
+    } else {
+        ESP_LOGW(TAG, "invalid playlist, keeping the previous one");
+    }
+}
+
+/**
+ * Take the next entry to play: injected scenes first, then the playlist.
+ * Returns true if the entry came from the injected queue.
+ */
+static bool next_entry(scene_entry_t* entry)
+{
+    if (xQueueReceive(scene_queue, entry, 0) == pdTRUE) {
+        return true;
+    }
+
+    if (reload_requested) {
+        reload_requested = false;
+        load_playlist();
+    }
+
+    *entry = playlist[playlist_index];
+    playlist_index = (playlist_index + 1) % playlist_length;
+    return false;
+}
+
+/**
+ * Put back an entry taken with next_entry() that didn't get to play.
+ */
+static void unget_entry(const scene_entry_t* entry, bool queued)
+{
+    if (queued) {
+        xQueueSendToFront(scene_queue, entry, 0);
+    } else {
+        playlist_index = (playlist_index + playlist_length - 1) % playlist_length;
+    }
+}
+
+/**
+ * Render text, image, asset or fixed effect content into the top left `width` x `height` of a display,
+ * clearing it first. Text and assets are centred if they fit and otherwise cut off; content outside the
+ * area is left untouched.
+ */
+void scene_render(const scene_entry_t* entry, display_t* target, int width, int height)
+{
+    // On/off content is drawn as a plane and converted once; assets are drawn across the whole of this and
+    // copied, as they're only clipped to the display
+    mono_t mono;
+    static display_t scratch;
+    bool use_scratch = false;
+
+    display_rect(target, 0, 0, width, height, 0x00, true);
+
+    switch (entry->type) {
+        case SCENE_TEXT: {
+            int text_width = strlen(entry->content.text) * DISPLAY_CHAR_WIDTH;
+            mono_clear(&mono, false);
+            mono_text(&mono, text_width <= width ? (width - text_width) / 2 : 0, entry->content.text);
+            mono_render(&mono, target, width, height, 0xff);
+            break;
+        }
+
+        case SCENE_IMAGE:
+            for (int x = 0; x < width; x ++) {
+                for (int y = 0; y < height; y ++) {
+                    (*target)[x][y].pwm = (entry->content.image[x] >> y) & 1 ? 0xff : 0x00;
+                }
+            }
+            break;
+
+        case SCENE_EFFECT:
+            switch (entry->content.effect) {
+                case SCENE_EFFECT_BLANK: break;
+                case SCENE_EFFECT_FILL: display_rect(target, 0, 0, width, height, 0xff, true); break;
+                case SCENE_EFFECT_CHECKERBOARD:
+                case SCENE_EFFECT_CHECKERBOARD_INVERSE:
+                    mono_checkerboard(&mono, entry->content.effect == SCENE_EFFECT_CHECKERBOARD_INVERSE);
+                    mono_render(&mono, target, width, height, 0xff);
+                    break;
+                case SCENE_EFFECT_LEFT: display_rect(target, 0, 0, width / 2, height, 0xff, true); break;
+                case SCENE_EFFECT_RIGHT: display_rect(target, width / 2, 0, width - width / 2, height, 0xff, true); break;
+            }
+            break;
+
+        case SCENE_ASSET: {
+            const asset_t* asset = entry->content.asset;
+            display_fill(&scratch, 0x00, true);
+            asset_blit(&scratch, asset, asset->width <= width ? (width - asset->width) / 2 : 0, 0, 0xff);
+            use_scratch = true;
+            break;
+        }
+
+        case SCENE_PROCEDURAL:
+            break;
+    }
+
+    if (use_scratch) {
+        for (int x = 0; x < width; x ++) {
+            memcpy((*target)[x], scratch[x], height * sizeof(led_t));
+        }
+    }
+}
+
+/**
+ * Render the first frame of an entry's content, and start its scroll if the content scrolls.
+ */
+static void render_content(scene_t* scene)
+{
+    display_t* target = &scene->target;
+
+    switch (scene->entry.type) {
+        case SCENE_TEXT:
+            if (strlen(scene->entry.content.text) * DISPLAY_CHAR_WIDTH <= DISPLAY_WIDTH) {
+                scene_render(&scene->entry, target, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+            } else {
+                // Scroll on from a blank display, leaving the end of the text in view
+                display_fill(target, 0x00, true);
+                scene->scroll = trans_scroll_text(scene->entry.content.text, false, SCROLL_START_CLEAR, SCROLL_END_FULL);
+            }
+            break;
+
+        case SCENE_ASSET:
+            if (scene->entry.content.asset->width <= DISPLAY_WIDTH || scene->entry.content.asset->format != ASSET_COLUMNS) {
+                scene_render(&scene->entry, target, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+            } else {
+                // Banners scroll like text, straight from flash
+                display_fill(target, 0x00, true);
+                scene->scroll = trans_scroll_asset(scene->entry.content.asset, false, SCROLL_START_CLEAR, SCROLL_END_FULL);
+            }
+            break;
+
+        case SCENE_PROCEDURAL:
+            // The first frame is always rendered in full, however long it takes
+            display_fill(target, 0x00, true);
+            effect_start(&scene->effect, scene->entry.content.procedural, xTaskGetTickCount());
+            while (!effect_render(&scene->effect, target));
+            break;
+
+        default:
+            scene_render(&scene->entry, target, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+            break;
+    }
+}
+
+/**
+ * Set up the transition from one frame to another (NULL for a cut).
+ */
+trans_handle_t* scene_transition(scene_transition_t transition, const display_t* from, const display_t* to)
+{
+    switch (transition) {
+        case SCENE_CUT: return NULL;
+        case SCENE_WIPE_UP: return trans_wipe(from, to, WIPE_UP);
+        case SCENE_WIPE_DOWN: return trans_wipe(from, to, WIPE_DOWN);
+        case SCENE_WIPE_LEFT: return trans_wipe(from, to, WIPE_LEFT);
+        case SCENE_WIPE_RIGHT: return trans_wipe(from, to, WIPE_RIGHT);
+        case SCENE_PUSH_UP: return trans_push(from, to, WIPE_UP);
+        case SCENE_PUSH_DOWN: return trans_push(from, to, WIPE_DOWN);
+        case SCENE_PUSH_LEFT: return trans_push(from, to, WIPE_LEFT);
+        case SCENE_PUSH_RIGHT: return trans_push(from, to, WIPE_RIGHT);
+        case SCENE_SLIDE_UP: return trans_slide(from, to, WIPE_UP);
+        case SCENE_SLIDE_DOWN: return trans_slide(from, to, WIPE_DOWN);
+        case SCENE_SLIDE_LEFT: return trans_slide(from, to, WIPE_LEFT);
+        case SCENE_SLIDE_RIGHT: return trans_slide(from, to, WIPE_RIGHT);
+        case SCENE_FADE: return trans_fade(from, to, SCENE_FADE_STEPS);
+        case SCENE_IRIS_OPEN: return trans_iris(from, to, false);
+        case SCENE_IRIS_CLOSE: return trans_iris(from, to, true);
+        case SCENE_DISSOLVE: return trans_dissolve(from, to, SCENE_DISSOLVE_STEPS);
+    }
+
+    return NULL;
+}
+
+/**
+ * How long an entry's transition takes: as given in the entry, or by default a fixed time per step.
+ */
+uint32_t scene_transition_ms(const scene_entry_t* entry, const trans_handle_t* handle)
+{
+    if (entry->transition_ms > 0) {
+        return entry->transition_ms;
+    }
+
+    return handle->steps * transition_step_ms[entry->transition];
+}
+
+/**
+ * Build a scene ready to play, transitioning in from `from`.
+ */
+static void scene_prepare(scene_t* scene, const scene_entry_t* entry, bool queued, const display_t* from)
+{
+    uint32_t start = cycles_now();
+
+    scene->entry = *entry;
+    scene->queued = queued;
+    scene->transition = NULL;
+    scene->scroll = NULL;
+    render_content(scene);
+
+    scene->transition = scene_transition(entry->transition, from, &scene->target);
+
+    DLOGD(TAG, "built scene in %u " CYCLES_UNIT, cycles_now() - start);
+}
+
+/**
+ * Free everything a scene allocated.
+ */
+static void scene_release(scene_t* scene)
+{
+    if (scene->entry.type == SCENE_PROCEDURAL && scene->effect.overruns > 0) {
+        ESP_LOGW(
+            TAG, "effect %s ran over its budget on %u of %u frames",
+            content_name(&scene->entry), scene->effect.overruns, scene->effect.frame
+        );
+    }
+
+    trans_free(scene->transition);
+    trans_free(scene->scroll);
+    scene->transition = NULL;
+    scene->scroll = NULL;
+}
+
+/**
+ * Push a frame to the display, remembering it as the starting point for the next transition.
+ */
+static void scene_push(display_t* frame)
+{
+    shown = frame;
+    fb_push(frame, SCENE_PUSH_TIMEOUT_MS / portTICK_PERIOD_MS);
+}
+
+/**
+ * Whether a queued scene should interrupt the current one.
+ */
+static bool scene_preempted()
+{
+    scene_entry_t entry;
+    return xQueuePeek(scene_queue, &entry, 0) == pdTRUE && entry.priority > current_priority;
+}
+
+/**
+ * Wait until `ms` after `last_wake`, as vTaskDelayUntil() does.
+ * Returns true early if a higher priority scene is queued in the meantime.
+ */
+static bool scene_wait(TickType_t* last_wake, uint32_t ms)
+{
+    TickType_t ticks = ms / portTICK_PERIOD_MS;
+    TickType_t deadline = *last_wake + (ticks ? ticks : 1);
+
+    while (true) {
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(deadline - now) <= 0) {
+            *last_wake = deadline;
+            return false;
+        }
+
+        if (ulTaskNotifyTake(pdTRUE, deadline - now) && scene_preempted()) {
+            *last_wake = xTaskGetTickCount();
+            return true;
+        }
+    }
+}
+
+/**
+ * Hand an animation to the display task and wait for it to finish.
+ * Returns true (having stopped it) if a higher priority scene is queued in the meantime.
+ */
+static bool scene_animate(fb_animation_t* animation, TickType_t* last_wake)
+{
+    animation->notify = scheduler_task;
+    fb_animate(animation);
+
+    bool interrupted = false;
+    while (!animation->is_finished) {
+        if (ulTaskNotifyTake(pdTRUE, portMAX_DELAY) && scene_preempted()) {
+            fb_stop(animation);
+            interrupted = true;
+            break;
+        }
+    }
+
+    *last_wake = xTaskGetTickCount();
+    return interrupted;
+}
+
+/**
+ * Render a transition for the display task: whatever steps are due, finishing a step's time after the last.
+ */
+static const display_t* render_transition(fb_animation_t* animation, int64_t now_us)
+{
+    trans_handle_t* handle = animation->arg;
+    bool stepped = trans_progress_to(handle, now_us) > 0;
+    animation->is_finished = handle->is_finished && now_us >= trans_next_due_us(handle);
+    return stepped ? handle->current : NULL;
+}
+
+/**
+ * Play a transition through over `duration_ms`.
+ * The display task steps it in place at each refresh, catching up on any steps it misses, so there's no
+ * copy per step and it still finishes on time if flushes run long.
+ * Returns true if it was interrupted.
+ */
+static bool scene_step(trans_handle_t* handle, uint32_t duration_ms, TickType_t* last_wake)
+{
+    static fb_animation_t animation = { .render = &render_transition };
+
+    trans_start(handle, esp_timer_get_time(), duration_ms);
+    animation.arg = handle;
+    bool interrupted = scene_animate(&animation, last_wake);
+    shown = handle->current;
+    return interrupted;
+}
+
+/**
+ * Render a procedural effect for the display task, a frame at a time until the end of the hold.
+ */
+static const display_t* render_effect(fb_animation_t* animation, int64_t now_us)
+{
+    scene_t* scene = animation->arg;
+
+    if (now_us >= scene->hold_end_us) {
+        animation->is_finished = true;
+        return NULL;
+    }
+
+    if (now_us < scene->next_frame_us) {
+        return NULL;
+    }
+
+    // Frames missed while the display task was busy are skipped, as effects only move forward a frame at a time
+    scene->next_frame_us += EFFECT_FRAME_MS * 1000;
+    if (scene->next_frame_us <= now_us) {
+        scene->next_frame_us = now_us + EFFECT_FRAME_MS * 1000;
+    }
+
+    effect_render(&scene->effect, &scene->target);
+    return &scene->target;
+}
+
+/**
+ * Play a scene until it has fully appeared: its transition in, then any scrolling.
+ * Returns true if it was interrupted.
+ */
+static bool scene_play(scene_t* scene, TickType_t* last_wake)
+{
+    ESP_LOGI(
+        TAG, "scene: %s %s (%s, %ums, priority %d)",
+        scene->entry.type == SCENE_TEXT ? "text" : scene->entry.type == SCENE_IMAGE ? "image" :
+            scene->entry.type == SCENE_ASSET ? "asset" : "effect",
+        content_name(&scene->entry),
+        transition_names[scene->entry.transition], scene->entry.duration_ms, scene->entry.priority
+    );
+
+    if (scene->transition != NULL) {
+        if (scene_step(scene->transition, scene_transition_ms(&scene->entry, scene->transition), last_wake)) {
+            return true;
+        }
+    } else {
+        scene_push(&scene->target);
+    }
+
+    if (scene->scroll != NULL) {
+        return scene_step(scene->scroll, scene->scroll->steps * SCENE_SCROLL_STEP_MS, last_wake);
+    }
+
+    return false;
+}
+
+/**
+ * Hold a scene for its duration, animating it if it's a procedural effect.
+ * Returns true if it was interrupted.
+ */
+static bool scene_hold(scene_t* scene, TickType_t* last_wake)
+{
+    if (scene->entry.type != SCENE_PROCEDURAL) {
+        return scene_wait(last_wake, scene->entry.duration_ms);
+    }
+
+    static fb_animation_t animation = { .render = &render_effect };
+
+    int64_t now_us = esp_timer_get_time();
+    scene->next_frame_us = now_us;
+    scene->hold_end_us = now_us + (int64_t)scene->entry.duration_ms * 1000;
+    animation.arg = scene;
+    bool interrupted = scene_animate(&animation, last_wake);
+    shown = &scene->target;
+    return interrupted;
+}
+
+/**
+ * Set up the scheduler.
+ */
+void scene_init()
+{
+    scene_queue = xQueueCreate(SCENE_QUEUE_LENGTH, sizeof(scene_entry_t));
+}
+
+/**
+ * Reload the playlist from config before the next playlist entry is taken.
+ */
+void scene_reload()
+{
+    reload_requested = true;
+}
+
+/**
+ * Queue a scene to play next.
+ * A scene with a higher priority than the one playing interrupts it and jumps the queue.
+ */
+int scene_show(const scene_entry_t* entry)
+{
+    if (scene_queue == NULL) {
+        return -1;
+    }
+
+    bool preempt = entry->priority > current_priority;
+    BaseType_t queued = preempt ? xQueueSendToFront(scene_queue, entry, 0) : xQueueSendToBack(scene_queue, entry, 0);
+
+    if (queued != pdTRUE) {
+        ESP_LOGW(TAG, "scene queue full, dropping scene");
+        return -1;
+    }
+
+    if (preempt && scheduler_task != NULL) {
+        xTaskNotifyGive(scheduler_task);
+    }
+
+    return 0;
+}
+
+/**
+ * Run the playlist.
+ */
+void scene_run()
+{
+    scheduler_task = xTaskGetCurrentTaskHandle();
+    load_playlist();
+
+    static display_t blank;
+    display_fill(&blank, 0x00, true);
+    shown = &blank;
+
+    scene_t* current = &scenes[0];
+    scene_t* next = &scenes[1];
+    scene_entry_t entry;
+
+    bool queued = next_entry(&entry);
+    scene_prepare(current, &entry, queued, shown);
+
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (true) {
+        current_priority = current->entry.priority;
+        bool interrupted = scene_play(current, &last_wake);
+        bool prepared = false;
+
+        // Build the next scene while this one is held, unless it's still changing
+        if (!interrupted && current->entry.type != SCENE_PROCEDURAL) {
+            queued = next_entry(&entry);
+            scene_prepare(next, &entry, queued, shown);
+            prepared = true;
+        }
+
+        if (!interrupted) {
+            interrupted = scene_hold(current, &last_wake);
+        }
+
+        if (!interrupted && !prepared) {
+            queued = next_entry(&entry);
+            scene_prepare(next, &entry, queued, shown);
+        }
+
+        if (interrupted) {
+            // Switch to the interrupting scene from whatever is on the display now
+            xQueueReceive(scene_queue, &entry, 0);
+            if (prepared) {
+                scene_release(next);
+                unget_entry(&next->entry, next->queued);
+            }
+            scene_prepare(next, &entry, true, shown);
+        }
+
+        // The next scene has its own copy of the outgoing frame, so this one can go
+        scene_release(current);
+        scene_t* swap = current;
+        current = next;
+        next = swap;
+    }
+}
+
+/**
+ * Print the playlist.
+ */
+void scene_print()
+{
+    for (size_t idx = 0; idx < playlist_length; idx ++) {
+        const scene_entry_t* entry = &playlist[idx];
+        printf(
+            "%2d: %-6s %-24s %-9s %6ums  priority %d\n", (int)idx,
+            entry->type == SCENE_TEXT ? "text" : entry->type == SCENE_IMAGE ? "image" :
+                entry->type == SCENE_ASSET ? "asset" : "effect",
+            content_name(entry),
+            transition_names[entry->transition], entry->duration_ms, entry->priority
+        );
+    }
+}
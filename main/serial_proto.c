@@ -0,0 +1,178 @@
+#include <string.h>
+#include "serial_proto.h"
+
+/**
+ * Incremental parser for the binary serial frame protocol.
+ *
+ * Bytes are fed in as they arrive from the UART, in chunks of any size. Once a complete packet with a
+ * valid CRC has been parsed, serial_decode() applies it directly to a display (normally the frame buffer).
+ * This module has no UART or RTOS dependencies - see binary mode in task_cli for the UART side.
+ */
+
+// CRC-16/CCITT-FALSE, a nibble at a time
+static const uint16_t crc16_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+};
+
+/**
+ * Update a CRC-16/CCITT-FALSE (initial value 0xFFFF) with some data.
+ */
+uint16_t serial_crc16(uint16_t crc, const uint8_t* data, size_t length)
+{
+    while (length --) {
+        crc = (crc << 4) ^ crc16_nibble[(crc >> 12) ^ (*data >> 4)];
+        crc = (crc << 4) ^ crc16_nibble[(crc >> 12) ^ (*data & 0x0F)];
+        data ++;
+    }
+    return crc;
+}
+
+/**
+ * Initialise a parser, ready to look for the start of a packet.
+ */
+void serial_parser_init(serial_parser_t* parser)
+{
+    memset(parser, 0, sizeof(serial_parser_t));
+    parser->state = SERIAL_STATE_SYNC_0;
+}
+
+/**
+ * Feed received bytes to the parser.
+ *
+ * Parsing stops after a complete, valid packet, returning its type and leaving the payload in the parser
+ * until the next call. `consumed` is set to the number of bytes used, and any remaining bytes must be
+ * fed in again. Returns SERIAL_NONE if all of the data was consumed without completing a packet.
+ */
+serial_packet_type_t serial_parse(serial_parser_t* parser, const uint8_t* data, size_t length, size_t* consumed)
+{
+    size_t pos = 0;
+
+    while (pos < length) {
+
+        // Take as much of the payload as is available in one go
+        if (parser->state == SERIAL_STATE_PAYLOAD) {
+            size_t take = parser->length - parser->pos;
+            if (take > length - pos) {
+                take = length - pos;
+            }
+
+            memcpy(&parser->payload[parser->pos], &data[pos], take);
+            parser->crc = serial_crc16(parser->crc, &data[pos], take);
+            parser->pos += take;
+            pos += take;
+
+            if (parser->pos == parser->length) {
+                parser->state = SERIAL_STATE_CRC_LO;
+            }
+            continue;
+        }
+
+        uint8_t byte = data[pos ++];
+
+        switch (parser->state) {
+
+            case SERIAL_STATE_SYNC_0:
+                if (byte == SERIAL_SYNC_0) {
+                    parser->state = SERIAL_STATE_SYNC_1;
+                }
+                break;
+
+            case SERIAL_STATE_SYNC_1:
+                parser->state = byte == SERIAL_SYNC_1 ? SERIAL_STATE_TYPE : byte == SERIAL_SYNC_0 ? SERIAL_STATE_SYNC_1 : SERIAL_STATE_SYNC_0;
+                break;
+
+            case SERIAL_STATE_TYPE:
+                parser->type = byte;
+                parser->crc = serial_crc16(0xFFFF, &byte, 1);
+                parser->state = SERIAL_STATE_LENGTH_LO;
+                break;
+
+            case SERIAL_STATE_LENGTH_LO:
+                parser->length = byte;
+                parser->crc = serial_crc16(parser->crc, &byte, 1);
+                parser->state = SERIAL_STATE_LENGTH_HI;
+                break;
+
+            case SERIAL_STATE_LENGTH_HI:
+                parser->length |= byte << 8;
+                parser->crc = serial_crc16(parser->crc, &byte, 1);
+                parser->pos = 0;
+
+                if (parser->length > SERIAL_MAX_PAYLOAD) {
+                    parser->invalid ++;
+                    parser->state = SERIAL_STATE_SYNC_0;
+                } else {
+                    parser->state = parser->length ? SERIAL_STATE_PAYLOAD : SERIAL_STATE_CRC_LO;
+                }
+                break;
+
+            case SERIAL_STATE_PAYLOAD:
+                break;
+
+            case SERIAL_STATE_CRC_LO:
+                parser->received_crc = byte;
+                parser->state = SERIAL_STATE_CRC_HI;
+                break;
+
+            case SERIAL_STATE_CRC_HI:
+                parser->received_crc |= byte << 8;
+                parser->state = SERIAL_STATE_SYNC_0;
+
+                if (parser->received_crc != parser->crc) {
+                    parser->crc_errors ++;
+                    break;
+                }
+
+                parser->packets ++;
+                *consumed = pos;
+                return parser->type;
+        }
+    }
+
+    *consumed = pos;
+    return SERIAL_NONE;
+}
+
+/**
+ * Apply the last parsed SERIAL_FRAME or SERIAL_REGION packet to a display.
+ * Returns false (leaving the display untouched) if the payload doesn't make sense.
+ */
+bool serial_decode(serial_parser_t* parser, display_t* display)
+{
+    const uint8_t* payload = parser->payload;
+
+    if (parser->type == SERIAL_FRAME && parser->length == DISPLAY_PIXELS) {
+        display_load_pwm(display, payload);
+        return true;
+    }
+
+    if (parser->type == SERIAL_REGION && parser->length >= 4) {
+        uint8_t x = payload[0];
+        uint8_t y = payload[1];
+        uint8_t width = payload[2];
+        uint8_t height = payload[3];
+
+        if (
+            x + width > DISPLAY_WIDTH || y + height > DISPLAY_HEIGHT ||
+            parser->length != 4 + width * height
+        ) {
+            parser->invalid ++;
+            return false;
+        }
+
+        payload += 4;
+        for (int col = x; col < x + width; col ++) {
+            for (int row = y; row < y + height; row ++) {
+                (*display)[col][row].pwm = *payload;
+                (*display)[col][row].on = *payload != 0;
+                payload ++;
+            }
+        }
+
+        return true;
+    }
+
+    parser->invalid ++;
+    return false;
+}
@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <string.h>
+#include "cycles.h"
+#include "stats.h"
+
+/**
+ * Frame pipeline statistics.
+ *
+ * Counters are bumped with relaxed atomic adds so any task can record without taking a lock.
+ * The frame ring has a single writer (the display task) and readers just copy out whatever is there,
+ * so a reader racing the writer may see one half-updated frame record, which is fine for diagnostics.
+ */
+
+stats_t stats;
+
+// Lateness of the most recent display task wakeup, attached to the next presented frame
+static int32_t last_lateness_us = 0;
+
+static inline void counter_add(uint32_t* counter, uint32_t value)
+{
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+}
+
+/**
+ * Add a sample to a histogram.
+ */
+static void hist_add(stats_hist_t* hist, uint32_t us)
+{
+    uint32_t bucket = us ? 32 - __builtin_clz(us) : 0;
+    if (bucket >= STATS_HIST_BUCKETS) {
+        bucket = STATS_HIST_BUCKETS - 1;
+    }
+
+    counter_add(&hist->buckets[bucket], 1);
+
+    if (us > hist->max_us) {
+        hist->max_us = us;
+    }
+}
+
+/**
+ * Record a frame being pushed to the frame buffer (or dropped because it couldn't be).
+ */
+void stats_push(bool dropped)
+{
+    counter_add(dropped ? &stats.frames_dropped : &stats.frames_pushed, 1);
+}
+
+/**
+ * Record the render-ahead queue depth after a push.
+ */
+void stats_queue(uint32_t depth)
+{
+    if (depth > stats.queue_max) {
+        stats.queue_max = depth;
+    }
+}
+
+/**
+ * Record the time taken to render a frame.
+ */
+void stats_render(uint32_t cycles)
+{
+    hist_add(&stats.render, cycles / CYCLES_PER_US);
+}
+
+/**
+ * Record the display task waking up `lateness_us` after it was due.
+ */
+void stats_lateness(int32_t lateness_us)
+{
+    last_lateness_us = lateness_us;
+    hist_add(&stats.lateness, lateness_us > 0 ? lateness_us : 0);
+}
+
+/**
+ * Record a queued frame that wasn't flushed, as it matched what was already shown.
+ */
+void stats_unchanged()
+{
+    counter_add(&stats.frames_unchanged, 1);
+}
+
+/**
+ * Record the display going idle, with or without shutting the chips down.
+ */
+void stats_idle(bool shutdown)
+{
+    counter_add(&stats.idle_entries, 1);
+    if (shutdown) {
+        counter_add(&stats.idle_shutdowns, 1);
+    }
+}
+
+/**
+ * Record how long it took to resume from idle, from the frame being committed to it being shown.
+ */
+void stats_resume(uint32_t resume_us)
+{
+    hist_add(&stats.resume, resume_us);
+}
+
+/**
+ * Record a frame with a presentation time starting to flush `late_us` after that time.
+ */
+void stats_present(int32_t late_us)
+{
+    hist_add(&stats.present, late_us > 0 ? late_us : 0);
+}
+
+/**
+ * Record a frame being flushed to the display.
+ * Must only be called from the display task.
+ */
+void stats_flush(uint32_t cycles, uint32_t i2c_bytes)
+{
+    uint32_t flush_us = cycles / CYCLES_PER_US;
+    hist_add(&stats.flush, flush_us);
+
+    stats_frame_t* frame = &stats.ring[stats.ring_head % STATS_RING_SIZE];
+    frame->seq = stats.frames_presented;
+    frame->flush_us = flush_us;
+    frame->lateness_us = last_lateness_us;
+    frame->i2c_bytes = i2c_bytes;
+
+    stats.ring_head ++;
+    stats.frames_presented ++;
+}
+
+/**
+ * Record an I2C transaction with a chip.
+ */
+void stats_i2c(is32_addr_t addr, uint32_t bytes, bool nack)
+{
+    counter_add(&stats.i2c_bytes[addr / 5], bytes);
+    if (nack) {
+        counter_add(&stats.i2c_nacks[addr / 5], 1);
+    }
+}
+
+/**
+ * Clear all statistics.
+ */
+void stats_reset()
+{
+    memset(&stats, 0, sizeof(stats_t));
+}
+
+/**
+ * Find the upper bound (in us) of the bucket containing the given percentile.
+ */
+static uint32_t hist_percentile(const stats_hist_t* hist, uint32_t percent)
+{
+    uint32_t total = 0;
+    for (uint32_t bucket = 0; bucket < STATS_HIST_BUCKETS; bucket ++) {
+        total += hist->buckets[bucket];
+    }
+
+    uint32_t target = (total * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (uint32_t bucket = 0; bucket < STATS_HIST_BUCKETS; bucket ++) {
+        seen += hist->buckets[bucket];
+        if (seen >= target && seen > 0) {
+            return bucket ? (1 << bucket) - 1 : 0;
+        }
+    }
+
+    return 0;
+}
+
+static void hist_print(const char* name, const stats_hist_t* hist)
+{
+    printf(
+        "%-9s p50 <%6uus  p99 <%6uus  max %6uus\n",
+        name, hist_percentile(hist, 50), hist_percentile(hist, 99), hist->max_us
+    );
+}
+
+/**
+ * Print the statistics to the console.
+ */
+void stats_print()
+{
+    uint32_t offered = stats.frames_pushed + stats.frames_dropped;
+
+    printf(
+        "frames:   pushed %u, dropped %u (%u.%u%%), presented %u\n",
+        stats.frames_pushed, stats.frames_dropped,
+        offered ? (stats.frames_dropped * 100) / offered : 0,
+        offered ? ((stats.frames_dropped * 1000) / offered) % 10 : 0,
+        stats.frames_presented
+    );
+    printf("queue:    max depth %u, unchanged frames skipped %u\n", stats.queue_max, stats.frames_unchanged);
+    printf("idle:     entered %u, with chips shut down %u\n", stats.idle_entries, stats.idle_shutdowns);
+
+    hist_print("render", &stats.render);
+    hist_print("flush", &stats.flush);
+    hist_print("lateness", &stats.lateness);
+    hist_print("resume", &stats.resume);
+    hist_print("present", &stats.present);
+
+    for (uint32_t chip = 0; chip < IS32_CHIPS_PER_BUS; chip ++) {
+        if (stats.i2c_bytes[chip] == 0 && stats.i2c_nacks[chip] == 0) {
+            continue;
+        }
+        printf("chip 0x%02x: i2c bytes %u, nacks %u\n", 0x50 | (chip * 5), stats.i2c_bytes[chip], stats.i2c_nacks[chip]);
+    }
+
+    // Most recent frames, newest last
+    uint32_t head = stats.ring_head;
+    uint32_t count = head < 8 ? head : 8;
+    if (count) {
+        printf("recent:   seq  flush_us  late_us  bytes\n");
+    }
+    for (uint32_t idx = head - count; idx != head; idx ++) {
+        const stats_frame_t* frame = &stats.ring[idx % STATS_RING_SIZE];
+        printf("     %8u  %8u  %7d  %5u\n", frame->seq, frame->flush_us, frame->lateness_us, frame->i2c_bytes);
+    }
+}
@@ -0,0 +1,238 @@
+#include <string.h>
+#include "stream.h"
+
+/**
+ * UDP frame streaming: packet validation, reordering and decoding.
+ *
+ * Packets are received straight into a jitter buffer slot and decoded from there directly into the
+ * caller's display (normally the frame buffer), so a frame is never copied between the two.
+ * This module has no network or RTOS dependencies - see task_stream for the socket side.
+ */
+
+static uint16_t packet_seq(const uint8_t* data)
+{
+    return data[4] | (data[5] << 8);
+}
+
+static uint16_t packet_length(const uint8_t* data)
+{
+    return data[6] | (data[7] << 8);
+}
+
+static uint32_t packet_epoch(const uint8_t* data)
+{
+    return data[8] | (data[9] << 8) | (data[10] << 16) | ((uint32_t)data[11] << 24);
+}
+
+/**
+ * Find the buffered packet that is earliest in sequence, or NULL if there are none.
+ */
+static stream_slot_t* stream_oldest(stream_t* stream)
+{
+    stream_slot_t* oldest = NULL;
+    for (int idx = 0; idx < STREAM_JITTER_SLOTS; idx ++) {
+        stream_slot_t* slot = &stream->slots[idx];
+        if (slot->used && (oldest == NULL || (int16_t)(slot->seq - oldest->seq) < 0)) {
+            oldest = slot;
+        }
+    }
+    return oldest;
+}
+
+/**
+ * Find the buffered packet with the given sequence number, or NULL.
+ */
+static stream_slot_t* stream_find(stream_t* stream, uint16_t seq)
+{
+    for (int idx = 0; idx < STREAM_JITTER_SLOTS; idx ++) {
+        if (stream->slots[idx].used && stream->slots[idx].seq == seq) {
+            return &stream->slots[idx];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Check the runs in a delta payload are all within the display.
+ */
+static bool delta_valid(const uint8_t* payload, uint16_t length)
+{
+    uint16_t pos = 0;
+    while (pos < length) {
+        if (pos + 2 > length) {
+            return false;
+        }
+        uint16_t index = payload[pos];
+        uint16_t count = payload[pos + 1];
+        pos += 2 + count;
+        if (index + count > DISPLAY_PIXELS || pos > length) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Apply the runs in a (validated) delta payload to a display.
+ */
+static void delta_apply(const uint8_t* payload, uint16_t length, display_t* display)
+{
+    uint16_t pos = 0;
+    while (pos < length) {
+        uint16_t index = payload[pos];
+        uint16_t count = payload[pos + 1];
+        const uint8_t* pwm = &payload[pos + 2];
+        pos += 2 + count;
+
+        for (; count; count --, index ++, pwm ++) {
+            led_t* led = &(*display)[index / DISPLAY_HEIGHT][index % DISPLAY_HEIGHT];
+            led->pwm = *pwm;
+            led->on = *pwm != 0;
+        }
+    }
+}
+
+/**
+ * Initialise a stream.
+ */
+void stream_init(stream_t* stream)
+{
+    memset(stream, 0, sizeof(stream_t));
+    stream->receiving = &stream->slots[0];
+}
+
+/**
+ * Get the buffer the next packet should be received into (STREAM_RECV_BUFFER bytes).
+ * If the jitter buffer is full the earliest packet is discarded to make room.
+ */
+uint8_t* stream_rx_buffer(stream_t* stream)
+{
+    for (int idx = 0; idx < STREAM_JITTER_SLOTS; idx ++) {
+        if (!stream->slots[idx].used) {
+            stream->receiving = &stream->slots[idx];
+            return stream->receiving->data;
+        }
+    }
+
+    stream->receiving = stream_oldest(stream);
+    stream->receiving->used = false;
+    stream->lost ++;
+    return stream->receiving->data;
+}
+
+/**
+ * Accept a packet of `length` bytes received into the buffer from stream_rx_buffer().
+ */
+void stream_rx_commit(stream_t* stream, size_t length)
+{
+    stream_slot_t* slot = stream->receiving;
+    const uint8_t* data = slot->data;
+
+    // Validate the header
+    if (
+        length < STREAM_HEADER_SIZE || length > STREAM_MAX_PACKET ||
+        data[0] != STREAM_MAGIC_0 || data[1] != STREAM_MAGIC_1 || data[2] != STREAM_VERSION ||
+        (data[3] != STREAM_FULL && data[3] != STREAM_DELTA) ||
+        STREAM_HEADER_SIZE + packet_length(data) != length ||
+        (data[3] == STREAM_FULL && packet_length(data) != DISPLAY_PIXELS)
+    ) {
+        stream->invalid ++;
+        return;
+    }
+
+    uint16_t seq = packet_seq(data);
+    uint32_t epoch = packet_epoch(data);
+
+    // A new epoch means the sender has restarted: forget everything and start again from here
+    if (stream->started && epoch != stream->epoch) {
+        for (int idx = 0; idx < STREAM_JITTER_SLOTS; idx ++) {
+            stream->slots[idx].used = false;
+        }
+        stream->synced = false;
+        stream->started = false;
+        stream->restarts ++;
+    }
+
+    if (!stream->started) {
+        stream->started = true;
+        stream->epoch = epoch;
+        stream->next_seq = seq;
+    }
+
+    // Too late (already skipped past) or a duplicate
+    if ((int16_t)(seq - stream->next_seq) < 0 || stream_find(stream, seq) != NULL) {
+        stream->late ++;
+        return;
+    }
+
+    slot->seq = seq;
+    slot->used = true;
+    stream->received ++;
+}
+
+/**
+ * Is there a packet ready to be passed to stream_pop()?
+ * That's either the next packet in sequence, or any packet once the jitter buffer has filled up
+ * waiting for a packet that's presumably been lost.
+ */
+bool stream_ready(stream_t* stream)
+{
+    if (stream_find(stream, stream->next_seq) != NULL) {
+        return true;
+    }
+
+    for (int idx = 0; idx < STREAM_JITTER_SLOTS; idx ++) {
+        if (!stream->slots[idx].used) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Decode the next packet into a display.
+ * Returns true if the display was changed, or false if the packet couldn't be applied (or there wasn't one).
+ */
+bool stream_pop(stream_t* stream, display_t* display)
+{
+    stream_slot_t* slot = stream_find(stream, stream->next_seq);
+
+    // Skip over any packets that never arrived
+    if (slot == NULL) {
+        if ((slot = stream_oldest(stream)) == NULL) {
+            return false;
+        }
+        stream->lost += (uint16_t)(slot->seq - stream->next_seq);
+        stream->synced = false;
+    }
+
+    stream->next_seq = slot->seq + 1;
+    slot->used = false;
+
+    const uint8_t* payload = &slot->data[STREAM_HEADER_SIZE];
+    uint16_t length = packet_length(slot->data);
+
+    if (slot->data[3] == STREAM_FULL) {
+        display_load_pwm(display, payload);
+        stream->synced = true;
+        stream->decoded ++;
+        return true;
+    }
+
+    // Deltas need the frame before them to have been applied
+    if (!stream->synced) {
+        stream->unsynced ++;
+        return false;
+    }
+
+    if (!delta_valid(payload, length)) {
+        stream->invalid ++;
+        stream->synced = false;
+        return false;
+    }
+
+    delta_apply(payload, length, display);
+    stream->decoded ++;
+    return true;
+}
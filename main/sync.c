@@ -0,0 +1,259 @@
+#include <string.h>
+#include "sync.h"
+
+/**
+ * Multi-node sync: packet encoding and decoding, and the node's estimate of the leader's clock.
+ *
+ * Like the stream decoder, this module has no network or RTOS dependencies - see task_sync for the socket
+ * side, and host/sync_leader and host/sync_node for running a leader and several nodes over loopback.
+ */
+
+static void put_u32(uint8_t* data, uint32_t value)
+{
+    for (int idx = 0; idx < 4; idx ++) {
+        data[idx] = value >> (8 * idx);
+    }
+}
+
+static void put_i64(uint8_t* data, int64_t value)
+{
+    put_u32(data, (uint64_t)value);
+    put_u32(data + 4, (uint64_t)value >> 32);
+}
+
+static uint32_t get_u32(const uint8_t* data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static int64_t get_i64(const uint8_t* data)
+{
+    return (int64_t)(get_u32(data) | ((uint64_t)get_u32(data + 4) << 32));
+}
+
+static void put_header(uint8_t* data, sync_packet_type_t type)
+{
+    data[0] = SYNC_MAGIC_0;
+    data[1] = SYNC_MAGIC_1;
+    data[2] = SYNC_VERSION;
+    data[3] = type;
+}
+
+/**
+ * Bound on how far out an exchange's offset is at `now_us`: half its round trip, plus the most the clocks
+ * can have drifted apart since.
+ */
+static int64_t sample_error(const sync_sample_t* sample, int64_t now_us)
+{
+    return sample->rtt_us / 2 + ((now_us - sample->at_us) * SYNC_MAX_DRIFT_PPM) / 1000000;
+}
+
+/**
+ * Check a packet's header and length, returning its type or SYNC_INVALID.
+ */
+sync_packet_type_t sync_packet_type(const uint8_t* data, size_t length)
+{
+    static const size_t sizes[] = {
+        [SYNC_FRAME] = SYNC_FRAME_SIZE,
+        [SYNC_REQUEST] = SYNC_REQUEST_SIZE,
+        [SYNC_RESPONSE] = SYNC_RESPONSE_SIZE,
+        [SYNC_REPORT] = SYNC_REPORT_SIZE
+    };
+
+    if (
+        length < SYNC_HEADER_SIZE ||
+        data[0] != SYNC_MAGIC_0 || data[1] != SYNC_MAGIC_1 || data[2] != SYNC_VERSION ||
+        data[3] < SYNC_FRAME || data[3] > SYNC_REPORT || length != sizes[data[3]]
+    ) {
+        return SYNC_INVALID;
+    }
+
+    return data[3];
+}
+
+/**
+ * Initialise a node, identified to the leader by `id`.
+ */
+void sync_init(sync_node_t* node, uint32_t id)
+{
+    memset(node, 0, sizeof(sync_node_t));
+    node->node = id;
+}
+
+/**
+ * Whether the node knows the leader's clock well enough to show frames.
+ */
+bool sync_synced(const sync_node_t* node)
+{
+    return node->sample_count >= SYNC_MIN_SAMPLES;
+}
+
+/**
+ * Build a time-sync request, sent at `now_us`. Returns its length.
+ */
+size_t sync_request(sync_node_t* node, int64_t now_us, uint8_t* packet)
+{
+    node->request_t1 = now_us;
+
+    put_header(packet, SYNC_REQUEST);
+    put_u32(&packet[4], node->node);
+    put_i64(&packet[8], now_us);
+    return SYNC_REQUEST_SIZE;
+}
+
+/**
+ * Take a (validated) response received at `now_us` into the clock estimate.
+ * Returns false if it's not for this node or isn't the response to the outstanding request.
+ */
+bool sync_response(sync_node_t* node, const uint8_t* packet, int64_t now_us)
+{
+    int64_t t1 = get_i64(&packet[8]);
+    int64_t t2 = get_i64(&packet[16]);
+    int64_t t3 = get_i64(&packet[24]);
+
+    if (get_u32(&packet[4]) != node->node || t1 != node->request_t1 || t1 == 0) {
+        return false;
+    }
+    node->request_t1 = 0;
+
+    // Round trip, less the time the leader held the request
+    int64_t rtt = (now_us - t1) - (t3 - t2);
+    if (rtt < 0) {
+        rtt = 0;
+    }
+
+    sync_sample_t* sample = &node->samples[node->sample_count % SYNC_WINDOW];
+    sample->offset_us = ((t2 - t1) + (t3 - now_us)) / 2;
+    sample->rtt_us = rtt;
+    sample->at_us = now_us;
+    node->sample_count ++;
+
+    // Use the exchange whose error is bounded tightest now
+    uint32_t count = node->sample_count < SYNC_WINDOW ? node->sample_count : SYNC_WINDOW;
+    const sync_sample_t* best = sample;
+    int64_t best_error = sample_error(sample, now_us);
+    for (uint32_t idx = 0; idx < count; idx ++) {
+        int64_t error = sample_error(&node->samples[idx], now_us);
+        if (error < best_error) {
+            best = &node->samples[idx];
+            best_error = error;
+        }
+    }
+
+    node->offset_us = best->offset_us;
+    node->rtt_us = best->rtt_us;
+    return true;
+}
+
+/**
+ * Decode a (validated) frame received at `now_us` into a display, and set `present_us` to when it should
+ * be shown on the node's clock. The frame's sequence number is then `node->next_seq - 1`.
+ * Returns false if the frame can't be shown: it's a duplicate or out of order, it's already too late, or
+ * the node isn't synced yet.
+ */
+bool sync_frame(sync_node_t* node, const uint8_t* packet, int64_t now_us, display_t* display, int64_t* present_us)
+{
+    uint32_t seq = get_u32(&packet[4]);
+    uint32_t epoch = get_u32(&packet[8]);
+
+    // A new epoch means the leader has restarted, with a new clock and sequence: start over from here
+    if (node->started && epoch != node->epoch) {
+        node->sample_count = 0;
+        node->request_t1 = 0;
+        node->restarts ++;
+        node->started = false;
+    }
+    if (!node->started) {
+        node->started = true;
+        node->epoch = epoch;
+        node->next_seq = seq;
+    }
+
+    int32_t ahead = (int32_t)(seq - node->next_seq);
+    if (ahead < 0) {
+        node->late ++;
+        return false;
+    }
+
+    node->lost += ahead;
+    node->next_seq = seq + 1;
+
+    if (!sync_synced(node)) {
+        node->unsynced ++;
+        return false;
+    }
+
+    *present_us = sync_to_local(node, get_i64(&packet[12]));
+    if (*present_us < now_us) {
+        node->late ++;
+        return false;
+    }
+
+    display_load_pwm(display, &packet[20]);
+    node->frames ++;
+    return true;
+}
+
+/**
+ * Build a report that frame `seq` was shown at `presented_us` on the leader's clock. Returns its length.
+ */
+size_t sync_report(const sync_node_t* node, uint32_t seq, int64_t presented_us, uint8_t* packet)
+{
+    put_header(packet, SYNC_REPORT);
+    put_u32(&packet[4], node->node);
+    put_u32(&packet[8], seq);
+    put_i64(&packet[12], presented_us);
+    return SYNC_REPORT_SIZE;
+}
+
+/**
+ * Convert a time on the leader's clock to the node's.
+ */
+int64_t sync_to_local(const sync_node_t* node, int64_t leader_us)
+{
+    return leader_us - node->offset_us;
+}
+
+/**
+ * Convert a time on the node's clock to the leader's.
+ */
+int64_t sync_to_leader(const sync_node_t* node, int64_t local_us)
+{
+    return local_us + node->offset_us;
+}
+
+/**
+ * Build a frame packet from DISPLAY_PIXELS PWM bytes. Returns its length.
+ */
+size_t sync_encode_frame(uint32_t epoch, uint32_t seq, int64_t present_us, const uint8_t* pwm, uint8_t* packet)
+{
+    put_header(packet, SYNC_FRAME);
+    put_u32(&packet[4], seq);
+    put_u32(&packet[8], epoch);
+    put_i64(&packet[12], present_us);
+    memcpy(&packet[20], pwm, DISPLAY_PIXELS);
+    return SYNC_FRAME_SIZE;
+}
+
+/**
+ * Build the response to a (validated) request received at `received_us`, to be sent at `sent_us`.
+ * Returns its length.
+ */
+size_t sync_respond(const uint8_t* request, int64_t received_us, int64_t sent_us, uint8_t* packet)
+{
+    put_header(packet, SYNC_RESPONSE);
+    memcpy(&packet[4], &request[4], 12);
+    put_i64(&packet[16], received_us);
+    put_i64(&packet[24], sent_us);
+    return SYNC_RESPONSE_SIZE;
+}
+
+/**
+ * Read a (validated) report.
+ */
+void sync_parse_report(const uint8_t* packet, uint32_t* node, uint32_t* seq, int64_t* presented_us)
+{
+    *node = get_u32(&packet[4]);
+    *seq = get_u32(&packet[8]);
+    *presented_us = get_i64(&packet[12]);
+}
@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "tasks/cli/include/task_cli.h"
+#include "tasks/main/include/task_main.h"
+#include "tasks/display/include/task_display.h"
+#include "tasks/stream/include/task_stream.h"
+#include "tasks/config/include/task_config.h"
+#include "tasks/log/include/task_log.h"
+#include "tasks/sync/include/task_sync.h"
+#include "task_table.h"
+
+static const char* TAG = "Tasks";
+
+/**
+ * Task stacks are allocated statically, so they're accounted for at link time rather than taken from the
+ * heap. The sizes are estimates that haven't been measured (the display, CLI and main tasks were cut down
+ * from the 30000 bytes they had when created dynamically): check them against the high-water marks
+ * `tasks` reports, leaving TASK_STACK_MARGIN or more to spare.
+ * The display task has the highest priority, so a frame is never late because the CLI or a stream packet
+ * is being handled; the log and config tasks only write things out, and run when nothing else needs to.
+ */
+
+static StackType_t log_stack[4096];
+static StackType_t display_stack[6144];
+static StackType_t cli_stack[8192];
+static StackType_t main_stack[6144];
+static StackType_t stream_stack[8192];
+static StackType_t config_stack[4096];
+static StackType_t sync_stack[4096];
+
+/**
+ * Tasks, indexed by task_id_t.
+ */
+task_entry_t tasks[TASK_COUNT] = {
+    [TASK_LOG] = {
+        .name = "log_task",
+        .function = &task_log,
+        .stack = log_stack,
+        .stack_size = sizeof(log_stack),
+        .priority = 1,
+        .core = 0,
+        .start = TASK_START_EARLY,
+    },
+    [TASK_DISPLAY] = {
+        .name = "display_task",
+        .function = &task_display,
+        .stack = display_stack,
+        .stack_size = sizeof(display_stack),
+        .priority = 6,
+        .core = 1,
+        .start = TASK_START_EARLY,
+    },
+    [TASK_CLI] = {
+        .name = "cli_task",
+        .function = &task_cli,
+        .stack = cli_stack,
+        .stack_size = sizeof(cli_stack),
+        .priority = 3,
+        .core = 0,
+        .start = TASK_START_LATE,
+    },
+    [TASK_MAIN] = {
+        .name = "main_task",
+        .function = &task_main,
+        .stack = main_stack,
+        .stack_size = sizeof(main_stack),
+        .priority = 4,
+        .core = 0,
+        .start = TASK_START_LATE,
+    },
+    [TASK_STREAM] = {
+        .name = "stream_task",
+        .function = &task_stream,
+        .stack = stream_stack,
+        .stack_size = sizeof(stream_stack),
+        .priority = 5,
+        .core = 0,
+        .start = TASK_START_LATE,
+    },
+    [TASK_CONFIG] = {
+        .name = "config_task",
+        .function = &task_config,
+        .stack = config_stack,
+        .stack_size = sizeof(config_stack),
+        .priority = 1,
+        .core = 0,
+        .start = TASK_START_LATE,
+    },
+    [TASK_SYNC] = {
+        .name = "sync_task",
+        .function = &task_sync,
+        .stack = sync_stack,
+        .stack_size = sizeof(sync_stack),
+        .priority = 5,
+        .core = 0,
+        .start = TASK_START_LATE,
+    },
+};
+
+static esp_timer_handle_t sample_timer;
+
+// Smallest largest-free-block of internal RAM seen, as the allocator only tracks the least free in total
+static size_t heap_min_largest = SIZE_MAX;
+
+/**
+ * Create every task to be started at `start`.
+ */
+void task_table_start(task_start_t start)
+{
+    for (int idx = 0; idx < TASK_COUNT; idx ++) {
+        task_entry_t* task = &tasks[idx];
+        if (task->start != start) {
+            continue;
+        }
+
+        // Depth is in StackType_t, which is a byte on ESP-IDF
+        task->stack_min_free = task->stack_size;
+        task->handle = xTaskCreateStaticPinnedToCore(
+            task->function, task->name, task->stack_size / sizeof(StackType_t), NULL, task->priority,
+            task->stack, &task->tcb, task->core
+        );
+    }
+}
+
+/**
+ * Sample each task's stack high-water mark and the heap, warning about tasks close to overflowing.
+ */
+static void task_table_sample(void* arg)
+{
+    for (int idx = 0; idx < TASK_COUNT; idx ++) {
+        task_entry_t* task = &tasks[idx];
+        if (task->handle == NULL) {
+            continue;
+        }
+
+        uint32_t free = uxTaskGetStackHighWaterMark(task->handle) * sizeof(StackType_t);
+        if (free < task->stack_min_free) {
+            task->stack_min_free = free;
+        }
+
+        if (free < TASK_STACK_MARGIN && !task->warned) {
+            ESP_LOGW(TAG, "%s has only %u of %u bytes of stack left", task->name, free, task->stack_size);
+            task->warned = true;
+        }
+    }
+
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    if (largest < heap_min_largest) {
+        heap_min_largest = largest;
+    }
+}
+
+/**
+ * Start sampling stacks and the heap.
+ */
+void task_table_monitor()
+{
+    const esp_timer_create_args_t timer_args = {
+        .callback = &task_table_sample,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "task_sample"
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &sample_timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(sample_timer, TASK_SAMPLE_MS * 1000));
+    task_table_sample(NULL);
+}
+
+/**
+ * Print each task's stack usage, and the heap.
+ */
+void task_table_print()
+{
+    uint32_t total = 0;
+    task_table_sample(NULL);
+
+    printf("task          core  prio   stack  max used  least free\n");
+    for (int idx = 0; idx < TASK_COUNT; idx ++) {
+        const task_entry_t* task = &tasks[idx];
+        total += task->stack_size;
+
+        if (task->handle == NULL) {
+            printf("%-12s  %4d  %4u  %6u  (not started)\n", task->name, task->core, task->priority, task->stack_size);
+            continue;
+        }
+
+        uint32_t used = task->stack_size - task->stack_min_free;
+        printf(
+            "%-12s  %4d  %4u  %6u  %5u %2u%%  %6u%s\n", task->name, task->core, task->priority, task->stack_size,
+            used, (used * 100) / task->stack_size, task->stack_min_free,
+            task->stack_min_free < TASK_STACK_MARGIN ? "  (low)" : ""
+        );
+    }
+    printf("stacks:   %u bytes, static\n", total);
+
+    printf(
+        "heap:     internal free %u, least free %u, largest block %u (smallest seen %u)\n",
+        heap_caps_get_free_size(MALLOC_CAP_INTERNAL), heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL),
+        heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL), heap_min_largest
+    );
+    printf(
+        "          8-bit free %u, least free %u\n",
+        heap_caps_get_free_size(MALLOC_CAP_8BIT), heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT)
+    );
+}
@@ -1,8 +1,10 @@
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include "esp_console.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "esp_vfs_dev.h"
 #include "driver/uart.h"
 #include "linenoise/linenoise.h"
@@ -12,9 +14,31 @@
 #include "driver/gpio.h"
 #include "config.h"
 #include "wifi.h"
+#include "bench.h"
+#include "stats.h"
+#include "trace.h"
+#include "frame_buffer.h"
+#include "serial_proto.h"
+#include "scene.h"
+#include "zone.h"
+#include "boot.h"
+#include "power.h"
+#include "task_table.h"
 
 static const char* TAG = "CLI";
 
+// UART RX ring buffer sizes for the text console and binary mode
+#define CONSOLE_RX_BUFFER_SIZE 256
+#define BINARY_RX_BUFFER_SIZE 8192
+
+// Binary mode returns to the console after this long without a valid packet
+#define BINARY_IDLE_TIMEOUT_MS 10000
+
+// How long binary mode waits for the frame buffer before NAKing a packet
+#define BINARY_FB_TIMEOUT_MS 50
+
+static serial_parser_t serial_parser;
+
 /**
  * Update a configuration item.
  */
@@ -25,7 +49,13 @@ static int cmd_set(int argc, char** argv)
         return -1;
     }
 
-    return config_set(argv[1], argv[2]);
+    int key = config_find(argv[1]);
+    if (key < 0) {
+        ESP_LOGW(TAG, "Unknown configuration item: %s", argv[1]);
+        return -1;
+    }
+
+    return config_set(key, argv[2]);
 }
 
 /**
@@ -39,23 +69,22 @@ static int cmd_get(int argc, char** argv)
     if (argc < 2) {   
         
         // Dump all configuration values
-        for (int cfg_idx = 0; cfg_idx < config_count; cfg_idx ++) {
-            if ((value = config_get(config[cfg_idx].key)) == NULL) {
-                continue;
-            }
-            ESP_LOGI(TAG, "%s => %s", config[cfg_idx].key, value);
+        for (int key = 0; key < CONFIG_COUNT; key ++) {
+            ESP_LOGI(TAG, "%s => %s", config[key].name, config_get(key));
         }
 
         return 0;
     }
 
     // Look for a specific value
-    value = config_get(argv[1]);
-
-    if (value == NULL) {
+    int key = config_find(argv[1]);
+    if (key < 0) {
+        ESP_LOGW(TAG, "Unknown configuration item: %s", argv[1]);
         return -1;
     }
 
+    value = config_get(key);
+
     ESP_LOGI(TAG, "%s: %s", argv[1], value);
     return 0;
 }
@@ -90,11 +119,268 @@ static int cmd_gpio(int argc, char** argv)
  */
 static int cmd_reset(int argc, char** argv)
 {
+    config_flush();
     wifi_stop();
     esp_restart();
     return 0;
 }
 
+/**
+ * Run the render/flush microbenchmarks.
+ */
+static int cmd_bench(int argc, char** argv)
+{
+    const char* stage = argc > 1 ? argv[1] : NULL;
+    unsigned int iterations = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_ITERATIONS;
+
+    if (bench_run(stage, iterations, &bench_print) != 0) {
+        ESP_LOGW(TAG, "Unknown benchmark stage: %s", stage);
+        for (unsigned int idx = 0; bench_stage_name(idx) != NULL; idx ++) {
+            printf("  %s\n", bench_stage_name(idx));
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Show (or reset) the frame pipeline statistics.
+ */
+static int cmd_stats(int argc, char** argv)
+{
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        stats_reset();
+        return 0;
+    }
+
+    stats_print();
+    return 0;
+}
+
+/**
+ * Show how long each boot phase took.
+ */
+static int cmd_boot(int argc, char** argv)
+{
+    boot_print();
+    return 0;
+}
+
+/**
+ * Show each task's stack usage, and the heap.
+ */
+static int cmd_tasks(int argc, char** argv)
+{
+    task_table_print();
+    return 0;
+}
+
+/**
+ * Show the playlist, reload it from config, or queue a scene.
+ */
+static int cmd_scene(int argc, char** argv)
+{
+    if (argc < 2) {
+        scene_print();
+        return 0;
+    }
+
+    if (strcmp(argv[1], "reload") == 0) {
+        scene_reload();
+        return 0;
+    }
+
+    if (strcmp(argv[1], "show") == 0 && argc > 2) {
+        scene_entry_t entry;
+        if (scene_parse(argv[2], &entry, 1) != 1) {
+            return -1;
+        }
+        return scene_show(&entry);
+    }
+
+    ESP_LOGW(TAG, "Expected: scene [reload|show entry]");
+    return -1;
+}
+
+/**
+ * Show the zones, or give one new content.
+ */
+static int cmd_zone(int argc, char** argv)
+{
+    if (argc < 2) {
+        zone_print();
+        return 0;
+    }
+
+    if (argc == 3) {
+        return zone_set(argv[1], argv[2]);
+    }
+
+    ESP_LOGW(TAG, "Expected: zone [name entry]");
+    return -1;
+}
+
+/**
+ * Control I2C transaction capture.
+ */
+static int cmd_trace(int argc, char** argv)
+{
+    if (argc < 2) {
+        printf("capture %s\n", trace_is_enabled() ? "running" : "stopped");
+        return 0;
+    }
+
+    if (strcmp(argv[1], "start") == 0) {
+        trace_start();
+    } else if (strcmp(argv[1], "stop") == 0) {
+        trace_stop();
+    } else if (strcmp(argv[1], "clear") == 0) {
+        trace_clear();
+    } else if (strcmp(argv[1], "dump") == 0) {
+        trace_dump();
+    } else {
+        ESP_LOGW(TAG, "Unknown trace action: %s", argv[1]);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Handle a complete packet in binary mode.
+ * Returns whether it was applied successfully.
+ */
+static bool binary_handle_packet(serial_packet_type_t type)
+{
+    if (type == SERIAL_PING || type == SERIAL_EXIT) {
+        return true;
+    }
+
+    if (type != SERIAL_FRAME && type != SERIAL_REGION) {
+        return false;
+    }
+
+    // Decode straight into the frame buffer
+    display_t* frame = fb_acquire(BINARY_FB_TIMEOUT_MS / portTICK_PERIOD_MS);
+    if (frame == NULL) {
+        return false;
+    }
+
+    bool ok = serial_decode(&serial_parser, frame);
+    fb_commit(frame, ok);
+    return ok;
+}
+
+/**
+ * Answer packets on the console UART until the host sends SERIAL_EXIT or goes quiet.
+ */
+static void binary_receive()
+{
+    const uint8_t ack = SERIAL_ACK;
+    const uint8_t nak = SERIAL_NAK;
+
+    serial_parser_init(&serial_parser);
+    uint8_t chunk[128];
+    bool exit = false;
+    TickType_t last_packet = xTaskGetTickCount();
+
+    while (!exit && xTaskGetTickCount() - last_packet < BINARY_IDLE_TIMEOUT_MS / portTICK_PERIOD_MS) {
+
+        int length = uart_read_bytes(CONFIG_CONSOLE_UART_NUM, chunk, sizeof(chunk), 20 / portTICK_PERIOD_MS);
+
+        // A chunk may contain several packets
+        size_t pos = 0;
+        while (length > 0 && pos < (size_t)length) {
+            size_t consumed;
+            serial_packet_type_t type = serial_parse(&serial_parser, &chunk[pos], length - pos, &consumed);
+            pos += consumed;
+
+            if (type == SERIAL_NONE) {
+                continue;
+            }
+
+            last_packet = xTaskGetTickCount();
+            exit = type == SERIAL_EXIT;
+            uart_write_bytes(CONFIG_CONSOLE_UART_NUM, binary_handle_packet(type) ? (const char*)&ack : (const char*)&nak, 1);
+        }
+    }
+}
+
+/**
+ * Configure the console UART, clocked from REF_TICK or APB.
+ */
+static esp_err_t console_uart_configure(int baud, bool ref_tick)
+{
+    const uart_config_t uart_config = {
+        .baud_rate = baud,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .use_ref_tick = ref_tick
+    };
+    return uart_param_config(CONFIG_CONSOLE_UART_NUM, &uart_config);
+}
+
+/**
+ * Run the binary frame protocol on the console UART.
+ * Returns to the text console when the host sends SERIAL_EXIT or goes quiet.
+ */
+static void binary_mode(int baud)
+{
+    // Light sleep would lose bytes, even while the frames received leave the display unchanged
+    power_busy(true);
+
+    // Nothing else may write to the UART while the host is expecting binary responses
+    esp_log_level_set("*", ESP_LOG_NONE);
+    fflush(stdout);
+    uart_wait_tx_done(CONFIG_CONSOLE_UART_NUM, portMAX_DELAY);
+
+    // Switch to a larger RX ring buffer and the binary baud rate, clocked from APB: REF_TICK (1MHz) can't
+    // go above 1 Mbaud and is coarse below it (921600 comes out 2% fast), and light sleep is held off
+    ESP_ERROR_CHECK( uart_driver_delete(CONFIG_CONSOLE_UART_NUM) );
+    esp_err_t err = console_uart_configure(baud, false);
+    if (err == ESP_OK) {
+        ESP_ERROR_CHECK( uart_driver_install(CONFIG_CONSOLE_UART_NUM, BINARY_RX_BUFFER_SIZE, 0, 0, NULL, 0) );
+        binary_receive();
+        uart_wait_tx_done(CONFIG_CONSOLE_UART_NUM, portMAX_DELAY);
+        ESP_ERROR_CHECK( uart_driver_delete(CONFIG_CONSOLE_UART_NUM) );
+    }
+
+    // Back to the console, on REF_TICK again so its baud rate holds through light sleep
+    ESP_ERROR_CHECK( console_uart_configure(CONFIG_CONSOLE_UART_BAUDRATE, true) );
+    ESP_ERROR_CHECK( uart_driver_install(CONFIG_CONSOLE_UART_NUM, CONSOLE_RX_BUFFER_SIZE, 0, 0, NULL, 0) );
+    esp_vfs_dev_uart_use_driver(CONFIG_CONSOLE_UART_NUM);
+    esp_log_level_set("*", config_get_int(CONFIG_LOG_VERBOSITY));
+    power_busy(false);
+
+    if (err != ESP_OK) {
+        printf("Error (%s) setting %d baud\n", esp_err_to_name(err), baud);
+        return;
+    }
+
+    ESP_LOGI(
+        TAG, "left binary mode: %u packets, %u CRC errors, %u invalid",
+        serial_parser.packets, serial_parser.crc_errors, serial_parser.invalid
+    );
+}
+
+/**
+ * Switch the console UART into binary frame mode.
+ */
+static int cmd_binmode(int argc, char** argv)
+{
+    int baud = argc > 1 ? atoi(argv[1]) : config_get_int(CONFIG_SERIAL_BAUD);
+    if (baud < SERIAL_MIN_BAUD || baud > SERIAL_MAX_BAUD) {
+        printf("Baud rate must be %d-%d\n", SERIAL_MIN_BAUD, SERIAL_MAX_BAUD);
+        return 1;
+    }
+
+    printf("Entering binary mode at %d baud\n", baud);
+    binary_mode(baud);
+    return 0;
+}
+
 /**
  * Initialise the console.
  */
@@ -113,17 +399,10 @@ static void init_console()
     /* Configure UART. Note that REF_TICK is used so that the baud rate remains
      * correct while APB frequency is changing in light sleep mode.
      */
-    const uart_config_t uart_config = {
-        .baud_rate = CONFIG_CONSOLE_UART_BAUDRATE,
-        .data_bits = UART_DATA_8_BITS,
-        .parity = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
-        .use_ref_tick = true
-    };
-    ESP_ERROR_CHECK( uart_param_config(CONFIG_CONSOLE_UART_NUM, &uart_config) );
+    ESP_ERROR_CHECK( console_uart_configure(CONFIG_CONSOLE_UART_BAUDRATE, true) );
 
     /* Install UART driver for interrupt-driven reads and writes */
-    ESP_ERROR_CHECK( uart_driver_install(CONFIG_CONSOLE_UART_NUM, 256, 0, 0, NULL, 0) );
+    ESP_ERROR_CHECK( uart_driver_install(CONFIG_CONSOLE_UART_NUM, CONSOLE_RX_BUFFER_SIZE, 0, 0, NULL, 0) );
 
     /* Tell VFS to use UART driver */
     esp_vfs_dev_uart_use_driver(CONFIG_CONSOLE_UART_NUM);
@@ -204,6 +483,70 @@ void task_cli()
     };
     ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_reset_spec));
 
+    const esp_console_cmd_t cmd_bench_spec = {
+        .command = "bench",
+        .help = "Benchmark the render and flush paths: bench [stage|all] [iterations]",
+        .hint = NULL,
+        .func = &cmd_bench,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_bench_spec));
+
+    const esp_console_cmd_t cmd_stats_spec = {
+        .command = "stats",
+        .help = "Show frame pipeline statistics: stats [reset]",
+        .hint = NULL,
+        .func = &cmd_stats,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_stats_spec));
+
+    const esp_console_cmd_t cmd_boot_spec = {
+        .command = "boot",
+        .help = "Show when each boot phase was reached",
+        .hint = NULL,
+        .func = &cmd_boot,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_boot_spec));
+
+    const esp_console_cmd_t cmd_tasks_spec = {
+        .command = "tasks",
+        .help = "Show the most stack each task has used, and the heap",
+        .hint = NULL,
+        .func = &cmd_tasks,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_tasks_spec));
+
+    const esp_console_cmd_t cmd_scene_spec = {
+        .command = "scene",
+        .help = "Show the playlist, reload it from config, or queue a scene: scene [reload|show entry]",
+        .hint = NULL,
+        .func = &cmd_scene,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_scene_spec));
+
+    const esp_console_cmd_t cmd_zone_spec = {
+        .command = "zone",
+        .help = "Show the zones, or give one new content: zone [name entry]",
+        .hint = NULL,
+        .func = &cmd_zone,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_zone_spec));
+
+    const esp_console_cmd_t cmd_trace_spec = {
+        .command = "trace",
+        .help = "Capture I2C transactions: trace [start|stop|clear|dump]",
+        .hint = NULL,
+        .func = &cmd_trace,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_trace_spec));
+
+    const esp_console_cmd_t cmd_binmode_spec = {
+        .command = "binmode",
+        .help = "Switch the console to the binary frame protocol: binmode [baud]",
+        .hint = NULL,
+        .func = &cmd_binmode,
+    };
+    ESP_ERROR_CHECK(esp_console_cmd_register(&cmd_binmode_spec));
+
     // Figure out if the terminal supports escape sequences
     printf("\nTXLED Command Interface.\nType 'help' to get the list of commands.\n\n");
     int probe_status = linenoiseProbe();
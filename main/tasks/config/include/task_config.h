@@ -0,0 +1,9 @@
+#ifndef TASK_CONFIG_H
+#define TASK_CONFIG_H
+
+// Coalesce saves requested within this long of each other into a single NVS write
+#define CONFIG_SAVE_DELAY_MS 500
+
+void task_config();
+
+#endif
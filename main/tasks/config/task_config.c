@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "include/task_config.h"
+#include "config.h"
+
+// Log Tag
+static const char* TAG = "ConfigWriter";
+
+/**
+ * Config writer task: writes saved configuration to NVS in the background, so the flash erase and
+ * commit never stall the caller. Saves requested in quick succession are written once, and a write
+ * that fails is tried again CONFIG_SAVE_DELAY_MS later.
+ */
+void task_config()
+{
+    config_set_writer(xTaskGetCurrentTaskHandle());
+    ESP_LOGI(TAG, "config writer running");
+
+    // Catch saves requested before the writer was registered
+    bool failed = config_write() != 0;
+
+    while (true) {
+
+        // A failed write is still pending, so it's retried without waiting to be asked
+        if (!failed) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+
+        // Wait for requests to settle
+        while (ulTaskNotifyTake(pdTRUE, CONFIG_SAVE_DELAY_MS / portTICK_PERIOD_MS) > 0);
+
+        failed = config_write() != 0;
+    }
+}
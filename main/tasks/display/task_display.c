@@ -12,10 +12,158 @@
 #include "display.h"
 #include "buttons.h"
 #include "frame_buffer.h"
+#include "esp_timer.h"
+#include "stats.h"
+#include "boot.h"
+#include "power.h"
+#include "is32.h"
 
 // Log Tag
 static const char* TAG = "DispTask";
 
+// Display refresh period
+#define DISPLAY_PERIOD_TICKS (25 / portTICK_PERIOD_MS)
+#define DISPLAY_PERIOD_US (DISPLAY_PERIOD_TICKS * portTICK_PERIOD_MS * 1000)
+
+// Refreshes without a change before the display goes idle
+#define DISPLAY_IDLE_AFTER 8
+
+// How often to check for a GCR change while idle
+#define DISPLAY_IDLE_CHECK_TICKS (1000 / portTICK_PERIOD_MS)
+
+// Resuming from idle (from the frame being committed to it being on the panel) should take no longer than this
+#define DISPLAY_RESUME_BUDGET_US 5000
+
+// A GCR or I2C mode change waiting to be applied, or -1
+static int pending_gcr = -1;
+static int pending_i2c_mode = -1;
+
+// Wakes this task when a frame with a presentation time is due
+static TaskHandle_t display_task_handle;
+static esp_timer_handle_t present_timer;
+
+/**
+ * Pick up GCR changes, to be applied by the display task between frames.
+ */
+static void gcr_changed(config_key_t key, void* arg)
+{
+    __atomic_store_n(&pending_gcr, config_get_int(key), __ATOMIC_RELAXED);
+}
+
+/**
+ * Apply a GCR change, if there is one.
+ */
+static void apply_gcr()
+{
+    int gcr = __atomic_exchange_n(&pending_gcr, -1, __ATOMIC_RELAXED);
+    if (gcr >= 0) {
+        ESP_LOGI(TAG, "setting GCR to %d", gcr);
+        fb_lock();
+        display_set_gcr(gcr);
+        fb_unlock();
+    }
+}
+
+/**
+ * Pick up I2C mode changes, also applied between frames.
+ */
+static void i2c_mode_changed(config_key_t key, void* arg)
+{
+    __atomic_store_n(&pending_i2c_mode, config_get_int(key), __ATOMIC_RELAXED);
+}
+
+/**
+ * Switch between bit-banged and DMA writes, if asked to.
+ */
+static void apply_i2c_mode()
+{
+    int mode = __atomic_exchange_n(&pending_i2c_mode, -1, __ATOMIC_RELAXED);
+    if (mode >= 0) {
+        ESP_LOGI(TAG, "writing frames %s", mode == IS32_BUS_DMA ? "by DMA" : "bit-banged");
+        fb_lock();
+        is32_use_dma(mode == IS32_BUS_DMA);
+        fb_unlock();
+    }
+}
+
+/**
+ * Wake the display task for a frame that's due.
+ */
+static void present_due(void* arg)
+{
+    xTaskNotifyGive(display_task_handle);
+}
+
+/**
+ * Sleep until `present_us`, to within the timer's resolution rather than a tick, for a frame to be shown then.
+ */
+static void display_wait_until(int64_t present_us)
+{
+    int64_t wait_us = present_us - esp_timer_get_time();
+    if (wait_us <= 0) {
+        return;
+    }
+
+    esp_timer_start_once(present_timer, wait_us);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+/**
+ * Idle until the next frame is committed.
+ * The chips are shut down if nothing is lit, and light sleep is allowed (if enabled) while waiting.
+ * Waking is driven by the commit itself rather than a tick, so the resume latency is just the wake-up
+ * from sleep, the chips' return to run mode, and the flush.
+ */
+static void display_idle()
+{
+    bool shutdown = display_is_dark(fb_shown());
+    if (shutdown) {
+        fb_lock();
+        display_shutdown(true);
+        fb_unlock();
+    }
+
+    stats_idle(shutdown);
+    ESP_LOGD(TAG, "idle%s", shutdown ? ", chips shut down" : "");
+
+    power_idle(true);
+    int64_t committed;
+    while ((committed = fb_wait(DISPLAY_IDLE_CHECK_TICKS)) < 0) {
+        apply_gcr();
+    }
+    power_idle(false);
+
+    // A frame with a presentation time resumes at that time
+    int64_t present_us = fb_due();
+    if (present_us > committed) {
+        display_wait_until(present_us);
+        committed = present_us;
+    }
+
+    if (shutdown) {
+        fb_lock();
+        display_shutdown(false);
+        fb_unlock();
+    }
+
+    fb_write();
+
+    int64_t resume_us = esp_timer_get_time() - committed;
+    stats_resume(resume_us);
+    if (resume_us > DISPLAY_RESUME_BUDGET_US) {
+        ESP_LOGW(TAG, "resume took %lldus", resume_us);
+    }
+}
+
+/**
+ * Note when the first frame reaches the panel, and keep each one to restore after a reset.
+ */
+static void frame_flushed(const display_t* frame)
+{
+    boot_mark("first frame");
+    boot_remember(frame);
+}
+
 /**
  * Display task.
  * Syncs the display to the desired state.
@@ -29,11 +177,64 @@ void task_display()
     gpio_set_direction(PIN_LED, GPIO_MODE_OUTPUT_OD);
 
     // Start the display engine
+    // This task is the only one to initialise the display, and holds the bus while it does. It starts
+    // as soon as the frame buffer exists, so config may still be loading: subscribing first means a
+    // stored GCR that arrives after the default has been used is applied as a change.
+    config_subscribe(CONFIG_GCR, &gcr_changed, NULL);
+    config_subscribe(CONFIG_I2C_MODE, &i2c_mode_changed, NULL);
+    fb_lock();
     display_init(config_get_int(CONFIG_GCR));
+    fb_unlock();
+    i2c_mode_changed(CONFIG_I2C_MODE, NULL);
+    boot_mark("display init");
+    fb_on_flush(&frame_flushed);
+
+    display_task_handle = xTaskGetCurrentTaskHandle();
+    const esp_timer_create_args_t timer_args = {
+        .callback = &present_due,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "present"
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timer_args, &present_timer));
+
+    TickType_t last_wake = xTaskGetTickCount();
+    int64_t due = esp_timer_get_time();
+    uint32_t unchanged = 0;
 
     while(true) {
-        fb_write();
-        vTaskDelay(25 / portTICK_PERIOD_MS);
+
+        // Apply a brightness or bus change live
+        apply_gcr();
+        apply_i2c_mode();
+
+        unchanged = fb_write() ? 0 : unchanged + 1;
+
+        // Frames with a presentation time before the next refresh are flushed at that time, not the refresh's
+        int64_t present_us;
+        while ((present_us = fb_due()) > 0 && present_us < due + DISPLAY_PERIOD_US) {
+            display_wait_until(present_us);
+            unchanged = fb_write() ? 0 : unchanged + 1;
+        }
+
+        // Once the display is static, stop refreshing until something changes (an animation between steps
+        // doesn't count, as only this task would notice its next step is due, and nor do frames held for
+        // their presentation time)
+        if (
+            unchanged >= DISPLAY_IDLE_AFTER && !fb_animating() && fb_depth() == 0 &&
+            config_get_int(CONFIG_IDLE_MODE) != POWER_IDLE_OFF
+        ) {
+            display_idle();
+            unchanged = 0;
+            last_wake = xTaskGetTickCount();
+            due = esp_timer_get_time();
+            continue;
+        }
+
+        // Wake on a fixed cadence and record how late we actually woke up
+        vTaskDelayUntil(&last_wake, DISPLAY_PERIOD_TICKS);
+        due += DISPLAY_PERIOD_US;
+        stats_lateness(esp_timer_get_time() - due);
     }
 
 }
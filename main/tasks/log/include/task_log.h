@@ -0,0 +1,6 @@
+#ifndef TASK_LOG_H
+#define TASK_LOG_H
+
+void task_log();
+
+#endif
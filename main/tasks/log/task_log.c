@@ -0,0 +1,31 @@
+#include <stdio.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "include/task_log.h"
+#include "dlog.h"
+
+// Log Tag
+static const char* TAG = "Log";
+
+/**
+ * Log task: formats and writes out records from the deferred log, so the UART writes happen here at low
+ * priority rather than on the render path.
+ */
+void task_log()
+{
+    dlog_set_drain(xTaskGetCurrentTaskHandle());
+    uint32_t dropped = 0;
+
+    while (true) {
+        dlog_drain();
+
+        uint32_t now_dropped = dlog_dropped();
+        if (now_dropped != dropped) {
+            ESP_LOGW(TAG, "%u log records dropped", now_dropped - dropped);
+            dropped = now_dropped;
+        }
+
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
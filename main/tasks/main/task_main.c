@@ -4,105 +4,71 @@
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
+#include "freertos/task.h"
 #include "include/task_main.h"
-#include "driver/gpio.h"
 #include "config.h"
-#include "wifi.h"
-#include "pins.h"
 #include "display.h"
 #include "buttons.h"
-#include "transition.h"
+#include "scene.h"
+#include "zone.h"
 #include "frame_buffer.h"
+#include "anim.h"
+#include "cycles.h"
+#include "stats.h"
 
 // Log Tag
 static const char* TAG = "Main";
 
 /**
- * Main task.
+ * Play the animation from flash, forever.
+ * Returns if there's no valid animation, or it turns out to be corrupt.
  */
-void task_main(void* params)
+static void play_flash_animation()
 {
-    ESP_LOGI(TAG, "Main task started");
-
-    // Set up the heartbeat LED
-    gpio_pad_select_gpio(PIN_LED);
-    gpio_set_direction(PIN_LED, GPIO_MODE_OUTPUT_OD);
-
-    // Start the Wi-Fi if possible
-    // wifi_init();
-
-    // Start the display engine
-    display_init(config_get_int(CONFIG_GCR));
-
-    display_t display_blank;
-    display_t display_left;
-    display_t display_right;
-    display_t display_cb;
-
-    display_fill(&display_blank, 0x00, true);
-    display_fill(&display_left, 0x00, true);
-    display_fill(&display_right, 0x00, true);
-    display_rect(&display_left, 0, 0, DISPLAY_WIDTH / 2, DISPLAY_HEIGHT, 0xff, true);
-    display_rect(&display_right, DISPLAY_WIDTH / 2, 0, DISPLAY_WIDTH / 2, DISPLAY_HEIGHT, 0xff, true);
-
-    // fb_push(&display_left);
-
-    // while(true) {
-
-    //     trans_handle_t* fade_l_to_r = trans_fade(&display_left, &display_right, 64);
-    //     while(!(trans_progress(fade_l_to_r)->is_finished)) {
-    //         fb_push(fade_l_to_r->current);
-    //         vTaskDelay(30 / portTICK_PERIOD_MS);
-    //     }
-    //     trans_free(fade_l_to_r);
-
-    //     trans_handle_t* fade_r_to_l = trans_fade(&display_right, &display_left, 64);
-    //     while(!(trans_progress(fade_r_to_l)->is_finished)) {
-    //         fb_push(fade_r_to_l->current);
-    //         vTaskDelay(30 / portTICK_PERIOD_MS);
-    //     }
-    //     trans_free(fade_r_to_l);
-    // }
-
-
-    while(true) {
-
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
-        ESP_LOGI(TAG, "Checkerboard...");
-        display_checkerboard(&display_cb, false, 0xff);
-        fb_push(&display_cb);
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
-        ESP_LOGI(TAG, "Inverse checkerboard...");
-        display_checkerboard(&display_cb, true, 0xff);
-        fb_push(&display_cb);
-        vTaskDelay(1000 / portTICK_PERIOD_MS);
-
-        // Scroll text
-        const char* text = "hello ~ transition test =)";
-        trans_handle_t* scroll = trans_scroll_text(text, false, SCROLL_START_CLEAR, SCROLL_END_FULL);
-        while(!(trans_progress(scroll)->is_finished)) {
-            fb_push(scroll->current);
-            vTaskDelay(75 / portTICK_PERIOD_MS);
+    static anim_t anim;
+    if (anim_open_partition(&anim) != 0) {
+        return;
+    }
+
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t loop_cycles = 0;
+
+    while (true) {
+        uint32_t start = cycles_now();
+        if (!anim_next(&anim)) {
+            return;
         }
-
-        // Now wipe to checkerboard
-        trans_handle_t* wipe = trans_wipe(scroll->current, &display_cb, WIPE_DOWN);
-        while(!(trans_progress(wipe)->is_finished)) {
-            fb_push(wipe->current);
-            vTaskDelay(100 / portTICK_PERIOD_MS);
+        uint32_t cycles = cycles_now() - start;
+        stats_render(cycles);
+
+        // Report the decode cost once per loop of the animation
+        loop_cycles += cycles;
+        if (anim.frame_index == anim.header->frame_count) {
+            ESP_LOGI(TAG, "animation decode: %u " CYCLES_UNIT "/frame", loop_cycles / anim.frame_index);
+            loop_cycles = 0;
         }
 
-        // Fade to black
-        trans_handle_t* fade = trans_fade(wipe->current, &display_blank, 64);
-        while(!(trans_progress(fade)->is_finished)) {
-            fb_push(fade->current);
-            vTaskDelay(30 / portTICK_PERIOD_MS);
-        }
+        display_t* frame = fb_acquire(portMAX_DELAY);
+        display_load_pwm(frame, anim.frame);
+        fb_commit(frame, true);
+
+        TickType_t ticks = anim.duration_ms / portTICK_PERIOD_MS;
+        vTaskDelayUntil(&last_wake, ticks ? ticks : 1);
+    }
+}
 
-        fb_push(fade->current);
-        trans_free(scroll);
-        trans_free(wipe);
-        trans_free(fade);
+/**
+ * Main task.
+ */
+void task_main(void* params)
+{
+    ESP_LOGI(TAG, "Main task started");
 
-    }    
+    // Canned content comes from flash if there is any, otherwise show the zones if any are defined, or
+    // else play the configured playlist
+    play_flash_animation();
+    if (zone_count() > 0) {
+        zone_run();
+    }
+    scene_run();
 }
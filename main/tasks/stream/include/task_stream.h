@@ -0,0 +1,6 @@
+#ifndef TASK_STREAM_H
+#define TASK_STREAM_H
+
+void task_stream();
+
+#endif
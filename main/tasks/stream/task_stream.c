@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "include/task_stream.h"
+#include "events.h"
+#include "config.h"
+#include "frame_buffer.h"
+#include "stream.h"
+
+// Log Tag
+static const char* TAG = "Stream";
+
+// How long to wait for the frame buffer before leaving a packet for the next attempt
+#define STREAM_FB_TIMEOUT_TICKS (10 / portTICK_PERIOD_MS)
+
+// Log stream counters every this many decoded frames
+#define STREAM_LOG_INTERVAL 1000
+
+static stream_t stream;
+
+/**
+ * Open the UDP socket frames are received on.
+ */
+static int stream_open(int port)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "unable to create socket: errno %d", errno);
+        return -1;
+    }
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY)
+    };
+
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "unable to bind to port %d: errno %d", port, errno);
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+/**
+ * Stream task.
+ *
+ * Receives frames over UDP and decodes them straight into the frame buffer.
+ */
+void task_stream()
+{
+    stream_init(&stream);
+
+    // Nothing to do until we're on the network
+    xEventGroupWaitBits(sys_event_group, SYS_EVENT_BIT_WIFI_CONNECTED, pdFALSE, pdTRUE, portMAX_DELAY);
+
+    int port = config_get_int(CONFIG_STREAM_PORT);
+    int sock = stream_open(port);
+    if (sock < 0) {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    ESP_LOGI(TAG, "listening for frames on UDP port %d", port);
+
+    while (true) {
+
+        // Receive directly into a jitter buffer slot
+        int length = recv(sock, stream_rx_buffer(&stream), STREAM_RECV_BUFFER, 0);
+        if (length < 0) {
+            ESP_LOGW(TAG, "recv failed: errno %d", errno);
+            continue;
+        }
+
+        stream_rx_commit(&stream, length);
+
+        // Decode whatever is ready directly into the frame buffer
+        while (stream_ready(&stream)) {
+            display_t* frame = fb_acquire(STREAM_FB_TIMEOUT_TICKS);
+            if (frame == NULL) {
+                break;
+            }
+
+            bool changed = stream_pop(&stream, frame);
+            fb_commit(frame, changed);
+
+            if (changed && stream.decoded % STREAM_LOG_INTERVAL == 0) {
+                ESP_LOGI(
+                    TAG, "decoded %u, late %u, lost %u, unsynced %u, invalid %u, sender restarts %u",
+                    stream.decoded, stream.late, stream.lost, stream.unsynced, stream.invalid, stream.restarts
+                );
+            }
+        }
+    }
+}
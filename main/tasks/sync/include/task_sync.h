@@ -0,0 +1,6 @@
+#ifndef TASK_SYNC_H
+#define TASK_SYNC_H
+
+void task_sync();
+
+#endif
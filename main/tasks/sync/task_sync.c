@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
+#include "include/task_sync.h"
+#include "events.h"
+#include "config.h"
+#include "frame_buffer.h"
+#include "sync.h"
+
+// Log Tag
+static const char* TAG = "Sync";
+
+// How long to wait for the frame buffer before dropping a frame (it would likely be late anyway)
+#define SYNC_FB_TIMEOUT_TICKS (10 / portTICK_PERIOD_MS)
+
+// Log sync state every this many frames
+#define SYNC_LOG_INTERVAL 1000
+
+static sync_node_t node;
+
+/**
+ * Open the UDP socket frames are received on, and join the multicast group they're sent to.
+ */
+static int sync_open(const char* group, int port)
+{
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (sock < 0) {
+        ESP_LOGE(TAG, "unable to create socket: errno %d", errno);
+        return -1;
+    }
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY)
+    };
+
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "unable to bind to port %d: errno %d", port, errno);
+        close(sock);
+        return -1;
+    }
+
+    struct ip_mreq membership = {
+        .imr_multiaddr.s_addr = inet_addr(group),
+        .imr_interface.s_addr = htonl(INADDR_ANY)
+    };
+
+    if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) < 0) {
+        ESP_LOGE(TAG, "unable to join %s: errno %d", group, errno);
+        close(sock);
+        return -1;
+    }
+
+    // Wake up at least as often as time-sync requests are due
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = SYNC_REQUEST_MS * 1000 };
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    return sock;
+}
+
+/**
+ * Decode a frame into the frame buffer, to be shown at its presentation time.
+ */
+static void sync_show(const uint8_t* packet, int64_t now_us)
+{
+    display_t* frame = fb_acquire(SYNC_FB_TIMEOUT_TICKS);
+    if (frame == NULL) {
+        node.late ++;
+        return;
+    }
+
+    int64_t present_us;
+    if (!sync_frame(&node, packet, now_us, frame, &present_us)) {
+        fb_commit(frame, false);
+        return;
+    }
+
+    fb_commit_at(frame, present_us);
+
+    if (node.frames % SYNC_LOG_INTERVAL == 0) {
+        ESP_LOGI(
+            TAG, "offset %lldus (rtt %uus), frames %u, late %u, lost %u, unsynced %u, invalid %u, leader restarts %u",
+            node.offset_us, node.rtt_us, node.frames, node.late, node.lost, node.unsynced, node.invalid, node.restarts
+        );
+    }
+}
+
+/**
+ * Sync task.
+ *
+ * Joins the `sync_group` multicast group, keeps this node's estimate of the leader's clock up to date, and
+ * queues each frame to be shown at the leader's time for it. Does nothing if `sync_group` isn't set.
+ */
+void task_sync()
+{
+    // The group is read once, at startup
+    const char* group = config_get(CONFIG_SYNC_GROUP);
+    if (group[0] == '\0') {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    // Nodes are told apart by the low bytes of their MAC address
+    uint8_t mac[6];
+    esp_efuse_mac_get_default(mac);
+    sync_init(&node, (mac[2] << 24) | (mac[3] << 16) | (mac[4] << 8) | mac[5]);
+
+    // Nothing to do until we're on the network
+    xEventGroupWaitBits(sys_event_group, SYS_EVENT_BIT_WIFI_CONNECTED, pdFALSE, pdTRUE, portMAX_DELAY);
+
+    // Modem sleep holds multicast frames until the next beacon and makes round trips vary, so keep the radio on
+    esp_wifi_set_ps(WIFI_PS_NONE);
+
+    int port = config_get_int(CONFIG_SYNC_PORT);
+    int sock = sync_open(group, port);
+    if (sock < 0) {
+        vTaskDelete(NULL);
+        return;
+    }
+
+    ESP_LOGI(TAG, "node %08x listening for frames on %s port %d", node.node, group, port);
+
+    struct sockaddr_in leader;
+    bool have_leader = false;
+    int64_t next_request = 0;
+    uint8_t packet[SYNC_RECV_BUFFER];
+
+    while (true) {
+        struct sockaddr_in from;
+        socklen_t from_length = sizeof(from);
+        int length = recvfrom(sock, packet, sizeof(packet), 0, (struct sockaddr*)&from, &from_length);
+        int64_t now = esp_timer_get_time();
+
+        if (length >= 0) {
+            switch (sync_packet_type(packet, length)) {
+                case SYNC_FRAME:
+                    // Time-sync requests go to wherever frames come from
+                    leader = from;
+                    have_leader = true;
+                    sync_show(packet, now);
+                    break;
+                case SYNC_RESPONSE:
+                    sync_response(&node, packet, now);
+                    break;
+                default:
+                    node.invalid ++;
+                    break;
+            }
+        }
+
+        if (have_leader && now >= next_request) {
+            size_t request_length = sync_request(&node, esp_timer_get_time(), packet);
+            sendto(sock, packet, request_length, 0, (struct sockaddr*)&leader, sizeof(leader));
+            next_request = now + SYNC_REQUEST_MS * 1000;
+        }
+    }
+}
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "trace.h"
+
+/**
+ * I2C transaction capture.
+ *
+ * Each IS32 transaction is appended to a fixed RAM ring as a trace_record_t followed by its payload.
+ * When the ring is full the oldest records are discarded, so it always holds the most recent traffic.
+ * `trace_dump()` prints the ring as base64 between TRACE BEGIN/END lines, which
+ * tools/i2c_trace.py decodes, replays into a model of the panel and exports as VCD.
+ */
+
+static uint8_t ring[TRACE_BUFFER_SIZE];
+
+// Free-running byte positions of the next write and the oldest record
+static uint32_t head = 0;
+static uint32_t tail = 0;
+
+static uint32_t records = 0;
+static uint32_t dropped = 0;
+static volatile bool enabled = false;
+
+static portMUX_TYPE trace_mut = portMUX_INITIALIZER_UNLOCKED;
+
+static const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ * Copy data into the ring at a free-running position, wrapping as necessary.
+ */
+static void ring_write(uint32_t pos, const void* data, uint32_t length)
+{
+    uint32_t offset = pos % TRACE_BUFFER_SIZE;
+    uint32_t first = length < TRACE_BUFFER_SIZE - offset ? length : TRACE_BUFFER_SIZE - offset;
+    memcpy(&ring[offset], data, first);
+    memcpy(ring, (const uint8_t*)data + first, length - first);
+}
+
+/**
+ * Copy data out of the ring at a free-running position, wrapping as necessary.
+ */
+static void ring_read(uint32_t pos, void* data, uint32_t length)
+{
+    uint32_t offset = pos % TRACE_BUFFER_SIZE;
+    uint32_t first = length < TRACE_BUFFER_SIZE - offset ? length : TRACE_BUFFER_SIZE - offset;
+    memcpy(data, &ring[offset], first);
+    memcpy((uint8_t*)data + first, ring, length - first);
+}
+
+/**
+ * Start capturing transactions.
+ */
+void trace_start()
+{
+    enabled = true;
+}
+
+/**
+ * Stop capturing transactions, keeping whatever has been captured.
+ */
+void trace_stop()
+{
+    enabled = false;
+}
+
+/**
+ * Discard everything captured so far.
+ */
+void trace_clear()
+{
+    portENTER_CRITICAL(&trace_mut);
+    head = tail = 0;
+    records = dropped = 0;
+    portEXIT_CRITICAL(&trace_mut);
+}
+
+/**
+ * Returns whether or not capture is running.
+ */
+bool trace_is_enabled()
+{
+    return enabled;
+}
+
+/**
+ * Capture a transaction, if capture is running.
+ * `nack_at` is the index of the first NACKed byte, or -1 if every byte was acknowledged.
+ */
+void trace_record(is32_addr_t addr, uint8_t reg, const uint8_t* data, uint16_t length, int nack_at)
+{
+    if (!enabled) {
+        return;
+    }
+
+    uint32_t size = sizeof(trace_record_t) + length;
+    if (size > TRACE_BUFFER_SIZE) {
+        return;
+    }
+
+    trace_record_t record = {
+        .timestamp_us = (uint32_t)esp_timer_get_time(),
+        .addr = 0x50 | addr,
+        .reg = reg,
+        .flags = nack_at >= 0 ? TRACE_FLAG_NACK : 0,
+        .length = length,
+        .nack_at = nack_at >= 0 ? nack_at : 0
+    };
+
+    portENTER_CRITICAL(&trace_mut);
+
+    // Discard the oldest records until this one fits
+    while (head + size - tail > TRACE_BUFFER_SIZE) {
+        trace_record_t oldest;
+        ring_read(tail, &oldest, sizeof(trace_record_t));
+        tail += sizeof(trace_record_t) + oldest.length;
+        records --;
+        dropped ++;
+    }
+
+    ring_write(head, &record, sizeof(trace_record_t));
+    ring_write(head + sizeof(trace_record_t), data, length);
+    head += size;
+    records ++;
+
+    portEXIT_CRITICAL(&trace_mut);
+}
+
+/**
+ * Print up to 3 bytes as 4 base64 characters.
+ */
+static void base64_put(const uint8_t* in, uint32_t length)
+{
+    uint32_t v = (in[0] << 16) | (length > 1 ? in[1] << 8 : 0) | (length > 2 ? in[2] : 0);
+    putchar(base64_chars[(v >> 18) & 0x3F]);
+    putchar(base64_chars[(v >> 12) & 0x3F]);
+    putchar(length > 1 ? base64_chars[(v >> 6) & 0x3F] : '=');
+    putchar(length > 2 ? base64_chars[v & 0x3F] : '=');
+}
+
+/**
+ * Print the captured records to the console.
+ * Capture is paused while dumping so the ring doesn't move underneath us.
+ */
+void trace_dump()
+{
+    bool was_enabled = enabled;
+    enabled = false;
+
+    portENTER_CRITICAL(&trace_mut);
+    uint32_t pos = tail;
+    uint32_t end = head;
+    portEXIT_CRITICAL(&trace_mut);
+
+    printf("TRACE BEGIN version=%d records=%u dropped=%u bytes=%u\n", TRACE_VERSION, records, dropped, end - pos);
+
+    // 57 bytes of input per 76-character line
+    uint8_t chunk[57];
+    while (pos != end) {
+        uint32_t length = end - pos < sizeof(chunk) ? end - pos : sizeof(chunk);
+        ring_read(pos, chunk, length);
+        for (uint32_t idx = 0; idx < length; idx += 3) {
+            base64_put(&chunk[idx], length - idx);
+        }
+        putchar('\n');
+        pos += length;
+    }
+
+    printf("TRACE END\n");
+    enabled = was_enabled;
+}
@@ -1,7 +1,10 @@
 #include <stdio.h>
 #include <string.h>
 #include "transition.h"
+#include "cycles.h"
+#include "stats.h"
 #include "esp_log.h"
+#include "dlog.h"
 
 /**
  * Performs transitions between display states.
@@ -14,30 +17,179 @@
  *     // Update the display here to be wipe->current
  * }
  * trans_free(wipe);
+ *
+ * or, to have it take a fixed time however often the loop runs:
+ *
+ * trans_start(wipe, esp_timer_get_time(), 500);
+ * while(!wipe->is_finished) {
+ *     if (trans_progress_to(wipe, esp_timer_get_time()) > 0) {
+ *         // Update the display here to be wipe->current
+ *     }
+ *     // Sleep until trans_next_due_us(wipe)
+ * }
+ * trans_free(wipe);
  */
 
 static const char* TAG = "Trans";
 // #define LOG_LOCAL_LEVEL ESP_LOG_DEBUG
 
+// Pixels are numbered x * DISPLAY_HEIGHT + y (as for display_load_pwm), and must fit in the dissolve's LFSR
+_Static_assert(DISPLAY_PIXELS < 256, "dissolve LFSR is 8 bits");
+
+// Taps for an 8-bit maximal-length Galois LFSR (x^8 + x^6 + x^5 + x^4 + 1), which visits 1-255 once each
+#define TRANS_DISSOLVE_TAPS 0xB8
+
+// Upper bound on the number of iris rings (the distance to a corner is at most the sum of the half sides)
+#define TRANS_IRIS_MAX_RINGS ((DISPLAY_WIDTH + DISPLAY_HEIGHT) / 2 + 1)
+
+// Pixels sorted by their ring (distance from the centre), and where each ring starts; built on first use
+static uint8_t iris_order[DISPLAY_PIXELS];
+static uint8_t iris_ring_start[TRANS_IRIS_MAX_RINGS + 1];
+static unsigned int iris_rings = 0;
+
 /**
- * Wipe from one display state to another vertically.
+ * Allocate a handle, starting from a copy of `from` (if given).
  */
-trans_handle_t* trans_wipe(const display_t* from, const display_t* to, trans_wipe_direction_t direction)
+static trans_handle_t* trans_create(trans_type_t type, const display_t* from, const display_t* to, unsigned int steps)
 {
-    // Allocate space for the handle
     trans_handle_t* handle = malloc(sizeof(trans_handle_t));
     handle->current = malloc(sizeof(display_t));
     handle->to = to;
     handle->is_finished = false;
+    handle->steps = steps;
+    handle->step = 0;
+    handle->start_us = 0;
+    handle->duration_us = 0;
+    handle->type = type;
+
+    if (from != NULL) {
+        memcpy(handle->current, from, sizeof(display_t));
+    }
 
-    // Copy the starting state
-    display_copy(from, handle->current, 0, 0, 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    return handle;
+}
+
+/**
+ * Set up a wipe, push or slide, which all take a step per row or column in the direction of travel.
+ */
+static trans_handle_t* trans_directional(trans_type_t type, const display_t* from, const display_t* to, trans_wipe_direction_t direction)
+{
+    unsigned int steps = direction & TRANS_WIPE_DIRECTION_VERTICAL_MASK ? DISPLAY_HEIGHT : DISPLAY_WIDTH;
+    trans_handle_t* handle = trans_create(type, from, to, steps);
 
-    // Allocate space for the progress data
-    handle->type = TRANS_WIPE;
     handle->trans_data.wipe = malloc(sizeof(trans_wipe_data_t));
     handle->trans_data.wipe->direction = direction;
     handle->trans_data.wipe->step = 0;
+    handle->trans_data.wipe->x = 0;
+    handle->trans_data.wipe->y = 0;
+    handle->trans_data.wipe->width = DISPLAY_WIDTH;
+    handle->trans_data.wipe->height = DISPLAY_HEIGHT;
+    return handle;
+}
+
+/**
+ * Wipe from one display state to another.
+ */
+trans_handle_t* trans_wipe(const display_t* from, const display_t* to, trans_wipe_direction_t direction)
+{
+    return trans_directional(TRANS_WIPE, from, to, direction);
+}
+
+/**
+ * Push one display state out with another.
+ */
+trans_handle_t* trans_push(const display_t* from, const display_t* to, trans_wipe_direction_t direction)
+{
+    return trans_directional(TRANS_PUSH, from, to, direction);
+}
+
+/**
+ * Slide one display state in over another.
+ */
+trans_handle_t* trans_slide(const display_t* from, const display_t* to, trans_wipe_direction_t direction)
+{
+    return trans_directional(TRANS_SLIDE, from, to, direction);
+}
+
+/**
+ * Integer square root, rounded down.
+ */
+static unsigned int isqrt(unsigned int value)
+{
+    unsigned int root = 0;
+    while ((root + 1) * (root + 1) <= value) {
+        root ++;
+    }
+    return root;
+}
+
+/**
+ * Sort the pixels into rings around the centre of the display (a counting sort, done once).
+ */
+static void iris_init()
+{
+    uint8_t ring_of[DISPLAY_PIXELS];
+    unsigned int counts[TRANS_IRIS_MAX_RINGS] = {0};
+
+    // Distances are measured between pixel centres, in doubled coordinates to keep them integral
+    for (int x = 0; x < DISPLAY_WIDTH; x ++) {
+        for (int y = 0; y < DISPLAY_HEIGHT; y ++) {
+            int dx = 2 * x + 1 - DISPLAY_WIDTH;
+            int dy = 2 * y + 1 - DISPLAY_HEIGHT;
+            unsigned int ring = isqrt(dx * dx + dy * dy) / 2;
+
+            ring_of[x * DISPLAY_HEIGHT + y] = ring;
+            counts[ring] ++;
+            if (ring + 1 > iris_rings) {
+                iris_rings = ring + 1;
+            }
+        }
+    }
+
+    unsigned int start = 0;
+    for (unsigned int ring = 0; ring < iris_rings; ring ++) {
+        iris_ring_start[ring] = start;
+        start += counts[ring];
+        counts[ring] = iris_ring_start[ring];
+    }
+    iris_ring_start[iris_rings] = start;
+
+    for (unsigned int pixel = 0; pixel < DISPLAY_PIXELS; pixel ++) {
+        iris_order[counts[ring_of[pixel]] ++] = pixel;
+    }
+}
+
+/**
+ * Reveal one display state over another in rings.
+ */
+trans_handle_t* trans_iris(const display_t* from, const display_t* to, bool closing)
+{
+    if (iris_rings == 0) {
+        iris_init();
+    }
+
+    trans_handle_t* handle = trans_create(TRANS_IRIS, from, to, iris_rings);
+    handle->trans_data.iris = malloc(sizeof(trans_iris_data_t));
+    handle->trans_data.iris->closing = closing;
+    handle->trans_data.iris->step = 0;
+    return handle;
+}
+
+/**
+ * Dissolve from one display state to another.
+ */
+trans_handle_t* trans_dissolve(const display_t* from, const display_t* to, unsigned int steps)
+{
+    if (steps == 0) {
+        steps = 1;
+    }
+
+    trans_handle_t* handle = trans_create(TRANS_DISSOLVE, from, to, steps);
+    handle->trans_data.dissolve = malloc(sizeof(trans_dissolve_data_t));
+    handle->trans_data.dissolve->lfsr = 1;
+    handle->trans_data.dissolve->per_step = (DISPLAY_PIXELS + steps - 1) / steps;
+    handle->trans_data.dissolve->remaining = DISPLAY_PIXELS;
+    handle->trans_data.dissolve->step = 0;
     return handle;
 }
 
@@ -46,17 +198,9 @@ trans_handle_t* trans_wipe(const display_t* from, const display_t* to, trans_wip
  */
 trans_handle_t* trans_fade(const display_t* from, const display_t* to, unsigned int steps)
 {
-    // Allocate space for the handle
-    trans_handle_t* handle = malloc(sizeof(trans_handle_t));
-    handle->current = malloc(sizeof(display_t));
-    handle->to = to;
-    handle->is_finished = false;
-
-    // Copy the starting state
-    display_copy(from, handle->current, 0, 0, 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    trans_handle_t* handle = trans_create(TRANS_FADE, from, to, steps);
 
     // Allocate space for the progress data
-    handle->type = TRANS_FADE;
     handle->trans_data.fade = malloc(sizeof(trans_fade_data_t));
     handle->trans_data.fade->step = 0;
     handle->trans_data.fade->steps = steps;
@@ -67,7 +211,7 @@ trans_handle_t* trans_fade(const display_t* from, const display_t* to, unsigned
             // Calculate a floating point intensity change per step of the transition for this pixel
             int intensity_diff = (int)(*from)[x][y].pwm - (int)(*to)[x][y].pwm;
             handle->trans_data.fade->step_changes[x][y] = (float)intensity_diff / (float)steps;
-            ESP_LOGD(TAG, "%d/%d intens. total_diff = %d, chg = %02f", x, y, intensity_diff, handle->trans_data.fade->step_changes[x][y]);
+            DLOGV(TAG, "%d/%d intens. total_diff = %d", x, y, intensity_diff);
         }
     }
 
@@ -75,70 +219,211 @@ trans_handle_t* trans_fade(const display_t* from, const display_t* to, unsigned
 }
 
 /**
- * Scroll text horizontally on the display.
+ * Set up a scroll across a canvas, which the handle takes ownership of.
  */
-trans_handle_t* trans_scroll_text(const char* text, bool invert, trans_scroll_text_start_behaviour_t start, trans_scroll_text_end_behaviour_t end)
+static trans_handle_t* trans_scroll(const canvas_t* canvas, bool invert, trans_scroll_text_start_behaviour_t start, trans_scroll_text_end_behaviour_t end)
 {
-    // Allocate space for the handle
-    trans_handle_t* handle = malloc(sizeof(trans_handle_t));
-    handle->current = malloc(sizeof(display_t));
-    handle->is_finished = false;
+    // It finishes on the first step where the canvas's right edge is left of the end position
+    int travel = canvas->width + (start == SCROLL_START_CLEAR ? DISPLAY_WIDTH : 0) - (end == SCROLL_END_CLEAR ? 0 : DISPLAY_WIDTH);
+    trans_handle_t* handle = trans_create(TRANS_SCROLL_TEXT, NULL, NULL, travel >= 0 ? travel + 2 : 1);
 
     // Allocate space for the progress data
-    handle->type = TRANS_SCROLL_TEXT;
     handle->trans_data.scroll_text = malloc(sizeof(trans_scroll_text_data_t));
     handle->trans_data.scroll_text->step = 0;
     handle->trans_data.scroll_text->invert = invert;
-    handle->trans_data.scroll_text->text = text;
+    handle->trans_data.scroll_text->canvas = *canvas;
     handle->trans_data.scroll_text->start_behaviour = start;
     handle->trans_data.scroll_text->end_behaviour = end;
     return handle;
 }
 
 /**
- * Progress the wipe transition.
+ * Scroll text horizontally on the display.
+ * The text is drawn once, onto a canvas as wide as it is; text wider than a canvas can be is cut short.
  */
-trans_handle_t* trans_wipe_progress(trans_handle_t* handle)
+trans_handle_t* trans_scroll_text(const char* text, bool invert, trans_scroll_text_start_behaviour_t start, trans_scroll_text_end_behaviour_t end)
 {
-    // Vertical or horizontal wiping?
-    if (handle->trans_data.wipe->direction & TRANS_WIPE_DIRECTION_VERTICAL_MASK) {
+    canvas_t canvas;
+    size_t length = strlen(text);
+    if (length > CANVAS_MAX_WIDTH / DISPLAY_CHAR_WIDTH) {
+        ESP_LOGW(TAG, "%u characters is too long to scroll - scrolling the first %d", (unsigned int)length, CANVAS_MAX_WIDTH / DISPLAY_CHAR_WIDTH);
+        length = CANVAS_MAX_WIDTH / DISPLAY_CHAR_WIDTH;
+    }
 
-        ESP_LOGI(TAG, "trans_wipe: step %d", handle->trans_data.wipe->step);
+    // canvas_text() stops at the canvas's edge, so the rest of the text is left off
+    int text_pixel_len = length * DISPLAY_CHAR_WIDTH;
+    if (text_pixel_len == 0) {
+        // Nothing to draw: scroll an empty canvas, which has no columns to allocate
+        memset(&canvas, 0, sizeof(canvas_t));
+    } else if (canvas_init(&canvas, text_pixel_len, CANVAS_INTERNAL)) {
+        canvas_text(&canvas, 0, text);
+    } else {
+        ESP_LOGW(TAG, "no memory for a %d column scroll - scrolling blank", text_pixel_len);
+        canvas.width = text_pixel_len;
+    }
 
-        // Copy everything currently in view up or down one line
-        display_copy(
-            handle->current, // From
-            handle->current, // To
-            0, 0, // From 0, 0
-            0, handle->trans_data.wipe->direction == WIPE_UP ? -1 : 1, // Move everything one line up or down
-            DISPLAY_WIDTH, DISPLAY_HEIGHT // Move the whole viewport
-        );
+    return trans_scroll(&canvas, invert, start, end);
+}
 
-        // Replace the bottom or line with the relevant line from the new view
-        display_copy(
-            handle->to, // From
-            handle->current, // To
+/**
+ * Scroll a column asset horizontally on the display, reading it from flash as it goes.
+ */
+trans_handle_t* trans_scroll_asset(const asset_t* asset, bool invert, trans_scroll_text_start_behaviour_t start, trans_scroll_text_end_behaviour_t end)
+{
+    canvas_t canvas;
+    if (!canvas_init_asset(&canvas, asset)) {
+        ESP_LOGW(TAG, "%s isn't a column asset - scrolling blank", asset->name);
+        canvas.width = asset->width;
+    }
+
+    return trans_scroll(&canvas, invert, start, end);
+}
+
+/**
+ * Confine a transition to a rectangle (clamped to the display) before it starts.
+ * Only wipes, pushes and slides depend on the area they cover; the others only touch pixels that differ.
+ */
+void trans_clip(trans_handle_t* handle, int x, int y, int width, int height)
+{
+    if (handle == NULL || (handle->type != TRANS_WIPE && handle->type != TRANS_PUSH && handle->type != TRANS_SLIDE)) {
+        return;
+    }
+
+    // Whatever lies off the top or left edge is cut from the size too
+    if (x < 0) {
+        width += x;
+        x = 0;
+    }
+    if (y < 0) {
+        height += y;
+        y = 0;
+    }
+
+    width = x + width > DISPLAY_WIDTH ? DISPLAY_WIDTH - x : width;
+    height = y + height > DISPLAY_HEIGHT ? DISPLAY_HEIGHT - y : height;
+    if (width < 1 || height < 1) {
+        return;
+    }
+
+    trans_wipe_data_t* wipe = handle->trans_data.wipe;
+    wipe->x = x;
+    wipe->y = y;
+    wipe->width = width;
+    wipe->height = height;
+    handle->steps = wipe->direction & TRANS_WIPE_DIRECTION_VERTICAL_MASK ? height : width;
+}
+
+/**
+ * Map a position along a direction of travel (0 being the edge the new state enters from) and a position
+ * across it to display coordinates.
+ */
+static inline void trans_axis_xy(const trans_wipe_data_t* wipe, int along, int across, int* x, int* y)
+{
+    switch (wipe->direction) {
+        case WIPE_UP: *x = wipe->x + across; *y = wipe->y + wipe->height - 1 - along; break;
+        case WIPE_DOWN: *x = wipe->x + across; *y = wipe->y + along; break;
+        case WIPE_LEFT: *x = wipe->x + wipe->width - 1 - along; *y = wipe->y + across; break;
+        default: *x = wipe->x + along; *y = wipe->y + across; break;
+    }
+}
 
-            // From either lines working from the top or bottom of the transition target
-            0, handle->trans_data.wipe->direction == WIPE_UP ? (handle->trans_data.wipe->step) : (DISPLAY_HEIGHT - handle->trans_data.wipe->step),
-            
-            // To either the bottom or top line
-            0, handle->trans_data.wipe->direction == WIPE_UP ? (DISPLAY_HEIGHT - 1) : 0,
-            
-            // Always one line, the full width of the display
-            DISPLAY_WIDTH, 1
-        );
+/**
+ * Progress a wipe, push or slide.
+ * After `shown` steps, the first `shown` rows/columns from the entering edge show the new state: where it
+ * will end up for a wipe, or its far end for a push or slide (which then moves along). A push also moves
+ * the old state along ahead of it; a slide leaves it where it is. A wipe changes one line per step and a
+ * slide the lines covered so far; a push moves everything, so every pixel changes.
+ */
+trans_handle_t* trans_directional_progress(trans_handle_t* handle)
+{
+    trans_wipe_data_t* wipe = handle->trans_data.wipe;
+    int length = handle->steps;
+    int breadth = wipe->direction & TRANS_WIPE_DIRECTION_VERTICAL_MASK ? wipe->width : wipe->height;
+    int shown = ++ wipe->step;
+
+    // A push moves the old state one line further on, walking back from the far edge so each line is read
+    // before it's overwritten
+    if (handle->type == TRANS_PUSH) {
+        for (int along = length - 1; along >= shown; along --) {
+            for (int across = 0; across < breadth; across ++) {
+                int x, y, src_x, src_y;
+                trans_axis_xy(wipe, along, across, &x, &y);
+                trans_axis_xy(wipe, along - 1, across, &src_x, &src_y);
+                (*handle->current)[x][y] = (*handle->current)[src_x][src_y];
+            }
+        }
+    }
+
+    // The new state: only the newly revealed line for a wipe, or every line shown so far (as they move) otherwise
+    for (int along = handle->type == TRANS_WIPE ? shown - 1 : 0; along < shown; along ++) {
+        int src_along = handle->type == TRANS_WIPE ? along : along + length - shown;
 
-        // Done once we've wiped the entire height of the display
-        if ((handle->trans_data.wipe->step)++ == DISPLAY_HEIGHT) {
-            handle->is_finished = true;
-            ESP_LOGI(
-                TAG, "trans_wipe (@ %p) has finished (%d steps)",
-                handle, handle->trans_data.fade->step
-            );
+        for (int across = 0; across < breadth; across ++) {
+            int x, y, src_x, src_y;
+            trans_axis_xy(wipe, along, across, &x, &y);
+            trans_axis_xy(wipe, src_along, across, &src_x, &src_y);
+            (*handle->current)[x][y] = (*handle->to)[src_x][src_y];
         }
     }
 
+    if (wipe->step == handle->steps) {
+        handle->is_finished = true;
+        DLOGI(TAG, "transition (@ %08x) has finished (%d steps)", (uint32_t)(uintptr_t)handle, handle->steps);
+    }
+
+    return handle;
+}
+
+/**
+ * Progress the iris transition, revealing the next ring.
+ */
+trans_handle_t* trans_iris_progress(trans_handle_t* handle)
+{
+    trans_iris_data_t* iris = handle->trans_data.iris;
+    unsigned int ring = iris->closing ? iris_rings - 1 - iris->step : iris->step;
+
+    for (unsigned int idx = iris_ring_start[ring]; idx < iris_ring_start[ring + 1]; idx ++) {
+        unsigned int x = iris_order[idx] / DISPLAY_HEIGHT;
+        unsigned int y = iris_order[idx] % DISPLAY_HEIGHT;
+        (*handle->current)[x][y] = (*handle->to)[x][y];
+    }
+
+    if (++ iris->step == handle->steps) {
+        handle->is_finished = true;
+        DLOGI(TAG, "trans_iris (@ %08x) has finished (%d steps)", (uint32_t)(uintptr_t)handle, handle->steps);
+    }
+
+    return handle;
+}
+
+/**
+ * Progress the dissolve transition, revealing the next few pixels in LFSR order.
+ * LFSR states beyond the last pixel are skipped, so each pixel is revealed exactly once.
+ */
+trans_handle_t* trans_dissolve_progress(trans_handle_t* handle)
+{
+    trans_dissolve_data_t* dissolve = handle->trans_data.dissolve;
+    unsigned int count = dissolve->per_step < dissolve->remaining ? dissolve->per_step : dissolve->remaining;
+
+    while (count > 0) {
+        unsigned int pixel = dissolve->lfsr - 1;
+        dissolve->lfsr = (dissolve->lfsr >> 1) ^ (dissolve->lfsr & 1 ? TRANS_DISSOLVE_TAPS : 0);
+
+        if (pixel < DISPLAY_PIXELS) {
+            unsigned int x = pixel / DISPLAY_HEIGHT;
+            unsigned int y = pixel % DISPLAY_HEIGHT;
+            (*handle->current)[x][y] = (*handle->to)[x][y];
+            dissolve->remaining --;
+            count --;
+        }
+    }
+
+    // With the pixels rounded up to a whole number per step, the last step or two may reveal nothing
+    if (++ dissolve->step == handle->steps) {
+        handle->is_finished = true;
+        DLOGI(TAG, "trans_dissolve (@ %08x) has finished (%d steps)", (uint32_t)(uintptr_t)handle, handle->steps);
+    }
+
     return handle;
 }
 
@@ -147,14 +432,14 @@ trans_handle_t* trans_wipe_progress(trans_handle_t* handle)
  */
 trans_handle_t* trans_fade_progress(trans_handle_t* handle)
 {
-    ESP_LOGD(TAG, "progressing fade trans @ %p step %d", handle, handle->trans_data.fade->step);
+    DLOGV(TAG, "progressing fade trans @ %08x step %d", (uint32_t)(uintptr_t)handle, handle->trans_data.fade->step);
 
     // Apply the step change to each pixel
     for (uint x = 0; x < DISPLAY_WIDTH; x ++) {
         for (uint y = 0; y < DISPLAY_HEIGHT; y ++) {
             unsigned int new_pwm = (unsigned int)(((float)((*handle->current)[x][y].pwm) - handle->trans_data.fade->step_changes[x][y] ) + 0.5);
             (*handle->current)[x][y].pwm = new_pwm;
-            ESP_LOGD(TAG, "update px %d/%d chg %02f now %d", x, y, handle->trans_data.fade->step_changes[x][y], new_pwm);
+            DLOGV(TAG, "update px %d/%d now %d", x, y, new_pwm);
         }
     }
 
@@ -165,10 +450,7 @@ trans_handle_t* trans_fade_progress(trans_handle_t* handle)
         // Finalise the transition, making up for any rounding errors
         display_copy(handle->to, handle->current, 0, 0, 0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
 
-        ESP_LOGI(
-            TAG, "trans_fade (@ %p) has finished (%d steps)",
-            handle, handle->trans_data.fade->steps
-        );
+        DLOGI(TAG, "trans_fade (@ %08x) has finished (%d steps)", (uint32_t)(uintptr_t)handle, handle->trans_data.fade->steps);
     }
 
     return handle;
@@ -179,31 +461,25 @@ trans_handle_t* trans_fade_progress(trans_handle_t* handle)
  */
 trans_handle_t* trans_scroll_text_progress(trans_handle_t* handle)
 {
-    // Start with a blank canvas each time, and draw the text at the appropriate offset based on step
-    int text_pixel_len = strlen(handle->trans_data.scroll_text->text) * DISPLAY_CHAR_WIDTH;
-
-    // Clear the display & write text
-    display_fill(handle->current, handle->trans_data.scroll_text->invert ? 0xff : 0x00, true);
-    display_text(
-        handle->current,
-        (handle->trans_data.scroll_text->start_behaviour == SCROLL_START_CLEAR ? DISPLAY_WIDTH : 0) - handle->trans_data.scroll_text->step,
-        handle->trans_data.scroll_text->invert ? 0x00 : 0xff,
-        handle->trans_data.scroll_text->text
-    );
-
-    // Finished when the rightmost pixel of text is < 0
-    if (
-        (int)text_pixel_len - handle->trans_data.scroll_text->step + (handle->trans_data.scroll_text->start_behaviour == SCROLL_START_CLEAR ? DISPLAY_WIDTH : 0) <
-        (handle->trans_data.scroll_text->end_behaviour == SCROLL_END_CLEAR ? 0 : DISPLAY_WIDTH)
-    ) {
+    trans_scroll_text_data_t* scroll = handle->trans_data.scroll_text;
+    int start_offset = scroll->start_behaviour == SCROLL_START_CLEAR ? DISPLAY_WIDTH : 0;
+
+    // Move the viewport along the canvas and show what's under it
+    mono_t window;
+    scroll->canvas.viewport = (int)scroll->step - start_offset;
+    canvas_view(&scroll->canvas, &window);
+    if (scroll->invert) {
+        mono_invert(&window);
+    }
+    mono_render(&window, handle->current, DISPLAY_WIDTH, DISPLAY_HEIGHT, 0xff);
+
+    // Finished when the rightmost column of the canvas is left of the end position
+    if (scroll->canvas.width - (int)scroll->step + start_offset < (scroll->end_behaviour == SCROLL_END_CLEAR ? 0 : DISPLAY_WIDTH)) {
         handle->is_finished = true;
-        ESP_LOGI(
-            TAG, "trans_scroll_text (@ %p) has finished (%d steps)",
-            handle, handle->trans_data.scroll_text->step
-        );
+        DLOGI(TAG, "trans_scroll_text (@ %08x) has finished (%d steps)", (uint32_t)(uintptr_t)handle, scroll->step);
     }
-    
-    handle->trans_data.scroll_text->step ++;
+
+    scroll->step ++;
     return handle;
 }
 
@@ -217,17 +493,70 @@ trans_handle_t* trans_progress(trans_handle_t* handle)
         return handle;
     }
 
+    uint32_t start = cycles_now();
+
     // Call the appropriate transition progress method
     switch (handle->type) {
-        case TRANS_WIPE: return trans_wipe_progress(handle);
-        case TRANS_FADE: return trans_fade_progress(handle);
-        case TRANS_SCROLL_TEXT: return trans_scroll_text_progress(handle);
+        case TRANS_WIPE:
+        case TRANS_PUSH:
+        case TRANS_SLIDE: trans_directional_progress(handle); break;
+        case TRANS_FADE: trans_fade_progress(handle); break;
+        case TRANS_SCROLL_TEXT: trans_scroll_text_progress(handle); break;
+        case TRANS_IRIS: trans_iris_progress(handle); break;
+        case TRANS_DISSOLVE: trans_dissolve_progress(handle); break;
         default: ESP_LOGW(TAG, "unknown transition type: %d", handle->type);
     }
 
+    handle->step ++;
+    stats_render(cycles_now() - start);
     return handle;
 }
 
+/**
+ * Time a transition: it starts at `start_us` and lasts `duration_ms`, however often it's progressed.
+ * Step n (counting from 0) is due n/steps of the way through.
+ */
+void trans_start(trans_handle_t* handle, int64_t start_us, uint32_t duration_ms)
+{
+    handle->start_us = start_us;
+    handle->duration_us = (int64_t)duration_ms * 1000;
+}
+
+/**
+ * Progress a timed transition to `now_us`.
+ * Missed steps are all taken, rather than skipped, so every line of a wipe is still revealed and a fade
+ * still reaches its destination exactly. An untimed transition is taken straight to the end.
+ */
+unsigned int trans_progress_to(trans_handle_t* handle, int64_t now_us)
+{
+    unsigned int due = handle->steps;
+    if (handle->duration_us > 0) {
+        int64_t elapsed = now_us - handle->start_us;
+        due = elapsed < 0 ? 0 : elapsed * handle->steps / handle->duration_us + 1;
+    }
+
+    unsigned int taken = 0;
+    while (!handle->is_finished && handle->step < due) {
+        trans_progress(handle);
+        taken ++;
+    }
+
+    return taken;
+}
+
+/**
+ * When the next step of a timed transition is due (or, once finished, when it ends).
+ */
+int64_t trans_next_due_us(const trans_handle_t* handle)
+{
+    if (handle->is_finished || handle->step >= handle->steps) {
+        return handle->start_us + handle->duration_us;
+    }
+
+    // Rounded up, so the step is due by the time returned
+    return handle->start_us + ((int64_t)handle->step * handle->duration_us + handle->steps - 1) / handle->steps;
+}
+
 /**
  * Free the transition handle.
  */
@@ -244,9 +573,16 @@ void trans_free(trans_handle_t* handle)
     
     // Free the transition data
     switch (handle->type) {
-        case TRANS_WIPE: free(handle->trans_data.wipe); break;
+        case TRANS_WIPE:
+        case TRANS_PUSH:
+        case TRANS_SLIDE: free(handle->trans_data.wipe); break;
         case TRANS_FADE: free(handle->trans_data.fade); break;
-        case TRANS_SCROLL_TEXT: free(handle->trans_data.scroll_text); break;
+        case TRANS_SCROLL_TEXT:
+            canvas_free(&handle->trans_data.scroll_text->canvas);
+            free(handle->trans_data.scroll_text);
+            break;
+        case TRANS_IRIS: free(handle->trans_data.iris); break;
+        case TRANS_DISSOLVE: free(handle->trans_data.dissolve); break;
         default: ESP_LOGW(TAG, "not freeing unknown transition type: %d", handle->type);
     }
 
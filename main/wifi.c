@@ -17,6 +17,7 @@
 #include "events.h"
 #include "wifi.h"
 #include "config.h"
+#include "boot.h"
 
 static const char *TAG = "Wi-Fi";
 
@@ -44,6 +45,7 @@ static esp_err_t event_handler(void *ctx, system_event_t *event)
             // Set the relevant bit in our event group that's being waited on by the main call
             ESP_LOGI(TAG, "station got IP address: %s", ip4addr_ntoa(&event->event_info.got_ip.ip_info.ip));
             xEventGroupSetBits(sys_event_group, SYS_EVENT_BIT_WIFI_CONNECTED);
+            boot_mark("wifi connected");
             break;
 
         // Station disconnected
@@ -63,9 +65,6 @@ static esp_err_t event_handler(void *ctx, system_event_t *event)
  */
 void wifi_init()
 {
-    // Create the event group for Wi-Fi state change events
-    sys_event_group = xEventGroupCreate();
-    
     // Initialse TCP/IP stack
     ESP_LOGI(TAG, "initialising TCP/IP stack...");
     tcpip_adapter_init();
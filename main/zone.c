@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "zone.h"
+#include "scene.h"
+#include "config.h"
+#include "transition.h"
+#include "frame_buffer.h"
+
+/**
+ * Composes the display from zones, each moving between its own content with its own transition.
+ *
+ * Each zone renders and transitions at the top left of its own full-size buffers (with wipes, pushes and
+ * slides clipped to the zone's size), and only the zone's rectangle is copied into the frame. Transitions
+ * are timed, so zones moving at different rates share one loop, which sleeps until a step is next due.
+ * Frames are only committed when a zone has changed, and the frame buffer flushes just the registers that
+ * differ from what's on the panel, so a zone changing costs bus time in proportion to its size.
+ */
+
+static const char* TAG = "Zone";
+
+typedef struct {
+    char name[ZONE_NAME_LENGTH + 1];
+    int x;
+    int y;
+    int width;
+    int height;
+
+    // What the zone shows, and the content it's moving to, both at the top left
+    display_t shown;
+    display_t target;
+
+    // The transition to the target (NULL once there)
+    trans_handle_t* transition;
+
+    // Whether `shown` has changed since it was last copied into a frame
+    bool dirty;
+} zone_t;
+
+// A queued update
+typedef struct {
+    uint8_t zone;
+    scene_entry_t entry;
+} zone_update_t;
+
+static zone_t zones[ZONE_MAX];
+static int zones_defined = 0;
+static QueueHandle_t zone_queue;
+
+/**
+ * Parse a single zone definition.
+ */
+static int parse_zone(const char* item, zone_t* zone)
+{
+    char name[ZONE_NAME_LENGTH + 1];
+    int x, y, width, height;
+
+    if (sscanf(item, "%12[^:]:%d,%d,%d,%d", name, &x, &y, &width, &height) != 5) {
+        return -1;
+    }
+
+    if (x < 0 || y < 0 || width < 1 || height < 1 || x + width > DISPLAY_WIDTH || y + height > DISPLAY_HEIGHT) {
+        return -1;
+    }
+
+    memset(zone, 0, sizeof(zone_t));
+    strcpy(zone->name, name);
+    zone->x = x;
+    zone->y = y;
+    zone->width = width;
+    zone->height = height;
+    display_fill(&zone->shown, 0x00, true);
+    zone->dirty = true;
+    return 0;
+}
+
+/**
+ * Read the zone definitions from config.
+ */
+int zone_init()
+{
+    zone_queue = xQueueCreate(ZONE_QUEUE_LENGTH, sizeof(zone_update_t));
+
+    char* copy = strdup(config_get(CONFIG_ZONES));
+    char* rest = copy;
+    char* item;
+    int count = 0;
+
+    while ((item = strsep(&rest, ";")) != NULL) {
+
+        // Allow empty entries, e.g. a trailing separator
+        if (*item == '\0') {
+            continue;
+        }
+
+        if (count == ZONE_MAX) {
+            ESP_LOGW(TAG, "more than %d zones defined", ZONE_MAX);
+            count = -1;
+            break;
+        }
+
+        if (parse_zone(item, &zones[count]) != 0) {
+            ESP_LOGW(TAG, "invalid zone %d", count + 1);
+            count = -1;
+            break;
+        }
+
+        count ++;
+    }
+
+    free(copy);
+    zones_defined = count > 0 ? count : 0;
+    if (zones_defined > 0) {
+        ESP_LOGI(TAG, "%d zones defined", zones_defined);
+    }
+
+    return count;
+}
+
+/**
+ * Number of zones defined.
+ */
+int zone_count()
+{
+    return zones_defined;
+}
+
+/**
+ * Queue new content for a zone, given as a playlist entry.
+ */
+int zone_set(const char* name, const char* spec)
+{
+    zone_update_t update;
+
+    for (update.zone = 0; update.zone < zones_defined; update.zone ++) {
+        if (strcmp(zones[update.zone].name, name) == 0) {
+            break;
+        }
+    }
+
+    if (update.zone == zones_defined) {
+        ESP_LOGW(TAG, "no zone named %s", name);
+        return -1;
+    }
+
+    if (scene_parse(spec, &update.entry, 1) != 1) {
+        return -1;
+    }
+
+    if (update.entry.type == SCENE_PROCEDURAL) {
+        ESP_LOGW(TAG, "procedural effects can't be shown in a zone");
+        return -1;
+    }
+
+    if (xQueueSendToBack(zone_queue, &update, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "zone queue full, dropping update");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Start moving a zone to new content, from wherever it's got to.
+ */
+static void zone_start(zone_t* zone, const scene_entry_t* entry, int64_t now_us)
+{
+    if (zone->transition != NULL) {
+        memcpy(&zone->shown, zone->transition->current, sizeof(display_t));
+        trans_free(zone->transition);
+    }
+
+    scene_render(entry, &zone->target, zone->width, zone->height);
+    zone->transition = scene_transition(entry->transition, &zone->shown, &zone->target);
+
+    if (zone->transition == NULL) {
+        memcpy(&zone->shown, &zone->target, sizeof(display_t));
+        zone->dirty = true;
+        return;
+    }
+
+    trans_clip(zone->transition, 0, 0, zone->width, zone->height);
+    trans_start(zone->transition, now_us, scene_transition_ms(entry, zone->transition));
+}
+
+/**
+ * Advance a zone's transition to `now_us`, and copy it into the frame if it has changed.
+ * Returns whether the frame changed.
+ */
+static bool zone_step(zone_t* zone, display_t* frame, int64_t now_us)
+{
+    const display_t* source = &zone->shown;
+
+    if (zone->transition != NULL) {
+        if (trans_progress_to(zone->transition, now_us) == 0) {
+            return false;
+        }
+
+        source = zone->transition->current;
+
+        if (zone->transition->is_finished) {
+            memcpy(&zone->shown, &zone->target, sizeof(display_t));
+            trans_free(zone->transition);
+            zone->transition = NULL;
+            source = &zone->shown;
+        }
+    } else if (!zone->dirty) {
+        return false;
+    }
+
+    for (int x = 0; x < zone->width; x ++) {
+        memcpy(&(*frame)[zone->x + x][zone->y], (*source)[x], zone->height * sizeof(led_t));
+    }
+
+    zone->dirty = false;
+    return true;
+}
+
+/**
+ * Show the zones, applying updates as they arrive.
+ */
+void zone_run()
+{
+    bool first = true;
+
+    while (true) {
+
+        // Sleep until an update arrives or a transition's next step is due
+        int64_t now_us = esp_timer_get_time();
+        TickType_t wait = first ? 0 : portMAX_DELAY;
+        for (int idx = 0; idx < zones_defined; idx ++) {
+            if (zones[idx].transition != NULL) {
+                int64_t due_us = trans_next_due_us(zones[idx].transition) - now_us;
+                TickType_t ticks = due_us > 0 ? (due_us + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000) : 0;
+                wait = ticks < wait ? ticks : wait;
+            }
+        }
+
+        // Apply every update waiting, so simultaneous ones go out in the same frame
+        zone_update_t update;
+        if (xQueueReceive(zone_queue, &update, wait) == pdTRUE) {
+            now_us = esp_timer_get_time();
+            do {
+                zone_start(&zones[update.zone], &update.entry, now_us);
+            } while (xQueueReceive(zone_queue, &update, 0) == pdTRUE);
+        }
+
+        now_us = esp_timer_get_time();
+        display_t* frame = fb_acquire(portMAX_DELAY);
+
+        // Clear whatever was shown before, such as the boot splash
+        if (first) {
+            display_fill(frame, 0x00, true);
+        }
+
+        bool changed = first;
+        for (int idx = 0; idx < zones_defined; idx ++) {
+            changed |= zone_step(&zones[idx], frame, now_us);
+        }
+
+        fb_commit(frame, changed);
+        first = false;
+    }
+}
+
+/**
+ * Print the zones.
+ */
+void zone_print()
+{
+    for (int idx = 0; idx < zones_defined; idx ++) {
+        const zone_t* zone = &zones[idx];
+        printf(
+            "%-12s %2d,%d  %2dx%d%s\n", zone->name, zone->x, zone->y, zone->width, zone->height,
+            zone->transition != NULL ? "  (transitioning)" : ""
+        );
+    }
+}
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+Encode an animation for the panel's "anim" flash partition.
+
+    anim_encode.py intro.gif -o intro.txa
+    anim_encode.py frame*.png --duration 80 -o frames.txa
+    anim_encode.py --demo -o demo.txa --bench
+
+Inputs can be GIFs (every frame, with its own duration), PNGs (needs Pillow) or PGM/PBM files.
+Images are scaled to the 24x6 display and converted to greyscale PWM values. Each frame is stored
+as whichever of an RLE keyframe or an RLE XOR delta against the previous frame is smaller; the
+format is described in main/include/anim.h.
+
+Write the result to the device with:
+
+    esptool.py write_flash 0x110000 intro.txa
+
+--bench decodes the result with host/anim_play (make -C host anim_play) to report decode time per frame.
+"""
+
+import argparse
+import math
+import os
+import struct
+import subprocess
+import sys
+
+DISPLAY_WIDTH = 24
+DISPLAY_HEIGHT = 6
+DISPLAY_PIXELS = DISPLAY_WIDTH * DISPLAY_HEIGHT
+
+ANIM_MAGIC = b"TXA1"
+ANIM_VERSION = 1
+ANIM_KEY = 1
+ANIM_DELTA = 2
+
+HEADER = struct.Struct("<4sHHBBHI")
+FRAME = struct.Struct("<BBHH")
+
+ANIM_PARTITION_OFFSET = 0x110000
+ANIM_PARTITION_SIZE = 0xF0000
+
+
+def rle_encode(data):
+    """PackBits variant: c < 0x80 is c + 1 literals, c >= 0x80 repeats the next byte c - 0x80 + 3 times."""
+    out = bytearray()
+    literals = bytearray()
+    pos = 0
+
+    def flush():
+        if literals:
+            out.append(len(literals) - 1)
+            out.extend(literals)
+            literals.clear()
+
+    while pos < len(data):
+        run = 1
+        while pos + run < len(data) and data[pos + run] == data[pos] and run < 130:
+            run += 1
+        if run >= 3:
+            flush()
+            out.append(0x80 + run - 3)
+            out.append(data[pos])
+            pos += run
+        else:
+            literals.append(data[pos])
+            pos += 1
+            if len(literals) == 128:
+                flush()
+    flush()
+    return bytes(out)
+
+
+def pack(pixels, width, height, threshold, invert):
+    """Turn a row-major greyscale image into packed column-major PWM bytes, scaling to the display."""
+    frame = bytearray(DISPLAY_PIXELS)
+    for x in range(DISPLAY_WIDTH):
+        for y in range(DISPLAY_HEIGHT):
+            value = pixels[(y * height // DISPLAY_HEIGHT) * width + (x * width // DISPLAY_WIDTH)]
+            if invert:
+                value = 255 - value
+            if threshold is not None:
+                value = 0xFF if value >= threshold else 0
+            frame[x * DISPLAY_HEIGHT + y] = value
+    return bytes(frame)
+
+
+def read_netpbm(path):
+    """Read a PGM (P5, or plain P2) or PBM (P4, or plain P1) file as (pixels, width, height)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    fields = []
+    pos = 0
+    needed = 3 if data[:2] in (b"P1", b"P4") else 4
+    while len(fields) < needed:
+        while data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b"#":
+            pos = data.index(b"\n", pos)
+            continue
+        end = pos
+        while not data[end:end + 1].isspace():
+            end += 1
+        fields.append(data[pos:end])
+        pos = end
+    pos += 1
+    width, height = int(fields[1]), int(fields[2])
+    if fields[0] == b"P5":
+        return list(data[pos:pos + width * height]), width, height
+    if fields[0] == b"P4":
+        stride = (width + 7) // 8
+        pixels = []
+        for y in range(height):
+            row = data[pos + y * stride:pos + (y + 1) * stride]
+            pixels += [0 if row[x // 8] & (0x80 >> (x % 8)) else 255 for x in range(width)]
+        return pixels, width, height
+    if fields[0] in (b"P1", b"P2"):
+        text = b"\n".join(line.split(b"#")[0] for line in data[pos:].split(b"\n"))
+        if fields[0] == b"P1":
+            bits = [c for c in text if c in b"01"]
+            return [0 if c == ord("1") else 255 for c in bits[:width * height]], width, height
+        maximum = int(fields[3])
+        return [int(v) * 255 // maximum for v in text.split()[:width * height]], width, height
+    sys.exit("%s: not a PGM or PBM file" % path)
+
+
+def read_images(paths, duration, threshold, invert):
+    """Yield (frame, duration_ms) for every frame of every input."""
+    for path in paths:
+        if path.lower().endswith((".pgm", ".pbm")):
+            pixels, width, height = read_netpbm(path)
+            yield pack(pixels, width, height, threshold, invert), duration
+            continue
+
+        try:
+            from PIL import Image, ImageSequence
+        except ImportError:
+            sys.exit("Pillow is needed to read %s (pip install pillow)" % path)
+
+        image = Image.open(path)
+        for frame in ImageSequence.Iterator(image):
+            grey = frame.convert("L").resize((DISPLAY_WIDTH, DISPLAY_HEIGHT))
+            yield pack(list(grey.getdata()), DISPLAY_WIDTH, DISPLAY_HEIGHT, threshold, invert), frame.info.get("duration", duration)
+
+
+def demo_frames(duration):
+    """A bouncing bar over a slow pulse, for trying the pipeline without any images."""
+    for step in range(48):
+        frame = bytearray(DISPLAY_PIXELS)
+        bar = abs((step % 46) - 23)
+        for x in range(DISPLAY_WIDTH):
+            for y in range(DISPLAY_HEIGHT):
+                if x in (bar, bar - 1):
+                    frame[x * DISPLAY_HEIGHT + y] = 0xFF
+                elif y == DISPLAY_HEIGHT - 1:
+                    frame[x * DISPLAY_HEIGHT + y] = int(32 + 31 * math.sin(step / 4.0))
+        yield bytes(frame), duration
+
+
+def encode(frames):
+    """Encode frames, returning (data, keyframes, deltas)."""
+    data = bytearray()
+    previous = None
+    keys = deltas = 0
+
+    for frame, duration in frames:
+        key = rle_encode(frame)
+        kind, payload = ANIM_KEY, key
+        if previous is not None:
+            delta = rle_encode(bytes(a ^ b for a, b in zip(previous, frame)))
+            if len(delta) < len(key):
+                kind, payload = ANIM_DELTA, delta
+        if kind == ANIM_KEY:
+            keys += 1
+        else:
+            deltas += 1
+        data += FRAME.pack(kind, 0, min(int(duration), 0xFFFF), len(payload)) + payload
+        previous = frame
+
+    return bytes(data), keys, deltas
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("inputs", nargs="*")
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("--duration", type=int, default=100, help="frame duration in ms where the input has none (default 100)")
+    parser.add_argument("--threshold", type=int, help="convert to on/off at this grey level")
+    parser.add_argument("--invert", action="store_true")
+    parser.add_argument("--demo", action="store_true", help="encode a built-in demo animation")
+    parser.add_argument("--bench", action="store_true", help="time decoding with host/anim_play")
+    args = parser.parse_args()
+
+    if args.demo:
+        frames = list(demo_frames(args.duration))
+    elif args.inputs:
+        frames = list(read_images(args.inputs, args.duration, args.threshold, args.invert))
+    else:
+        parser.error("no inputs (or --demo)")
+
+    if not frames or len(frames) > 0xFFFF:
+        sys.exit("need between 1 and 65535 frames")
+
+    data, keys, deltas = encode(frames)
+    header = HEADER.pack(ANIM_MAGIC, ANIM_VERSION, len(frames), DISPLAY_WIDTH, DISPLAY_HEIGHT, 0, len(data))
+
+    with open(args.output, "wb") as f:
+        f.write(header + data)
+
+    raw = len(frames) * DISPLAY_PIXELS
+    total = len(header) + len(data)
+    print("%d frames (%d key, %d delta), %d ms total" % (len(frames), keys, deltas, sum(d for _, d in frames)))
+    print("%d bytes raw, %d bytes encoded: ratio %.2f:1, %.1f bytes/frame" % (raw, total, raw / total, len(data) / len(frames)))
+    if total > ANIM_PARTITION_SIZE:
+        print("warning: larger than the %d byte anim partition" % ANIM_PARTITION_SIZE)
+    print("flash with: esptool.py write_flash 0x%x %s" % (ANIM_PARTITION_OFFSET, args.output))
+
+    if args.bench:
+        player = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "host", "anim_play")
+        if not os.path.exists(player):
+            sys.exit("build host/anim_play first (make -C host anim_play)")
+        subprocess.run([player, args.output, "1000"], check=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,216 @@
+#!/usr/bin/env python3
+"""
+Compile the images and fixed strings listed in assets/assets.txt into const data in flash.
+
+    asset_gen.py
+    asset_gen.py --check
+
+Each line of the manifest is `name source [invert]`, where source is a file in assets/ (a PBM or PGM,
+or a PNG, which needs Pillow) or `text:<string>`, rendered in the display's 4x5 font exactly as
+display_text() would draw it. As with anim_encode.py, black is off unless the line ends in `invert`.
+Images aren't scaled, so they must be at most DISPLAY_HEIGHT pixels high.
+
+Images with only black and white, and text, become column bitmaps (a byte per column, bit n lighting
+row n); anything with greys becomes a packed frame (a PWM byte per pixel, column by column, as
+display_load_pwm() takes them). Both are written to main/assets.c, with main/include/assets.h
+naming each one and listing its size - see main/include/asset.h for drawing them with asset_blit().
+
+The firmware build runs this whenever the manifest, an asset or this script changes; --check exits
+non-zero if the checked-in files are out of date instead of writing them.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+from anim_encode import DISPLAY_HEIGHT, read_netpbm
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+MANIFEST = os.path.join(ROOT, "assets", "assets.txt")
+SOURCE = os.path.join(ROOT, "main", "assets.c")
+HEADER = os.path.join(ROOT, "main", "include", "assets.h")
+FONT = os.path.join(ROOT, "main", "include", "font_4x5.h")
+
+# As in display.h
+DISPLAY_CHAR_WIDTH = 5
+FONT_WIDTH = 4
+FONT_HEIGHT = 5
+
+NOTICE = "Generated by tools/asset_gen.py from assets/assets.txt - do not edit."
+
+
+def read_font():
+    """The 4x5 font's rows, indexed by character."""
+    with open(FONT) as f:
+        table = f.read().split("font_4x5[128][8] = {", 1)[1]
+    return [[int(v, 16) for v in row.split(",")] for row in re.findall(r"\{([^{}]*)\}", table)]
+
+
+def render_text(text, font):
+    """Render text as display_text() does, returning (pixels, width, height) with 0 for off and 255 for on."""
+    width = len(text) * DISPLAY_CHAR_WIDTH - 1
+    pixels = [0] * (width * FONT_HEIGHT)
+    for idx, char in enumerate(text):
+        rows = font[ord(char)] if ord(char) < len(font) else font[0]
+        for row in range(FONT_HEIGHT):
+            for col in range(FONT_WIDTH):
+                if rows[row] & (1 << (3 - col)):
+                    pixels[row * width + idx * DISPLAY_CHAR_WIDTH + col] = 255
+    return pixels, width, FONT_HEIGHT
+
+
+def read_image(path):
+    """Read an image as (pixels, width, height), greyscale and row by row."""
+    if path.lower().endswith((".pgm", ".pbm")):
+        return read_netpbm(path)
+
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit("Pillow is needed to read %s (pip install pillow)" % path)
+
+    image = Image.open(path).convert("L")
+    return list(image.getdata()), image.width, image.height
+
+
+def convert(name, source, invert, font):
+    """Build an asset from a manifest line, returning a dict describing it."""
+    if source.startswith("text:"):
+        pixels, width, height = render_text(source[5:], font)
+    else:
+        pixels, width, height = read_image(os.path.join(ROOT, "assets", source))
+        if invert:
+            pixels = [255 - value for value in pixels]
+
+    if height > DISPLAY_HEIGHT or width > 0xFFFF:
+        sys.exit("%s: %dx%d is too big (images aren't scaled)" % (name, width, height))
+
+    if all(value in (0, 255) for value in pixels):
+        data = bytes(
+            sum(1 << y for y in range(height) if pixels[y * width + x]) for x in range(width)
+        )
+        kind = "ASSET_COLUMNS"
+    else:
+        data = bytes(pixels[y * width + x] for x in range(width) for y in range(height))
+        kind = "ASSET_FRAME"
+
+    return {"name": name, "source": source, "kind": kind, "width": width, "height": height, "data": data}
+
+
+def read_manifest():
+    font = read_font()
+    assets = []
+    with open(MANIFEST) as f:
+        for number, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            fields = line.split(None, 1)
+            if len(fields) != 2 or not re.match(r"^[a-z][a-z0-9_]*$", fields[0]):
+                sys.exit("%s:%d: expected `name source [invert]`" % (MANIFEST, number))
+            name, source = fields
+            invert = source.endswith(" invert") and not source.startswith("text:")
+            if invert:
+                source = source[:-len(" invert")]
+            if name in (asset["name"] for asset in assets):
+                sys.exit("%s:%d: %s is listed twice" % (MANIFEST, number, name))
+            assets.append(convert(name, source, invert, font))
+    return assets
+
+
+def c_string(text):
+    return '"%s"' % text.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def generate_header(assets):
+    lines = [
+        "//",
+        "// Assets compiled into flash, by name.",
+        "// " + NOTICE,
+        "//",
+        "//     %-12s %-8s %-6s %6s  %s" % ("name", "format", "size", "bytes", "source"),
+    ]
+    for asset in assets:
+        lines.append("//     %-12s %-8s %-6s %6d  %s" % (
+            asset["name"], "frame" if asset["kind"] == "ASSET_FRAME" else "columns",
+            "%dx%d" % (asset["width"], asset["height"]), len(asset["data"]), asset["source"]
+        ))
+    lines += [
+        "//",
+        "// %d assets, %d bytes of data." % (len(assets), sum(len(asset["data"]) for asset in assets)),
+        "//",
+        "",
+        "#ifndef ASSETS_H",
+        "#define ASSETS_H",
+        "",
+        '#include "asset.h"',
+        "",
+        "typedef enum {",
+    ]
+    lines += ["    ASSET_%s," % asset["name"].upper() for asset in assets]
+    lines += [
+        "    ASSET_COUNT",
+        "} asset_id_t;",
+        "",
+        "extern const asset_t assets[ASSET_COUNT];",
+        "",
+        "#endif",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def generate_source(assets):
+    lines = ["// " + NOTICE, "", '#include "assets.h"', ""]
+    for asset in assets:
+        lines.append("// %s" % asset["source"])
+        lines.append("static const uint8_t %s_data[%d] = {" % (asset["name"], len(asset["data"])))
+        stride = asset["height"] if asset["kind"] == "ASSET_FRAME" else 12
+        for pos in range(0, len(asset["data"]), stride):
+            lines.append("    " + ", ".join("0x%02x" % value for value in asset["data"][pos:pos + stride]) + ",")
+        lines += ["};", ""]
+
+    lines.append("const asset_t assets[ASSET_COUNT] = {")
+    for asset in assets:
+        lines.append(
+            "    [ASSET_%s] = { .name = %s, .format = %s, .width = %d, .height = %d, .data = %s_data }," % (
+                asset["name"].upper(), c_string(asset["name"]), asset["kind"], asset["width"], asset["height"],
+                asset["name"]
+            )
+        )
+    lines += ["};", ""]
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--check", action="store_true", help="fail if the generated files are out of date")
+    args = parser.parse_args()
+
+    assets = read_manifest()
+    outputs = {HEADER: generate_header(assets), SOURCE: generate_source(assets)}
+
+    if args.check:
+        stale = []
+        for path, text in outputs.items():
+            if not os.path.exists(path) or open(path).read() != text:
+                stale.append(os.path.relpath(path, ROOT))
+        if stale:
+            sys.exit("out of date: %s (run tools/asset_gen.py)" % ", ".join(stale))
+        return
+
+    for path, text in outputs.items():
+        with open(path, "w") as f:
+            f.write(text)
+
+    for asset in assets:
+        print("%-12s %-8s %2dx%d %6d bytes" % (
+            asset["name"], "frame" if asset["kind"] == "ASSET_FRAME" else "columns",
+            asset["width"], asset["height"], len(asset["data"])
+        ))
+    print("%d assets, %d bytes" % (len(assets), sum(len(asset["data"]) for asset in assets)))
+
+
+if __name__ == "__main__":
+    main()
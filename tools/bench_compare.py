@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Compare two sets of benchmark results.
+
+Both inputs are captured output of the `bench` console command (or the host/bench executable).
+Any line of the form `BENCH {...}` is picked up, everything else is ignored, so raw
+console logs can be used directly.
+
+Usage: bench_compare.py baseline.txt current.txt [--threshold PERCENT]
+
+Exits non-zero if any stage's median or p99 regressed by more than the threshold, or if a stage with
+a budget (the procedural effects) has a p99 over it.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    results = {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            idx = line.find("BENCH {")
+            if idx < 0:
+                continue
+            record = json.loads(line[idx + len("BENCH "):])
+            results[record["stage"]] = record
+    return results
+
+
+def change(old, new):
+    if old == 0:
+        return 0.0
+    return (new - old) * 100.0 / old
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0, help="allowed regression in percent (default 10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    regressed = False
+
+    print("%-28s %12s %12s %8s %12s %12s %8s %10s" % (
+        "stage", "median", "was", "chg%", "p99", "was", "chg%", "wire B"))
+
+    for stage, new in current.items():
+        if new.get("budget") and new["p99"] > new["budget"]:
+            print("%-28s p99 %d over budget of %d" % (stage, new["p99"], new["budget"]))
+            regressed = True
+
+        old = baseline.get(stage)
+        if old is None:
+            print("%-28s %12d %12s %8s %12d %12s %8s %10d" % (
+                stage, new["median"], "-", "-", new["p99"], "-", "-", new["wire_bytes"]))
+            continue
+
+        if old["unit"] != new["unit"]:
+            print("%-28s unit mismatch (%s vs %s), skipped" % (stage, old["unit"], new["unit"]))
+            continue
+
+        median_chg = change(old["median"], new["median"])
+        p99_chg = change(old["p99"], new["p99"])
+        flag = ""
+        if median_chg > args.threshold or p99_chg > args.threshold:
+            flag = "  REGRESSED"
+            regressed = True
+
+        print("%-28s %12d %12d %+8.1f %12d %12d %+8.1f %10d%s" % (
+            stage, new["median"], old["median"], median_chg,
+            new["p99"], old["p99"], p99_chg, new["wire_bytes"], flag))
+
+    return 1 if regressed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
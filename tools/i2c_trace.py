@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+"""
+Decode, replay and export I2C traces captured with the `trace` console command.
+
+Capture on the device with `trace start`, reproduce the problem, then `trace dump` and save
+the console output to a file. Anything outside the TRACE BEGIN/END lines is ignored.
+
+    i2c_trace.py info dump.txt                  summary of the captured transactions
+    i2c_trace.py replay dump.txt                replay into the panel model, printing each frame
+    i2c_trace.py vcd dump.txt -o trace.vcd      export SDA/SCL waveforms for a waveform viewer
+    i2c_trace.py frames dump.txt -o frames.bin  write reconstructed frames for `host/bench display_update N frames.bin`
+
+Replay is deterministic, so the frames written by `frames` can be used as fixed benchmark inputs.
+"""
+
+import argparse
+import base64
+import collections
+import struct
+import sys
+
+from panel_model import Panel, CHIP_ADDRS, PAGE_LED_CTRL
+
+TRACE_VERSION = 1
+TRACE_FLAG_NACK = 0x01
+
+# Matches trace_record_t in main/include/trace.h
+RECORD = struct.Struct("<IBBBBHH")
+
+Record = collections.namedtuple("Record", "timestamp_us addr reg nack_at payload")
+
+
+def load(path):
+    """Parse a console capture into a list of Records."""
+    data = bytearray()
+    inside = False
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("TRACE BEGIN"):
+                fields = dict(kv.split("=") for kv in line.split()[2:])
+                if int(fields["version"]) != TRACE_VERSION:
+                    sys.exit("unsupported trace version %s" % fields["version"])
+                data = bytearray()
+                inside = True
+            elif line.startswith("TRACE END"):
+                inside = False
+            elif inside and line:
+                data += base64.b64decode(line)
+
+    records = []
+    pos = 0
+    while pos + RECORD.size <= len(data):
+        timestamp_us, addr, reg, flags, _, length, nack_at = RECORD.unpack_from(data, pos)
+        pos += RECORD.size
+        payload = bytes(data[pos:pos + length])
+        pos += length
+        records.append(Record(timestamp_us, addr, reg, nack_at if flags & TRACE_FLAG_NACK else None, payload))
+
+    return records
+
+
+def replay(records, on_frame=None):
+    """
+    Replay records into a Panel. A frame is complete once the last chip's LED on/off
+    registers have been written, as display_update() does them last.
+    """
+    panel = Panel()
+    frames = 0
+    for record in records:
+        if record.nack_at is not None:
+            continue
+        panel.write(record.addr, record.reg, record.payload)
+        chip = panel.chips.get(record.addr)
+        if record.addr == CHIP_ADDRS[-1] and chip.page == PAGE_LED_CTRL and record.reg == 0:
+            frames += 1
+            if on_frame:
+                on_frame(panel, record)
+    return panel, frames
+
+
+def cmd_info(args):
+    records = load(args.trace)
+    if not records:
+        print("no records")
+        return
+
+    per_addr = collections.Counter(r.addr for r in records)
+    nacks = collections.Counter(r.addr for r in records if r.nack_at is not None)
+    wire = sum(2 + len(r.payload) for r in records)
+    span = (records[-1].timestamp_us - records[0].timestamp_us) & 0xFFFFFFFF
+
+    print("records:  %d over %.3f ms" % (len(records), span / 1000.0))
+    print("wire:     %d bytes" % wire)
+    for addr in sorted(per_addr):
+        print("  0x%02x: %5d transactions, %d NACKed" % (addr, per_addr[addr], nacks[addr]))
+
+    _, frames = replay(records)
+    print("frames:   %d" % frames)
+
+
+def cmd_replay(args):
+    def show(panel, record):
+        print("@%u us" % record.timestamp_us)
+        print(panel.render())
+        print()
+
+    panel, frames = replay(load(args.trace), show)
+    for addr, chip in panel.chips.items():
+        if chip.unknown_page_writes:
+            print("0x%02x: %d writes before the first page select were ignored" % (addr, chip.unknown_page_writes))
+    print("%d frames" % frames)
+
+
+def cmd_frames(args):
+    out = bytearray()
+    _, frames = replay(load(args.trace), lambda panel, record: out.extend(panel.frame()))
+    with open(args.output, "wb") as f:
+        f.write(out)
+    print("wrote %d frames to %s" % (frames, args.output))
+
+
+class Vcd:
+    """Minimal VCD writer for the SCL/SDA lines plus the byte being transferred."""
+
+    def __init__(self, f):
+        self.f = f
+        self.time = 0
+        self.values = {}
+        f.write("$timescale 1ns $end\n$scope module i2c $end\n")
+        f.write("$var wire 1 c scl $end\n$var wire 1 d sda $end\n")
+        f.write("$var wire 1 n nack $end\n$var wire 8 b byte $end\n")
+        f.write("$upscope $end\n$enddefinitions $end\n")
+        self.at(0)
+        self.set("c", 1)
+        self.set("d", 1)
+        self.set("n", 0)
+        self.set("b", None)
+
+    def at(self, time):
+        self.time = max(time, self.time)
+        self.f.write("#%d\n" % self.time)
+
+    def advance(self, ns):
+        self.at(self.time + ns)
+
+    def set(self, var, value):
+        if self.values.get(var, -1) == value:
+            return
+        self.values[var] = value
+        if var == "b":
+            self.f.write(("bx b\n" if value is None else "b{:08b} b\n".format(value)))
+        else:
+            self.f.write("%d%s\n" % (value, var))
+
+
+def cmd_vcd(args):
+    records = load(args.trace)
+    quarter = args.bit_ns // 4
+
+    with open(args.output, "w") as f:
+        vcd = Vcd(f)
+        base = records[0].timestamp_us if records else 0
+
+        for record in records:
+            vcd.at(((record.timestamp_us - base) & 0xFFFFFFFF) * 1000)
+
+            # Start: SDA falls while SCL is high
+            vcd.set("d", 0)
+            vcd.advance(quarter)
+            vcd.set("c", 0)
+
+            wire = bytes([record.addr << 1, record.reg]) + record.payload
+            # Sequential writes stop at the first NACK, single register writes always send all three bytes
+            if record.nack_at is not None and len(record.payload) > 1:
+                wire = wire[:record.nack_at + 1]
+
+            for idx, value in enumerate(wire):
+                vcd.set("b", value)
+                for bit in range(7, -1, -1):
+                    vcd.advance(quarter)
+                    vcd.set("d", (value >> bit) & 1)
+                    vcd.advance(quarter)
+                    vcd.set("c", 1)
+                    vcd.advance(2 * quarter)
+                    vcd.set("c", 0)
+
+                # Acknowledge clock: the chip pulls SDA low to ACK
+                nacked = record.nack_at == idx
+                vcd.advance(quarter)
+                vcd.set("d", 1 if nacked else 0)
+                vcd.set("n", 1 if nacked else 0)
+                vcd.advance(quarter)
+                vcd.set("c", 1)
+                vcd.advance(2 * quarter)
+                vcd.set("c", 0)
+
+            # Stop: SDA rises while SCL is high
+            vcd.advance(quarter)
+            vcd.set("d", 0)
+            vcd.set("b", None)
+            vcd.advance(quarter)
+            vcd.set("c", 1)
+            vcd.advance(quarter)
+            vcd.set("d", 1)
+            vcd.set("n", 0)
+
+    print("wrote %d transactions to %s" % (len(records), args.output))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    p = sub.add_parser("info", help="summarise a trace")
+    p.add_argument("trace")
+    p.set_defaults(func=cmd_info)
+
+    p = sub.add_parser("replay", help="replay a trace into the panel model")
+    p.add_argument("trace")
+    p.set_defaults(func=cmd_replay)
+
+    p = sub.add_parser("frames", help="write the reconstructed frames as packed PWM bytes")
+    p.add_argument("trace")
+    p.add_argument("-o", "--output", required=True)
+    p.set_defaults(func=cmd_frames)
+
+    p = sub.add_parser("vcd", help="export the trace as a VCD waveform")
+    p.add_argument("trace")
+    p.add_argument("-o", "--output", required=True)
+    p.add_argument("--bit-ns", type=int, default=1000, help="duration of one bit on the bus (default 1000)")
+    p.set_defaults(func=cmd_vcd)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
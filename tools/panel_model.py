@@ -0,0 +1,95 @@
+"""
+A register-level model of the TXLED panel: three IS32 chips on one I2C bus.
+
+Feed it the writes seen on the bus and it tracks each chip's page selection and
+register contents, and can reconstruct what the 24x6 display is showing.
+The pixel mapping mirrors display_update() in main/display.c.
+"""
+
+DISPLAY_WIDTH = 24
+DISPLAY_HEIGHT = 6
+DISPLAY_PIXELS = DISPLAY_WIDTH * DISPLAY_HEIGHT
+IS32_WIDTH = 8
+
+# 7-bit addresses of the chips, in display order (see chip_addrs[] in display.c)
+CHIP_ADDRS = [0x50, 0x5F, 0x5A]
+
+REG_PAGE = 0xFD
+REG_UNLOCK = 0xFE
+MAGIC_UNLOCK = 0xC5
+
+PAGE_LED_CTRL = 0
+PAGE_PWM = 1
+PAGE_FUNC = 3
+
+REG_CONFIG = 0x00
+REG_GCR = 0x01
+CONFIG_SSD_RUN = 0x01
+
+
+class Chip:
+    def __init__(self):
+        self.page = None
+        self.unlocked = False
+        self.pages = [bytearray(256) for _ in range(4)]
+        self.unknown_page_writes = 0
+
+    def write(self, reg, payload):
+        if reg == REG_UNLOCK:
+            self.unlocked = payload[:1] == bytes([MAGIC_UNLOCK])
+            return
+        if reg == REG_PAGE:
+            if self.unlocked and payload:
+                self.page = payload[0] & 0x03
+            self.unlocked = False
+            return
+        if self.page is None:
+            # Capture started after the page was selected (the driver caches it)
+            self.unknown_page_writes += 1
+            return
+        for offset, value in enumerate(payload):
+            self.pages[self.page][(reg + offset) & 0xFF] = value
+
+    @property
+    def running(self):
+        return bool(self.pages[PAGE_FUNC][REG_CONFIG] & CONFIG_SSD_RUN)
+
+    @property
+    def gcr(self):
+        return self.pages[PAGE_FUNC][REG_GCR]
+
+
+class Panel:
+    def __init__(self):
+        self.chips = {addr: Chip() for addr in CHIP_ADDRS}
+
+    def write(self, addr, reg, payload):
+        """Apply a write; returns False if no chip on the panel has this address."""
+        chip = self.chips.get(addr)
+        if chip is None:
+            return False
+        chip.write(reg, payload)
+        return True
+
+    def pixel(self, x, y):
+        """PWM value shown at display position (x, y), 0 if the LED is off or its chip is shut down."""
+        col = DISPLAY_WIDTH - 1 - x
+        chip = self.chips[CHIP_ADDRS[col // IS32_WIDTH]]
+        chip_col = col % IS32_WIDTH
+        if not chip.running:
+            return 0
+        on_off = chip.pages[PAGE_LED_CTRL][(chip_col // 4) + (y * 4)]
+        if not on_off & (0b11 << ((chip_col % 4) * 2)):
+            return 0
+        return chip.pages[PAGE_PWM][(chip_col * 2) + (y * 32)]
+
+    def frame(self):
+        """The current display contents as packed PWM bytes (see display_load_pwm())."""
+        return bytes(self.pixel(x, y) for x in range(DISPLAY_WIDTH) for y in range(DISPLAY_HEIGHT))
+
+    def render(self):
+        """The current display contents as ASCII art."""
+        return "\n".join(
+            "".join("#" if self.pixel(x, y) > 0x80 else "+" if self.pixel(x, y) else "." for x in range(DISPLAY_WIDTH))
+            for y in range(DISPLAY_HEIGHT)
+        )
@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""
+Send frames to the panel using the binary serial protocol, and benchmark throughput and latency.
+
+    serial_send.py /dev/ttyUSB0 --enter               switch the console into binary mode, then send
+    serial_send.py /dev/pts/5 --frames 2000            against host/serial_rx (a pty stand-in)
+    serial_send.py /dev/ttyUSB0 --enter --region 8x6 --window 4
+
+With --window 1 every packet waits for its ACK, giving the round-trip latency of a frame.
+Larger windows keep several packets in flight to measure throughput.
+The packet format is described in main/include/serial_proto.h.
+"""
+
+import argparse
+import collections
+import os
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+
+DISPLAY_WIDTH = 24
+DISPLAY_HEIGHT = 6
+DISPLAY_PIXELS = DISPLAY_WIDTH * DISPLAY_HEIGHT
+
+SYNC = b"\xA5\x5A"
+SERIAL_FRAME = 1
+SERIAL_REGION = 2
+SERIAL_PING = 3
+SERIAL_EXIT = 4
+ACK = 0x06
+NAK = 0x15
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def packet(kind, payload=b""):
+    body = struct.pack("<BH", kind, len(payload)) + payload
+    return SYNC + body + struct.pack("<H", crc16(body))
+
+
+def frame_payload(step):
+    frame = bytearray(DISPLAY_PIXELS)
+    for x in range(DISPLAY_WIDTH):
+        if (x + step) % 6 < 2:
+            for y in range(DISPLAY_HEIGHT):
+                frame[x * DISPLAY_HEIGHT + y] = 0xFF
+    return bytes(frame)
+
+
+def region_payload(step, width, height):
+    x = step % (DISPLAY_WIDTH - width + 1)
+    pixels = bytes(((step + idx) * 37) & 0xFF for idx in range(width * height))
+    return bytes([x, 0, width, height]) + pixels
+
+
+BAUDS = {int(name[1:]): getattr(termios, name) for name in dir(termios) if name.startswith("B") and name[1:].isdigit()}
+
+
+def set_baud(fd, baud):
+    attrs = termios.tcgetattr(fd)
+    attrs[4] = attrs[5] = BAUDS[baud]
+    termios.tcsetattr(fd, termios.TCSADRAIN, attrs)
+
+
+def read_reply(fd, timeout):
+    ready, _, _ = select.select([fd], [], [], timeout)
+    if not ready:
+        return None
+    try:
+        data = os.read(fd, 1)
+    except OSError:
+        # The pty stand-in closes its side after SERIAL_EXIT
+        return None
+    return data[0] if data else None
+
+
+def enter_binary_mode(fd, console_baud, baud):
+    """Ask the console to switch to binary mode, then follow it to the new baud rate."""
+    set_baud(fd, console_baud)
+    os.write(fd, b"\r")
+    time.sleep(0.1)
+    termios.tcflush(fd, termios.TCIFLUSH)
+    os.write(fd, ("binmode %d\r" % baud).encode())
+
+    seen = b""
+    deadline = time.time() + 2
+    while b"binary mode" not in seen:
+        ready, _, _ = select.select([fd], [], [], max(0, deadline - time.time()))
+        if not ready:
+            sys.exit("device didn't acknowledge binmode")
+        seen += os.read(fd, 256)
+
+    termios.tcdrain(fd)
+    time.sleep(0.05)
+    set_baud(fd, baud)
+    termios.tcflush(fd, termios.TCIFLUSH)
+
+
+def percentile(values, percent):
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, (len(ordered) * percent + 99) // 100 - 1)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("device")
+    parser.add_argument("--baud", type=int, default=921600, help="binary mode baud rate (default 921600)")
+    parser.add_argument("--console-baud", type=int, default=115200)
+    parser.add_argument("--enter", action="store_true", help="send the binmode command first")
+    parser.add_argument("--frames", type=int, default=500)
+    parser.add_argument("--region", help="send WxH region packets instead of full frames")
+    parser.add_argument("--window", type=int, default=1, help="packets in flight before waiting for an ACK")
+    parser.add_argument("--no-exit", action="store_true", help="leave the device in binary mode")
+    args = parser.parse_args()
+
+    fd = os.open(args.device, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+
+    if args.enter:
+        enter_binary_mode(fd, args.console_baud, args.baud)
+    elif args.baud in BAUDS:
+        set_baud(fd, args.baud)
+
+    if args.region:
+        width, height = (int(v) for v in args.region.lower().split("x"))
+        make = lambda step: packet(SERIAL_REGION, region_payload(step, width, height))
+    else:
+        make = lambda step: packet(SERIAL_FRAME, frame_payload(step))
+
+    in_flight = collections.deque()
+    latencies = []
+    naks = lost = sent_bytes = 0
+
+    def collect():
+        nonlocal naks, lost
+        reply = read_reply(fd, 1.0)
+        sent_at = in_flight.popleft()
+        if reply is None:
+            lost += 1
+            return
+        latencies.append(time.perf_counter() - sent_at)
+        if reply != ACK:
+            naks += 1
+
+    start = time.perf_counter()
+    for step in range(args.frames):
+        data = make(step)
+        while len(in_flight) >= args.window:
+            collect()
+        in_flight.append(time.perf_counter())
+        os.write(fd, data)
+        sent_bytes += len(data)
+    while in_flight:
+        collect()
+    elapsed = time.perf_counter() - start
+
+    if not args.no_exit:
+        os.write(fd, packet(SERIAL_EXIT))
+        read_reply(fd, 1.0)
+
+    print("%d packets, %d bytes in %.3fs: %.1f packets/s, %.1f KB/s" % (
+        args.frames, sent_bytes, elapsed, args.frames / elapsed, sent_bytes / elapsed / 1024))
+    if latencies:
+        print("ack latency: median %.3f ms, p99 %.3f ms, max %.3f ms" % (
+            percentile(latencies, 50) * 1000, percentile(latencies, 99) * 1000, max(latencies) * 1000))
+    print("%d NAKed, %d unanswered" % (naks, lost))
+    return 1 if naks or lost else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""
+Stream frames to one or more panels over UDP, and generate load for testing the receiver.
+
+    stream_send.py 192.168.1.50 --fps 30
+    stream_send.py 127.0.0.1:7000 127.0.0.1:7001 --fps 60 --seconds 20 --loss 0.02 --reorder 0.05
+
+Against the host receiver (`make -C host stream_rx && host/stream_rx 7000 10`) this exercises the
+firmware's decoder and jitter buffer over loopback. The packet format is described in main/include/stream.h.
+"""
+
+import argparse
+import math
+import random
+import socket
+import struct
+import sys
+import time
+
+DISPLAY_WIDTH = 24
+DISPLAY_HEIGHT = 6
+DISPLAY_PIXELS = DISPLAY_WIDTH * DISPLAY_HEIGHT
+
+STREAM_VERSION = 2
+STREAM_FULL = 1
+STREAM_DELTA = 2
+
+# Changed pixels this close together are sent as one run, as a run header costs two bytes
+RUN_MERGE_GAP = 2
+
+
+def packet(kind, epoch, seq, payload):
+    return b"TX" + struct.pack("<BBHHI", STREAM_VERSION, kind, seq & 0xFFFF, len(payload), epoch) + payload
+
+
+def delta_payload(previous, frame):
+    """Encode the changes from `previous` to `frame` as (index, count, pwm...) runs."""
+    changed = [idx for idx in range(DISPLAY_PIXELS) if previous[idx] != frame[idx]]
+    runs = []
+    for idx in changed:
+        if runs and idx - (runs[-1][0] + runs[-1][1]) <= RUN_MERGE_GAP and runs[-1][1] + (idx - runs[-1][0] - runs[-1][1]) < 255:
+            start = runs[-1][0]
+            runs[-1] = (start, idx - start + 1)
+        else:
+            runs.append((idx, 1))
+    out = bytearray()
+    for start, count in runs:
+        out += bytes([start, count]) + frame[start:start + count]
+    return bytes(out)
+
+
+def pattern_scroll(step):
+    frame = bytearray(DISPLAY_PIXELS)
+    for x in range(DISPLAY_WIDTH):
+        if (x + step) % 8 < 3:
+            for y in range(DISPLAY_HEIGHT):
+                frame[x * DISPLAY_HEIGHT + y] = 0xFF
+    return bytes(frame)
+
+
+def pattern_wave(step):
+    frame = bytearray(DISPLAY_PIXELS)
+    for x in range(DISPLAY_WIDTH):
+        height = int((math.sin((x + step) / 3.0) + 1) * DISPLAY_HEIGHT / 2)
+        for y in range(DISPLAY_HEIGHT):
+            frame[x * DISPLAY_HEIGHT + y] = 0xFF if DISPLAY_HEIGHT - 1 - y < height else 0
+    return bytes(frame)
+
+
+def pattern_noise(step):
+    return bytes(random.choice((0, 0, 0x40, 0xFF)) for _ in range(DISPLAY_PIXELS))
+
+
+PATTERNS = {"scroll": pattern_scroll, "wave": pattern_wave, "noise": pattern_noise}
+
+
+def parse_target(text, default_port):
+    host, _, port = text.partition(":")
+    return (host, int(port) if port else default_port)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("targets", nargs="+", help="host[:port] of each panel")
+    parser.add_argument("--port", type=int, default=7000, help="default port (default 7000)")
+    parser.add_argument("--fps", type=float, default=30.0)
+    parser.add_argument("--seconds", type=float, default=10.0)
+    parser.add_argument("--pattern", choices=sorted(PATTERNS), default="scroll")
+    parser.add_argument("--keyframe", type=int, default=30, help="send a full frame every N frames (default 30)")
+    parser.add_argument("--loss", type=float, default=0.0, help="probability of dropping a packet")
+    parser.add_argument("--reorder", type=float, default=0.0, help="probability of swapping a packet with the next")
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    # Different on every run, whatever the seed, so a receiver can tell the sender has restarted
+    epoch = random.SystemRandom().getrandbits(32)
+    random.seed(args.seed)
+    targets = [parse_target(t, args.port) for t in args.targets]
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    render = PATTERNS[args.pattern]
+
+    period = 1.0 / args.fps
+    frames = int(args.seconds * args.fps)
+    previous = None
+    held = None
+    sent = dropped = full = payload_bytes = 0
+    worst_late = 0.0
+
+    start = time.perf_counter()
+    for seq in range(frames):
+        due = start + seq * period
+        now = time.perf_counter()
+        if due > now:
+            time.sleep(due - now)
+        worst_late = max(worst_late, time.perf_counter() - due)
+
+        frame = render(seq)
+        if previous is None or seq % args.keyframe == 0:
+            data = packet(STREAM_FULL, epoch, seq, frame)
+            full += 1
+        else:
+            data = packet(STREAM_DELTA, epoch, seq, delta_payload(previous, frame))
+        previous = frame
+        payload_bytes += len(data)
+
+        if random.random() < args.loss:
+            dropped += 1
+            continue
+
+        # Hold a packet back to send after the next one
+        if held is None and random.random() < args.reorder:
+            held = data
+            continue
+
+        for target in targets:
+            sock.sendto(data, target)
+            if held is not None:
+                sock.sendto(held, target)
+        held = None
+        sent += 1
+
+    elapsed = time.perf_counter() - start
+    print("sent %d frames (%d full) to %d target(s) in %.2fs: %.1f fps, %.1f bytes/frame, %d dropped, worst send lateness %.1f ms" % (
+        frames, full, len(targets), elapsed, frames / elapsed, payload_bytes / max(frames, 1), dropped, worst_late * 1000))
+
+
+if __name__ == "__main__":
+    sys.exit(main())